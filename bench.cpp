@@ -0,0 +1,421 @@
+#ifndef BENCH_CPP
+#define BENCH_CPP
+
+// NOTE - Scripted runs, for measuring the engine without anyone at the controls.
+// The simulation advances by exactly one fixed step per frame whatever the frame
+// took, so every run renders the same frames. Frame times are wall clock, from
+// the start of a frame to the end of its SwapBuffers.
+// Without a script (--headless alone), the camera does one turn around the scene.
+// A script (--bench) is a timeline of keyframes, interpolated linearly :
+// {
+//     "keyframes" : [
+//         { "fTime" : 0.0, "sSection" : "Harbor", "vCameraPosition" : [30, 20, 30], "vCameraTarget" : [0, 0, 0],
+//           "fBeaufort" : 1.0, "fDayPhase" : 0.5 },
+//         { "fTime" : 10.0, "vCameraPosition" : [-30, 10, 30] },
+//         ...
+//     ]
+// }
+// Missing values are held from the previous keyframe. fBeaufort is WaterState +
+// WaterStateInterp, fDayPhase is in radians (0 = noon). A keyframe with a sSection
+// starts a new section, the report has the frame time percentiles of each.
+#define BENCH_WARMUP_FRAMES 30      // Shader compilation, first uploads : not counted
+#define BENCH_DEFAULT_FRAMES 600
+#define BENCH_MAX_SECTIONS 32
+#define BENCH_SECTION_NAME_LENGTH 32
+
+struct bench_keyframe
+{
+    real32 Time;
+    vec3f CameraPosition;
+    vec3f CameraTarget;
+    real32 Beaufort;
+    real32 DayPhase;
+};
+
+struct bench_section
+{
+    char Name[BENCH_SECTION_NAME_LENGTH];
+    real32 StartTime;
+    uint32 FirstFrame;
+    uint32 FrameCount;
+};
+
+struct bench_run
+{
+    uint32 FrameCount;
+    uint32 FrameIndex;
+    real32 *FrameTimes;     // In ms
+    real64 FrameStart;
+    real64 RunStart;
+    real64 StepTime;
+
+    bench_keyframe *Keyframes;  // NULL for the default camera path
+    uint32 KeyframeCount;
+    uint32 CurrentKeyframe;
+    bool HasWater;
+    bool HasDayPhase;
+
+    bench_section Sections[BENCH_MAX_SECTIONS];
+    uint32 SectionCount;
+    uint32 CurrentSection;
+
+    path SummaryPath;
+    path CSVPath;
+    bool IsActive;
+};
+
+static vec3f BenchReadVec3(cJSON *Object, char const *Name, vec3f Default)
+{
+    cJSON *Array = cJSON_GetObjectItem(Object, Name);
+    if(!Array || cJSON_GetArraySize(Array) != 3)
+    {
+        return Default;
+    }
+    return vec3f((real32)cJSON_GetArrayItem(Array, 0)->valuedouble,
+                 (real32)cJSON_GetArrayItem(Array, 1)->valuedouble,
+                 (real32)cJSON_GetArrayItem(Array, 2)->valuedouble);
+}
+
+static real32 BenchReadReal(cJSON *Object, char const *Name, real32 Default, bool *Found = NULL)
+{
+    cJSON *Item = cJSON_GetObjectItem(Object, Name);
+    if(Found && Item)
+    {
+        *Found = true;
+    }
+    return Item ? (real32)Item->valuedouble : Default;
+}
+
+static void BenchAddSection(bench_run *Bench, char const *Name, real32 StartTime)
+{
+    if(Bench->SectionCount < BENCH_MAX_SECTIONS)
+    {
+        bench_section *Section = &Bench->Sections[Bench->SectionCount++];
+        strncpy(Section->Name, Name, BENCH_SECTION_NAME_LENGTH - 1);
+        Section->StartTime = StartTime;
+    }
+    else
+    {
+        printf("Bench : more than %d sections, %s is merged in the previous one.\n", BENCH_MAX_SECTIONS, Name);
+    }
+}
+
+static bool LoadBenchScript(bench_run *Bench, game_memory *Memory, char const *ScriptName)
+{
+    path ScriptPath;
+    MakeRelativePath(ScriptPath, ExecutableFullPath, ScriptName);
+
+    void *Content = ReadFileContents(&Memory->ScratchArena, ScriptPath, 0);
+    if(!Content)
+    {
+        printf("Bench : can't read %s.\n", ScriptPath);
+        return false;
+    }
+
+    cJSON *Root = cJSON_Parse((char*)Content);
+    cJSON *Keyframes = Root ? cJSON_GetObjectItem(Root, "keyframes") : NULL;
+    int KeyframeCount = Keyframes ? cJSON_GetArraySize(Keyframes) : 0;
+    if(KeyframeCount <= 0)
+    {
+        printf("Bench : no keyframes in %s.\n", ScriptPath);
+        if(Root) cJSON_Delete(Root);
+        return false;
+    }
+
+    Bench->Keyframes = (bench_keyframe*)PushArenaData(&Memory->SessionArena, KeyframeCount * sizeof(bench_keyframe));
+    Bench->KeyframeCount = KeyframeCount;
+
+    bench_keyframe Previous = {};
+    Previous.CameraPosition = Memory->Config.CameraPosition;
+    Previous.CameraTarget = Memory->Config.CameraTarget;
+    Previous.Beaufort = 1.f;
+
+    bool Valid = true;
+    for(int i = 0; i < KeyframeCount && Valid; ++i)
+    {
+        cJSON *Item = cJSON_GetArrayItem(Keyframes, i);
+        bench_keyframe *Key = &Bench->Keyframes[i];
+
+        Key->Time = BenchReadReal(Item, "fTime", Previous.Time);
+        Key->CameraPosition = BenchReadVec3(Item, "vCameraPosition", Previous.CameraPosition);
+        Key->CameraTarget = BenchReadVec3(Item, "vCameraTarget", Previous.CameraTarget);
+        Key->Beaufort = BenchReadReal(Item, "fBeaufort", Previous.Beaufort, &Bench->HasWater);
+        Key->DayPhase = BenchReadReal(Item, "fDayPhase", Previous.DayPhase, &Bench->HasDayPhase);
+
+        if(i > 0 && Key->Time < Previous.Time)
+        {
+            printf("Bench : keyframe %d goes back in time.\n", i);
+            Valid = false;
+        }
+
+        cJSON *Section = cJSON_GetObjectItem(Item, "sSection");
+        if(Section && Section->type == cJSON_String)
+        {
+            BenchAddSection(Bench, Section->valuestring, Key->Time);
+        }
+        else if(i == 0)
+        {
+            BenchAddSection(Bench, "Default", 0.f);
+        }
+
+        Previous = *Key;
+    }
+
+    cJSON_Delete(Root);
+    return Valid;
+}
+
+// NOTE - Paths are relative to the executable. IsActive stays false if the script is unusable.
+void InitBenchRun(bench_run *Bench, game_memory *Memory, char const *ScriptPath, uint32 FrameCount,
+                  char const *SummaryPath, char const *CSVPath)
+{
+    memset(Bench, 0, sizeof(bench_run));
+    Bench->StepTime = 1.0 / (real64)Max(Memory->Config.SimulationHz, 1);
+
+    if(ScriptPath)
+    {
+        if(!LoadBenchScript(Bench, Memory, ScriptPath))
+        {
+            return;
+        }
+
+        real64 Duration = Bench->Keyframes[Bench->KeyframeCount - 1].Time;
+        Bench->FrameCount = (uint32)ceil(Duration / Bench->StepTime) + 1;
+    }
+    else
+    {
+        Bench->FrameCount = FrameCount ? FrameCount : BENCH_DEFAULT_FRAMES;
+        BenchAddSection(Bench, "Orbit", 0.f);
+    }
+
+    Bench->FrameTimes = (real32*)PushArenaData(&Memory->SessionArena, Bench->FrameCount * sizeof(real32));
+    MakeRelativePath(Bench->SummaryPath, ExecutableFullPath, SummaryPath);
+    if(CSVPath)
+    {
+        MakeRelativePath(Bench->CSVPath, ExecutableFullPath, CSVPath);
+    }
+    Bench->RunStart = PlatformGetWallClock();
+    Bench->IsActive = true;
+
+    printf("Bench : %u frames in %u sections, summary in %s.\n", Bench->FrameCount, Bench->SectionCount, Bench->SummaryPath);
+}
+
+// NOTE - Default path : one turn around the scene over the whole run, bobbing up and down
+static void BenchCameraPath(bench_run *Bench, game_input *Input)
+{
+    real32 t = Bench->FrameIndex / (real32)Bench->FrameCount;
+    real32 Angle = 2.f * M_PI * t;
+    real32 Radius = 35.f;
+
+    Input->CameraOverride = true;
+    Input->CameraPosition = vec3f(Radius * cosf(Angle), 15.f + 5.f * sinf(3.f * Angle), Radius * sinf(Angle));
+    Input->CameraTarget = vec3f(0.f, 5.f, 0.f);
+}
+
+static void BenchScriptPath(bench_run *Bench, game_input *Input)
+{
+    real32 Time = (real32)(Bench->FrameIndex * Bench->StepTime);
+
+    // NOTE - Time only goes forward, so does the keyframe cursor
+    while(Bench->CurrentKeyframe + 1 < Bench->KeyframeCount &&
+          Bench->Keyframes[Bench->CurrentKeyframe + 1].Time <= Time)
+    {
+        ++Bench->CurrentKeyframe;
+    }
+
+    bench_keyframe *A = &Bench->Keyframes[Bench->CurrentKeyframe];
+    bench_keyframe *B = &Bench->Keyframes[Min(Bench->CurrentKeyframe + 1, Bench->KeyframeCount - 1)];
+    real32 t = (B->Time > A->Time) ? Clamp((Time - A->Time) / (B->Time - A->Time), 0.f, 1.f) : 0.f;
+
+    Input->CameraOverride = true;
+    Input->CameraPosition = Mix(A->CameraPosition, B->CameraPosition, t);
+    Input->CameraTarget = Mix(A->CameraTarget, B->CameraTarget, t);
+
+    if(Bench->HasWater)
+    {
+        real32 MaxBeaufort = (real32)(water_system::BeaufortStateCount - 1);
+        real32 Beaufort = Clamp(Mix(A->Beaufort, B->Beaufort, t), 0.f, MaxBeaufort);
+        int32 WaterState = Min((int32)Beaufort, water_system::BeaufortStateCount - 2);
+
+        Input->WaterOverride = true;
+        Input->WaterState = WaterState;
+        Input->WaterStateInterp = Beaufort - WaterState;
+    }
+
+    if(Bench->HasDayPhase)
+    {
+        Input->DayPhaseOverride = true;
+        Input->DayPhase = Mix(A->DayPhase, B->DayPhase, t);
+    }
+}
+
+// NOTE - Before AdvanceFixedTimestep : replaces the frame time with one fixed step
+void BeginBenchFrame(bench_run *Bench, game_input *Input)
+{
+    Bench->FrameStart = PlatformGetWallClock();
+    Input->dTime = Bench->StepTime;
+
+    real32 Time = (real32)(Bench->FrameIndex * Bench->StepTime);
+    while(Bench->CurrentSection + 1 < Bench->SectionCount &&
+          Bench->Sections[Bench->CurrentSection + 1].StartTime <= Time)
+    {
+        ++Bench->CurrentSection;
+        Bench->Sections[Bench->CurrentSection].FirstFrame = Bench->FrameIndex;
+    }
+
+    if(Bench->Keyframes)
+    {
+        BenchScriptPath(Bench, Input);
+    }
+    else
+    {
+        BenchCameraPath(Bench, Input);
+    }
+}
+
+// NOTE - After SwapBuffers. Returns false once all the frames are done.
+bool EndBenchFrame(bench_run *Bench)
+{
+    Bench->FrameTimes[Bench->FrameIndex] = (real32)(1000.0 * (PlatformGetWallClock() - Bench->FrameStart));
+    Bench->Sections[Bench->CurrentSection].FrameCount++;
+    return ++Bench->FrameIndex < Bench->FrameCount;
+}
+
+static int CompareReal32(void const *A, void const *B)
+{
+    real32 a = *(real32 const*)A, b = *(real32 const*)B;
+    return (a > b) - (a < b);
+}
+
+// NOTE - Nearest rank, on sorted values
+static real32 Percentile(real32 *Sorted, uint32 Count, real32 P)
+{
+    uint32 Rank = (uint32)ceilf(P * Count);
+    return Sorted[Clamp(Rank, 1u, Count) - 1];
+}
+
+struct bench_stats
+{
+    uint32 Count;
+    real32 Mean, StdDev, Min, Max;
+    real32 P50, P95, P99;
+};
+
+// NOTE - Sorts Values
+static bench_stats ComputeBenchStats(real32 *Values, uint32 Count)
+{
+    bench_stats Stats = {};
+    Stats.Count = Count;
+    if(!Count)
+    {
+        return Stats;
+    }
+
+    qsort(Values, Count, sizeof(real32), CompareReal32);
+
+    real64 Sum = 0.0, SumSq = 0.0;
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        Sum += Values[i];
+        SumSq += (real64)Values[i] * Values[i];
+    }
+    real64 Mean = Sum / Count;
+    Stats.Mean = (real32)Mean;
+    Stats.StdDev = (real32)sqrt(Max(SumSq / Count - Mean * Mean, 0.0));
+    Stats.Min = Values[0];
+    Stats.Max = Values[Count - 1];
+    Stats.P50 = Percentile(Values, Count, 0.50f);
+    Stats.P95 = Percentile(Values, Count, 0.95f);
+    Stats.P99 = Percentile(Values, Count, 0.99f);
+    return Stats;
+}
+
+// NOTE - Stats of the frames [First, First + Count), minus the warmup ones
+static bench_stats ComputeBenchRangeStats(bench_run *Bench, memory_arena *Arena, uint32 First, uint32 Count, uint32 Warmup)
+{
+    uint32 Start = Max(First, Warmup);
+    uint32 End = Max(First + Count, Start);
+
+    real32 *Sorted = (real32*)PushArenaData(Arena, Max(End - Start, 1u) * sizeof(real32));
+    memcpy(Sorted, Bench->FrameTimes + Start, (End - Start) * sizeof(real32));
+    return ComputeBenchStats(Sorted, End - Start);
+}
+
+static void WriteBenchStats(FILE *fp, char const *Name, bench_stats *Stats)
+{
+    fprintf(fp, "\"%s\":{\"count\":%u,\"mean\":%.4f,\"stddev\":%.4f,\"min\":%.4f,\"max\":%.4f,"
+                "\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f}",
+            Name, Stats->Count, Stats->Mean, Stats->StdDev, Stats->Min, Stats->Max, Stats->P50, Stats->P95, Stats->P99);
+}
+
+static bool WriteBenchCSV(bench_run *Bench)
+{
+    FILE *fp = fopen(Bench->CSVPath, "w");
+    if(!fp)
+    {
+        printf("Bench : can't open %s for writing.\n", Bench->CSVPath);
+        return false;
+    }
+
+    fprintf(fp, "frame,time_s,section,frame_ms\n");
+    for(uint32 s = 0; s < Bench->SectionCount; ++s)
+    {
+        bench_section *Section = &Bench->Sections[s];
+        for(uint32 f = Section->FirstFrame; f < Section->FirstFrame + Section->FrameCount; ++f)
+        {
+            fprintf(fp, "%u,%.4f,%s,%.4f\n", f, f * Bench->StepTime, Section->Name, Bench->FrameTimes[f]);
+        }
+    }
+
+    bool Valid = !ferror(fp);
+    fclose(fp);
+    return Valid;
+}
+
+// NOTE - Needs the GL context, for the renderer name
+bool WriteBenchSummary(bench_run *Bench, game_memory *Memory)
+{
+    uint32 Warmup = Min((uint32)BENCH_WARMUP_FRAMES, Bench->FrameIndex / 2);
+    bench_stats Stats = ComputeBenchRangeStats(Bench, &Memory->ScratchArena, 0, Bench->FrameIndex, Warmup);
+
+    FILE *fp = fopen(Bench->SummaryPath, "w");
+    if(!fp)
+    {
+        printf("Bench : can't open %s for writing.\n", Bench->SummaryPath);
+        return false;
+    }
+
+    fprintf(fp, "{\n\"version\":\"%d.%d.%d\",\n", RADAR_MAJOR, RADAR_MINOR, RADAR_PATCH);
+    fprintf(fp, "\"renderer\":\"%s\",\n", (char const*)glGetString(GL_RENDERER));
+    fprintf(fp, "\"frames\":%u,\n\"warmup_frames\":%u,\n\"step_s\":%.6f,\n", Bench->FrameIndex, Warmup, Bench->StepTime);
+    fprintf(fp, "\"wall_time_s\":%.3f,\n", PlatformGetWallClock() - Bench->RunStart);
+    WriteBenchStats(fp, "frame_ms", &Stats);
+    fprintf(fp, ",\n\"sections\":[");
+
+    printf("Bench : %u frames, mean %.3fms, p50 %.3fms, p95 %.3fms, p99 %.3fms, max %.3fms.\n",
+           Stats.Count, Stats.Mean, Stats.P50, Stats.P95, Stats.P99, Stats.Max);
+
+    for(uint32 i = 0; i < Bench->SectionCount; ++i)
+    {
+        bench_section *Section = &Bench->Sections[i];
+        bench_stats SectionStats = ComputeBenchRangeStats(Bench, &Memory->ScratchArena, Section->FirstFrame, Section->FrameCount, Warmup);
+        fprintf(fp, "%s\n{\"name\":\"%s\",\"first_frame\":%u,", i ? "," : "", Section->Name, Section->FirstFrame);
+        WriteBenchStats(fp, "frame_ms", &SectionStats);
+        fprintf(fp, "}");
+
+        printf("    %-24s %5u frames, p50 %.3fms, p95 %.3fms, p99 %.3fms.\n",
+               Section->Name, SectionStats.Count, SectionStats.P50, SectionStats.P95, SectionStats.P99);
+    }
+    fprintf(fp, "\n]\n}\n");
+
+    bool Valid = !ferror(fp);
+    fclose(fp);
+
+    if(Bench->CSVPath[0])
+    {
+        Valid = WriteBenchCSV(Bench) && Valid;
+    }
+    return Valid;
+}
+
+#endif
@@ -6,19 +6,41 @@ in vec2 v_texcoord;
 in vec3 v_normal;
 in vec3 v_halfvector;
 in vec3 v_sundirection;
+flat in uint v_material;
 
 uniform sampler2D Albedo;
 uniform sampler2D Metallic;
 uniform sampler2D Roughness;
-uniform vec3  AlbedoMult;
-uniform float MetallicMult;
-uniform float RoughnessMult;
+struct material
+{
+    vec3  AlbedoMult;
+    float MetallicMult;
+    float RoughnessMult;
+};
+layout(std140) uniform MaterialBlock
+{
+    material Materials[256];    // UNIFORM_MAX_MATERIALS
+};
 
 uniform samplerCube IrradianceCubemap;
 uniform samplerCube Skybox;
 
-uniform vec4 LightColor;
-uniform vec3 CameraPos;
+layout(std140) uniform FrameBlock
+{
+    vec4  LightColor;
+    vec3  SunDirection;
+    float Time;
+    uint  VertexFormat;   // 1 : packed meshes, see packed_vertex
+};
+
+layout(std140) uniform ViewBlock
+{
+    mat4 ProjMatrix;
+    mat4 ViewMatrix;
+    mat4 SkyViewMatrix;     // ViewMatrix without its translation
+    mat4 OrthoMatrix;       // 2D, in pixels
+    vec3 CameraPos;
+};
 
 
 out vec4 frag_color;
@@ -69,9 +91,10 @@ void main()
     vec3 H = normalize(V + L);
     vec3 R = reflect(V, N);
 
-    vec3 albedo = pow(texture(Albedo, v_texcoord).xyz, vec3(2.2)) * AlbedoMult;
-    vec3 metallic = texture(Metallic, v_texcoord).xyz * MetallicMult;
-    vec3 roughness = texture(Roughness, v_texcoord).xyz * RoughnessMult;
+    material mat = Materials[v_material];
+    vec3 albedo = pow(texture(Albedo, v_texcoord).xyz, vec3(2.2)) * mat.AlbedoMult;
+    vec3 metallic = texture(Metallic, v_texcoord).xyz * mat.MetallicMult;
+    vec3 roughness = texture(Roughness, v_texcoord).xyz * mat.RoughnessMult;
     vec3 env_light = pow(texture(Skybox, R).xyz, vec3(2.2));
     vec3 irr_light = pow(texture(IrradianceCubemap, -R).xyz, vec3(1.0));
 
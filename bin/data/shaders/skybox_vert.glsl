@@ -2,14 +2,20 @@
 
 layout(location=0) in vec3 in_position;
 
-uniform mat4 ViewMatrix;
-uniform mat4 ProjMatrix;
+layout(std140) uniform ViewBlock
+{
+    mat4 ProjMatrix;
+    mat4 ViewMatrix;
+    mat4 SkyViewMatrix;     // ViewMatrix without its translation
+    mat4 OrthoMatrix;       // 2D, in pixels
+    vec3 CameraPos;
+};
 
 out vec3 v_texcoord;
 
 void main()
 {
     v_texcoord = in_position; // unit cube positions are unnormalized cartesian unit direction
-    vec4 pos = ProjMatrix * ViewMatrix * vec4(in_position, 1.0);
+    vec4 pos = ProjMatrix * SkyViewMatrix * vec4(in_position, 1.0);
     gl_Position = pos.xyww; // always max depth
 }
@@ -3,7 +3,15 @@
 layout(location=0) in vec3 in_position;
 layout(location=1) in vec2 in_texcoord;
 
-uniform mat4 ProjMatrix;
+layout(std140) uniform ViewBlock
+{
+    mat4 ProjMatrix;
+    mat4 ViewMatrix;
+    mat4 SkyViewMatrix;     // ViewMatrix without its translation
+    mat4 OrthoMatrix;       // 2D, in pixels
+    vec3 CameraPos;
+};
+
 uniform mat4 ModelMatrix;
 
 out vec2 v_texcoord;
@@ -11,5 +19,5 @@ out vec2 v_texcoord;
 void main()
 {
     v_texcoord = in_texcoord;
-    gl_Position = ProjMatrix * ModelMatrix * vec4(in_position, 1.0);
+    gl_Position = OrthoMatrix * ModelMatrix * vec4(in_position, 1.0);
 }
@@ -3,7 +3,14 @@
 layout(location=0) in vec3 position;
 layout(location=1) in vec2 texcoord;
 
-uniform mat4 ProjMatrix;
+layout(std140) uniform ViewBlock
+{
+    mat4 ProjMatrix;
+    mat4 ViewMatrix;
+    mat4 SkyViewMatrix;     // ViewMatrix without its translation
+    mat4 OrthoMatrix;       // 2D, in pixels
+    vec3 CameraPos;
+};
 
 out vec2 v_texcoord;
 
@@ -11,5 +18,5 @@ void main()
 {
     v_texcoord = texcoord;
 
-    gl_Position = ProjMatrix * vec4(position, 1.0);
+    gl_Position = OrthoMatrix * vec4(position, 1.0);
 }
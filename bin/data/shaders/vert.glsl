@@ -3,26 +3,56 @@
 layout(location=0) in vec3 in_position;
 layout(location=1) in vec2 in_texcoord;
 layout(location=2) in vec3 in_normal;
+layout(location=3) in vec2 in_octnormal;       // in_normal of packed meshes
+layout(location=8) in mat4 in_model_matrix;     // Per instance, see render_instance
+layout(location=12) in uint in_material;
 
-uniform mat4 ProjMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ModelMatrix;
-uniform vec3 SunDirection;
-uniform vec3 CameraPos;
+layout(std140) uniform FrameBlock
+{
+    vec4  LightColor;
+    vec3  SunDirection;
+    float Time;
+    uint  VertexFormat;   // 1 : packed meshes, see packed_vertex
+};
+
+layout(std140) uniform ViewBlock
+{
+    mat4 ProjMatrix;
+    mat4 ViewMatrix;
+    mat4 SkyViewMatrix;     // ViewMatrix without its translation
+    mat4 OrthoMatrix;       // 2D, in pixels
+    vec3 CameraPos;
+};
 
 out vec3 v_position;
 out vec2 v_texcoord;
 out vec3 v_normal;
 out vec3 v_halfvector;
 out vec3 v_sundirection;
+flat out uint v_material;
+
+// NOTE - Inverse of OctEncodeNormal
+vec3 OctDecodeNormal(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if(n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
 
 void main()
 {
+    mat4 ModelMatrix = in_model_matrix;
     vec4 world_position = ModelMatrix * vec4(in_position, 1.0);
 
+    v_material = in_material;
+
     v_texcoord = in_texcoord;
     v_sundirection = SunDirection;//normalize((ViewMatrix * vec4(SunDirection, 0.0)).xyz);
-    v_normal = (inverse(transpose(ModelMatrix)) * vec4(in_normal, 0.0)).xyz;
+    vec3 normal = (VertexFormat == 1u) ? OctDecodeNormal(in_octnormal) : in_normal;
+    v_normal = (inverse(transpose(ModelMatrix)) * vec4(normal, 0.0)).xyz;
     v_position = world_position.xyz;
     //v_halfvector = v_sundirection + normalize(-v_position);
     v_halfvector = normalize(v_sundirection);
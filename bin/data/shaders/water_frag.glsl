@@ -11,9 +11,22 @@ in vec3 v_sundirection;
 uniform samplerCube Skybox;
 uniform samplerCube IrradianceCubemap;
 
-uniform vec4 LightColor;
-uniform vec3 CameraPos;
-uniform float Time;
+layout(std140) uniform FrameBlock
+{
+    vec4  LightColor;
+    vec3  SunDirection;
+    float Time;
+    uint  VertexFormat;   // 1 : packed meshes, see packed_vertex
+};
+
+layout(std140) uniform ViewBlock
+{
+    mat4 ProjMatrix;
+    mat4 ViewMatrix;
+    mat4 SkyViewMatrix;     // ViewMatrix without its translation
+    mat4 OrthoMatrix;       // 2D, in pixels
+    vec3 CameraPos;
+};
 
 out vec4 frag_color;
 
@@ -3,11 +3,24 @@
 layout(location=0) in vec3 in_position;
 layout(location=1) in vec3 in_normal;
 layout(location=2) in vec3 in_texcoord;
+layout(location=8) in mat4 in_model_matrix;     // Per instance, see render_instance
 
-uniform mat4 ProjMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ModelMatrix;
-uniform vec3 SunDirection;
+layout(std140) uniform FrameBlock
+{
+    vec4  LightColor;
+    vec3  SunDirection;
+    float Time;
+    uint  VertexFormat;   // 1 : packed meshes, see packed_vertex
+};
+
+layout(std140) uniform ViewBlock
+{
+    mat4 ProjMatrix;
+    mat4 ViewMatrix;
+    mat4 SkyViewMatrix;     // ViewMatrix without its translation
+    mat4 OrthoMatrix;       // 2D, in pixels
+    vec3 CameraPos;
+};
 
 out vec3 v_position;
 out vec2 v_texcoord;
@@ -16,6 +29,7 @@ out vec3 v_sundirection;
 
 void main()
 {
+    mat4 ModelMatrix = in_model_matrix;
     vec4 world_position = ModelMatrix * vec4(in_position, 1.0);
 
     v_position = world_position.xyz;
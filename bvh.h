@@ -0,0 +1,538 @@
+#ifndef BVH_H
+#define BVH_H
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - Dynamic bounding volume hierarchy over scene objects
+// - A binary tree of boxes in one flat node array, in arena memory. Growth
+//   works like the containers : outgrown arrays stay in the arena.
+// - Leaves store a fat box (the object's, grown by Margin) : objects that move
+//   inside it cost nothing, the others are removed and reinserted.
+// - Insertion picks the sibling that grows the surface area the least, then
+//   rotations on the way up keep the tree balanced like an AVL tree.
+// - Proxies (leaf node indices) stay valid until removed, growth included.
+// - Queries return the UserData of the leaves, reading the fat boxes : they
+//   can return objects slightly outside of the query.
+//////////////////////////////////////////////////////////////////////////
+#define BVH_NULL -1
+#define BVH_STACK_SIZE 256
+
+// NOTE - Planes face the inside : a point is inside when dot(xyz, P) + w >= 0.
+// Also used by the platform's culling (see cull.cpp).
+struct frustum
+{
+    vec4f Planes[6];
+};
+
+// NOTE - Gribb & Hartmann : the planes are sums of the rows of the clip matrix.
+// GL clip space, -w <= x,y,z <= w.
+inline frustum MakeFrustum(mat4f const &ViewProj)
+{
+    frustum Frustum;
+    vec4f RowW(ViewProj.M[0][3], ViewProj.M[1][3], ViewProj.M[2][3], ViewProj.M[3][3]);
+    for(int i = 0; i < 3; ++i)
+    {
+        vec4f Row(ViewProj.M[0][i], ViewProj.M[1][i], ViewProj.M[2][i], ViewProj.M[3][i]);
+        Frustum.Planes[2*i+0] = RowW + Row;
+        Frustum.Planes[2*i+1] = RowW - Row;
+    }
+
+    for(int i = 0; i < 6; ++i)
+    {
+        vec4f &P = Frustum.Planes[i];
+        real32 Len = Length(vec3f(P.x, P.y, P.z));
+        P = P * (1.f / Len);
+    }
+
+    return Frustum;
+}
+
+struct bvh_node
+{
+    vec3f  Min;
+    vec3f  Max;
+    int32  Parent;      // Next free node when in the free list
+    int32  Left;        // BVH_NULL for leaves
+    int32  Right;
+    int32  Height;      // 0 for leaves, -1 for free nodes
+    uint32 UserData;
+};
+
+struct bvh
+{
+    memory_arena *Arena;
+    bvh_node *Nodes;
+    uint32 Capacity;
+    uint32 NodeCount;   // Ever handed out, free ones included
+    uint32 LeafCount;
+    int32  Root;
+    int32  FreeList;
+    real32 Margin;      // Added around the boxes of the leaves
+};
+
+inline void InitBVH(bvh *Tree, memory_arena *Arena, uint32 InitialCapacity = 64, real32 Margin = 0.5f)
+{
+    Tree->Arena = Arena;
+    Tree->Capacity = Max(InitialCapacity, 2u);
+    Tree->Nodes = (bvh_node*)PushArenaData(Arena, Tree->Capacity * sizeof(bvh_node));
+    Tree->NodeCount = 0;
+    Tree->LeafCount = 0;
+    Tree->Root = BVH_NULL;
+    Tree->FreeList = BVH_NULL;
+    Tree->Margin = Margin;
+}
+
+inline bool BVHIsLeaf(bvh_node const *Node)
+{
+    return Node->Left == BVH_NULL;
+}
+
+inline uint32 BVHUserData(bvh *Tree, int32 Proxy)
+{
+    Assert(Proxy >= 0 && (uint32)Proxy < Tree->NodeCount && BVHIsLeaf(&Tree->Nodes[Proxy]));
+    return Tree->Nodes[Proxy].UserData;
+}
+
+inline real32 _BVHArea(vec3f Min, vec3f Max)
+{
+    vec3f D = Max - Min;
+    return 2.f * (D.x * D.y + D.y * D.z + D.z * D.x);
+}
+
+inline void _BVHUnion(bvh_node *Node, bvh_node const *A, bvh_node const *B)
+{
+    Node->Min = vec3f(Min(A->Min.x, B->Min.x), Min(A->Min.y, B->Min.y), Min(A->Min.z, B->Min.z));
+    Node->Max = vec3f(Max(A->Max.x, B->Max.x), Max(A->Max.y, B->Max.y), Max(A->Max.z, B->Max.z));
+}
+
+inline bool _BVHContains(bvh_node const *Node, vec3f Min, vec3f Max)
+{
+    return Node->Min.x <= Min.x && Node->Min.y <= Min.y && Node->Min.z <= Min.z &&
+           Node->Max.x >= Max.x && Node->Max.y >= Max.y && Node->Max.z >= Max.z;
+}
+
+// NOTE - Can move the node array : don't keep node pointers across this
+inline int32 _BVHAllocNode(bvh *Tree)
+{
+    int32 Index;
+    if(Tree->FreeList != BVH_NULL)
+    {
+        Index = Tree->FreeList;
+        Tree->FreeList = Tree->Nodes[Index].Parent;
+    }
+    else
+    {
+        if(Tree->NodeCount == Tree->Capacity)
+        {
+            uint32 NewCapacity = Tree->Capacity * 2;
+            bvh_node *NewNodes = (bvh_node*)PushArenaData(Tree->Arena, NewCapacity * sizeof(bvh_node));
+            memcpy((void*)NewNodes, Tree->Nodes, Tree->NodeCount * sizeof(bvh_node));
+            Tree->Nodes = NewNodes;
+            Tree->Capacity = NewCapacity;
+        }
+        Index = (int32)Tree->NodeCount++;
+    }
+
+    bvh_node *Node = &Tree->Nodes[Index];
+    Node->Parent = BVH_NULL;
+    Node->Left = BVH_NULL;
+    Node->Right = BVH_NULL;
+    Node->Height = 0;
+    Node->UserData = 0;
+    return Index;
+}
+
+inline void _BVHFreeNode(bvh *Tree, int32 Index)
+{
+    Tree->Nodes[Index].Parent = Tree->FreeList;
+    Tree->Nodes[Index].Height = -1;
+    Tree->FreeList = Index;
+}
+
+inline void _BVHRefitNode(bvh *Tree, int32 Index)
+{
+    bvh_node *Node = &Tree->Nodes[Index];
+    bvh_node *Left = &Tree->Nodes[Node->Left];
+    bvh_node *Right = &Tree->Nodes[Node->Right];
+    _BVHUnion(Node, Left, Right);
+    Node->Height = 1 + Max(Left->Height, Right->Height);
+}
+
+inline void _BVHReplaceChild(bvh *Tree, int32 Parent, int32 OldChild, int32 NewChild)
+{
+    if(Parent == BVH_NULL)
+    {
+        Tree->Root = NewChild;
+    }
+    else if(Tree->Nodes[Parent].Left == OldChild)
+    {
+        Tree->Nodes[Parent].Left = NewChild;
+    }
+    else
+    {
+        Tree->Nodes[Parent].Right = NewChild;
+    }
+}
+
+// NOTE - If a child of A is 2 levels taller than the other, it takes A's place and
+// A takes its shorter child. Returns the node now at A's place.
+inline int32 _BVHBalance(bvh *Tree, int32 iA)
+{
+    bvh_node *A = &Tree->Nodes[iA];
+    if(BVHIsLeaf(A) || A->Height < 2)
+    {
+        return iA;
+    }
+
+    int32 iB = A->Left;
+    int32 iC = A->Right;
+    int32 Balance = Tree->Nodes[iC].Height - Tree->Nodes[iB].Height;
+    if(Balance > -2 && Balance < 2)
+    {
+        return iA;
+    }
+
+    // NOTE - Both rotations are the same with the sides swapped
+    bool RotateRight = Balance > 1;
+    int32 iUp = RotateRight ? iC : iB;
+    bvh_node *Up = &Tree->Nodes[iUp];
+    int32 iF = Up->Left;
+    int32 iG = Up->Right;
+
+    Up->Left = iA;
+    Up->Parent = A->Parent;
+    A->Parent = iUp;
+    _BVHReplaceChild(Tree, Up->Parent, iA, iUp);
+
+    // NOTE - Up keeps its taller child, A takes the other
+    int32 iKeep = (Tree->Nodes[iF].Height > Tree->Nodes[iG].Height) ? iF : iG;
+    int32 iGive = (iKeep == iF) ? iG : iF;
+    Up->Right = iKeep;
+    if(RotateRight)
+    {
+        A->Right = iGive;
+    }
+    else
+    {
+        A->Left = iGive;
+    }
+    Tree->Nodes[iGive].Parent = iA;
+
+    _BVHRefitNode(Tree, iA);
+    _BVHRefitNode(Tree, iUp);
+    return iUp;
+}
+
+inline void _BVHFixUpwards(bvh *Tree, int32 Index)
+{
+    while(Index != BVH_NULL)
+    {
+        Index = _BVHBalance(Tree, Index);
+        _BVHRefitNode(Tree, Index);
+        Index = Tree->Nodes[Index].Parent;
+    }
+}
+
+inline void _BVHInsertLeaf(bvh *Tree, int32 Leaf)
+{
+    if(Tree->Root == BVH_NULL)
+    {
+        Tree->Root = Leaf;
+        Tree->Nodes[Leaf].Parent = BVH_NULL;
+        return;
+    }
+
+    // NOTE - Goes down towards the sibling with the cheapest total area growth
+    bvh_node LeafBox = Tree->Nodes[Leaf];
+    int32 Index = Tree->Root;
+    while(!BVHIsLeaf(&Tree->Nodes[Index]))
+    {
+        bvh_node *Node = &Tree->Nodes[Index];
+        bvh_node Combined;
+        _BVHUnion(&Combined, Node, &LeafBox);
+        real32 CombinedArea = _BVHArea(Combined.Min, Combined.Max);
+
+        // NOTE - Cost of a new parent of Node and the leaf, and what every ancestor
+        // grows by if we go further down
+        real32 Cost = 2.f * CombinedArea;
+        real32 InheritedCost = 2.f * (CombinedArea - _BVHArea(Node->Min, Node->Max));
+
+        real32 ChildCosts[2];
+        int32 Children[2] = { Node->Left, Node->Right };
+        for(int c = 0; c < 2; ++c)
+        {
+            bvh_node *Child = &Tree->Nodes[Children[c]];
+            _BVHUnion(&Combined, Child, &LeafBox);
+            real32 Area = _BVHArea(Combined.Min, Combined.Max);
+            ChildCosts[c] = InheritedCost + (BVHIsLeaf(Child) ? Area : Area - _BVHArea(Child->Min, Child->Max));
+        }
+
+        if(Cost < ChildCosts[0] && Cost < ChildCosts[1])
+        {
+            break;
+        }
+        Index = (ChildCosts[0] < ChildCosts[1]) ? Children[0] : Children[1];
+    }
+
+    int32 Sibling = Index;
+    int32 NewParent = _BVHAllocNode(Tree);
+    int32 OldParent = Tree->Nodes[Sibling].Parent;
+    Tree->Nodes[NewParent].Parent = OldParent;
+    Tree->Nodes[NewParent].Left = Sibling;
+    Tree->Nodes[NewParent].Right = Leaf;
+    _BVHReplaceChild(Tree, OldParent, Sibling, NewParent);
+    Tree->Nodes[Sibling].Parent = NewParent;
+    Tree->Nodes[Leaf].Parent = NewParent;
+
+    _BVHFixUpwards(Tree, NewParent);
+}
+
+inline void _BVHRemoveLeaf(bvh *Tree, int32 Leaf)
+{
+    if(Leaf == Tree->Root)
+    {
+        Tree->Root = BVH_NULL;
+        return;
+    }
+
+    int32 Parent = Tree->Nodes[Leaf].Parent;
+    int32 GrandParent = Tree->Nodes[Parent].Parent;
+    int32 Sibling = (Tree->Nodes[Parent].Left == Leaf) ? Tree->Nodes[Parent].Right : Tree->Nodes[Parent].Left;
+
+    _BVHReplaceChild(Tree, GrandParent, Parent, Sibling);
+    Tree->Nodes[Sibling].Parent = GrandParent;
+    _BVHFreeNode(Tree, Parent);
+
+    _BVHFixUpwards(Tree, GrandParent);
+}
+
+// NOTE - Returns the proxy of the object, to move or remove it
+inline int32 BVHInsert(bvh *Tree, vec3f Min, vec3f Max, uint32 UserData)
+{
+    int32 Proxy = _BVHAllocNode(Tree);
+    bvh_node *Node = &Tree->Nodes[Proxy];
+    Node->Min = Min - vec3f(Tree->Margin);
+    Node->Max = Max + vec3f(Tree->Margin);
+    Node->UserData = UserData;
+
+    _BVHInsertLeaf(Tree, Proxy);
+    ++Tree->LeafCount;
+    return Proxy;
+}
+
+inline void BVHRemove(bvh *Tree, int32 Proxy)
+{
+    Assert(BVHIsLeaf(&Tree->Nodes[Proxy]) && Tree->Nodes[Proxy].Height == 0);
+    _BVHRemoveLeaf(Tree, Proxy);
+    _BVHFreeNode(Tree, Proxy);
+    --Tree->LeafCount;
+}
+
+// NOTE - Call whenever the object moved. Only reinserts it when it left its fat
+// box, returns true then.
+inline bool BVHMove(bvh *Tree, int32 Proxy, vec3f Min, vec3f Max)
+{
+    if(_BVHContains(&Tree->Nodes[Proxy], Min, Max))
+    {
+        return false;
+    }
+
+    _BVHRemoveLeaf(Tree, Proxy);
+    Tree->Nodes[Proxy].Min = Min - vec3f(Tree->Margin);
+    Tree->Nodes[Proxy].Max = Max + vec3f(Tree->Margin);
+    _BVHInsertLeaf(Tree, Proxy);
+    return true;
+}
+
+// NOTE - Every leaf under Index, no tests
+inline uint32 _BVHCollectLeaves(bvh *Tree, int32 Index, uint32 *Results, uint32 Count, uint32 MaxResults)
+{
+    int32 Stack[BVH_STACK_SIZE];
+    uint32 StackSize = 0;
+    Stack[StackSize++] = Index;
+    while(StackSize && Count < MaxResults)
+    {
+        bvh_node *Node = &Tree->Nodes[Stack[--StackSize]];
+        if(BVHIsLeaf(Node))
+        {
+            Results[Count++] = Node->UserData;
+        }
+        else
+        {
+            Assert(StackSize + 2 <= BVH_STACK_SIZE);
+            Stack[StackSize++] = Node->Left;
+            Stack[StackSize++] = Node->Right;
+        }
+    }
+    return Count;
+}
+
+// NOTE - Fills Results with the UserData of at most MaxResults objects touching the
+// frustum, returns how many. Subtrees fully inside are taken without more tests.
+inline uint32 BVHQueryFrustum(bvh *Tree, frustum const *Frustum, uint32 *Results, uint32 MaxResults)
+{
+    if(Tree->Root == BVH_NULL)
+    {
+        return 0;
+    }
+
+    uint32 Count = 0;
+    int32 Stack[BVH_STACK_SIZE];
+    uint32 StackSize = 0;
+    Stack[StackSize++] = Tree->Root;
+    while(StackSize && Count < MaxResults)
+    {
+        int32 Index = Stack[--StackSize];
+        bvh_node *Node = &Tree->Nodes[Index];
+
+        // NOTE - Per plane, the corner furthest along the normal decides if the box
+        // is outside, the nearest one if it straddles the plane
+        bool Inside = true, Outside = false;
+        for(int p = 0; p < 6 && !Outside; ++p)
+        {
+            vec4f const &P = Frustum->Planes[p];
+            vec3f Far(P.x >= 0.f ? Node->Max.x : Node->Min.x, P.y >= 0.f ? Node->Max.y : Node->Min.y,
+                      P.z >= 0.f ? Node->Max.z : Node->Min.z);
+            vec3f Near(P.x >= 0.f ? Node->Min.x : Node->Max.x, P.y >= 0.f ? Node->Min.y : Node->Max.y,
+                       P.z >= 0.f ? Node->Min.z : Node->Max.z);
+            Outside = (P.x * Far.x + P.y * Far.y + P.z * Far.z + P.w) < 0.f;
+            Inside = Inside && (P.x * Near.x + P.y * Near.y + P.z * Near.z + P.w) >= 0.f;
+        }
+
+        if(Outside)
+        {
+            continue;
+        }
+        if(Inside || BVHIsLeaf(Node))
+        {
+            Count = _BVHCollectLeaves(Tree, Index, Results, Count, MaxResults);
+        }
+        else
+        {
+            Assert(StackSize + 2 <= BVH_STACK_SIZE);
+            Stack[StackSize++] = Node->Left;
+            Stack[StackSize++] = Node->Right;
+        }
+    }
+
+    return Count;
+}
+
+// NOTE - Same as BVHQueryFrustum, for the objects whose box touches the sphere
+inline uint32 BVHQuerySphere(bvh *Tree, vec3f Center, real32 Radius, uint32 *Results, uint32 MaxResults)
+{
+    if(Tree->Root == BVH_NULL)
+    {
+        return 0;
+    }
+
+    uint32 Count = 0;
+    int32 Stack[BVH_STACK_SIZE];
+    uint32 StackSize = 0;
+    Stack[StackSize++] = Tree->Root;
+    while(StackSize && Count < MaxResults)
+    {
+        bvh_node *Node = &Tree->Nodes[Stack[--StackSize]];
+        vec3f Closest(Clamp(Center.x, Node->Min.x, Node->Max.x), Clamp(Center.y, Node->Min.y, Node->Max.y),
+                      Clamp(Center.z, Node->Min.z, Node->Max.z));
+        vec3f D = Closest - Center;
+        if(D.x * D.x + D.y * D.y + D.z * D.z > Radius * Radius)
+        {
+            continue;
+        }
+
+        if(BVHIsLeaf(Node))
+        {
+            Results[Count++] = Node->UserData;
+        }
+        else
+        {
+            Assert(StackSize + 2 <= BVH_STACK_SIZE);
+            Stack[StackSize++] = Node->Left;
+            Stack[StackSize++] = Node->Right;
+        }
+    }
+
+    return Count;
+}
+
+// NOTE - Distance along the ray where it enters the box, or a negative value
+// if it misses it before MaxDistance. Starting inside is a hit at 0.
+inline real32 _BVHRayBox(vec3f Origin, vec3f InvDirection, real32 MaxDistance, bvh_node *Node)
+{
+    real32 Enter = 0.f, Exit = MaxDistance;
+    for(int a = 0; a < 3; ++a)
+    {
+        real32 T0 = (Node->Min[a] - Origin[a]) * InvDirection[a];
+        real32 T1 = (Node->Max[a] - Origin[a]) * InvDirection[a];
+        Enter = Max(Enter, Min(T0, T1));
+        Exit = Min(Exit, Max(T0, T1));
+    }
+    return (Enter <= Exit) ? Enter : -1.f;
+}
+
+// NOTE - Exact distance along the ray to the object of a leaf, negative if it misses it before MaxDistance
+typedef real32 bvh_ray_test(void *Data, uint32 UserData, vec3f Origin, vec3f Direction, real32 MaxDistance);
+
+// NOTE - Nearest object whose fat box the ray hits, BVH_NULL if none. Direction
+// must be normalized. With a Test, the leaves whose boxes are hit are tested
+// exactly instead, and the nearest object the Test hits is returned.
+inline int32 BVHRayCast(bvh *Tree, vec3f Origin, vec3f Direction, real32 MaxDistance, real32 *HitDistance = NULL,
+                        bvh_ray_test *Test = NULL, void *TestData = NULL)
+{
+    if(Tree->Root == BVH_NULL)
+    {
+        return BVH_NULL;
+    }
+
+    // NOTE - Axis-parallel rays get huge but finite inverses, 0 * inf would be NaN
+    vec3f InvDirection;
+    for(int a = 0; a < 3; ++a)
+    {
+        real32 D = Direction[a];
+        InvDirection[a] = 1.f / ((D >= 0.f) ? Max(D, 1e-12f) : Min(D, -1e-12f));
+    }
+
+    int32 Hit = BVH_NULL;
+    real32 Nearest = MaxDistance;
+    int32 Stack[BVH_STACK_SIZE];
+    uint32 StackSize = 0;
+    Stack[StackSize++] = Tree->Root;
+    while(StackSize)
+    {
+        int32 Index = Stack[--StackSize];
+        bvh_node *Node = &Tree->Nodes[Index];
+        real32 T = _BVHRayBox(Origin, InvDirection, Nearest, Node);
+        if(T < 0.f)
+        {
+            continue;
+        }
+
+        if(BVHIsLeaf(Node))
+        {
+            if(Test)
+            {
+                T = Test(TestData, Node->UserData, Origin, Direction, Nearest);
+                if(T < 0.f)
+                {
+                    continue;
+                }
+            }
+            Hit = Index;
+            Nearest = T;
+        }
+        else
+        {
+            Assert(StackSize + 2 <= BVH_STACK_SIZE);
+            Stack[StackSize++] = Node->Left;
+            Stack[StackSize++] = Node->Right;
+        }
+    }
+
+    if(HitDistance)
+    {
+        *HitDistance = Nearest;
+    }
+    return Hit;
+}
+
+#endif
@@ -0,0 +1,397 @@
+#ifndef CONTAINERS_H
+#define CONTAINERS_H
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - Arena-backed containers
+// - Only meant for POD types : no constructor/destructor is ever called.
+// - Growth never frees anything, outgrown storage stays in the arena until
+//   that arena is reset. Size them sensibly at Init for long-lived arenas.
+// - The structs don't point to themselves, they can be memcpy'ed freely.
+// - No exceptions, no RTTI. Running out of arena space asserts.
+//////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - Chunked growable array
+// Elements live in fixed-size chunks, only the chunk table is reallocated
+// when growing : element pointers stay valid for the array's whole life.
+//////////////////////////////////////////////////////////////////////////
+template<typename T>
+struct arena_array
+{
+    memory_arena *Arena;
+    T **Chunks;
+    uint32 ChunkShift;      // log2 of the element count per chunk
+    uint32 ChunkCount;
+    uint32 ChunkTableSize;
+    uint32 Count;
+};
+
+template<typename T>
+void InitArray(arena_array<T> *Array, memory_arena *Arena, uint32 ChunkShift = 6)
+{
+    Array->Arena = Arena;
+    Array->Chunks = NULL;
+    Array->ChunkShift = ChunkShift;
+    Array->ChunkCount = 0;
+    Array->ChunkTableSize = 0;
+    Array->Count = 0;
+}
+
+template<typename T>
+T *ArrayGet(arena_array<T> *Array, uint32 Index)
+{
+    Assert(Index < Array->Count);
+    uint32 Mask = (1 << Array->ChunkShift) - 1;
+    return &Array->Chunks[Index >> Array->ChunkShift][Index & Mask];
+}
+
+// NOTE - Returns the new element, zeroed
+template<typename T>
+T *ArrayPush(arena_array<T> *Array)
+{
+    uint32 ChunkIdx = Array->Count >> Array->ChunkShift;
+    if(ChunkIdx == Array->ChunkCount)
+    {
+        if(Array->ChunkCount == Array->ChunkTableSize)
+        {
+            uint32 NewTableSize = Max(8u, Array->ChunkTableSize * 2);
+            T **NewChunks = (T**)PushArenaData(Array->Arena, NewTableSize * sizeof(T*));
+            if(Array->ChunkCount)
+            {
+                memcpy(NewChunks, Array->Chunks, Array->ChunkCount * sizeof(T*));
+            }
+            Array->Chunks = NewChunks;
+            Array->ChunkTableSize = NewTableSize;
+        }
+
+        Array->Chunks[Array->ChunkCount++] = (T*)PushArenaData(Array->Arena, sizeof(T) << Array->ChunkShift);
+    }
+
+    Array->Count++;
+    T *Element = ArrayGet(Array, Array->Count - 1);
+    memset(Element, 0, sizeof(T));
+    return Element;
+}
+
+template<typename T>
+T *ArrayPush(arena_array<T> *Array, T const &Value)
+{
+    T *Element = ArrayPush(Array);
+    *Element = Value;
+    return Element;
+}
+
+// NOTE - Keeps the chunks around for reuse
+template<typename T>
+void ArrayClear(arena_array<T> *Array)
+{
+    Array->Count = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - Key hashing. Add an overload of HashKey/KeysEqual for new key types.
+// A hash of 0 marks an empty slot in the hash_map, so it's remapped.
+//////////////////////////////////////////////////////////////////////////
+inline uint32 HashKey(uint32 Key)
+{
+    // NOTE - Murmur3 finalizer
+    Key ^= Key >> 16;
+    Key *= 0x85ebca6b;
+    Key ^= Key >> 13;
+    Key *= 0xc2b2ae35;
+    Key ^= Key >> 16;
+    return Key;
+}
+
+inline uint32 HashKey(uint64 Key)
+{
+    Key ^= Key >> 33;
+    Key *= 0xff51afd7ed558ccdULL;
+    Key ^= Key >> 33;
+    Key *= 0xc4ceb9fe1a85ec53ULL;
+    Key ^= Key >> 33;
+    return (uint32)Key;
+}
+
+inline uint32 HashKey(int32 Key)
+{
+    return HashKey((uint32)Key);
+}
+
+inline uint32 HashKey(void const *Key)
+{
+    return HashKey((uint64)(size_t)Key);
+}
+
+inline uint32 HashString(char const *String, uint32 Length)
+{
+    // NOTE - FNV-1a
+    uint32 Hash = 2166136261u;
+    for(uint32 i = 0; i < Length; ++i)
+    {
+        Hash ^= (uint8)String[i];
+        Hash *= 16777619u;
+    }
+    return Hash;
+}
+
+template<typename K>
+bool KeysEqual(K const &A, K const &B)
+{
+    return A == B;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - Open-addressing hash map with Robin Hood probing
+// Entries far from their ideal slot steal the place of entries closer to
+// theirs, which keeps probe lengths short and lets lookups stop early.
+// Removal uses backward shifting, there are no tombstones.
+// Returned Value pointers are invalidated by the next insertion.
+//////////////////////////////////////////////////////////////////////////
+template<typename K, typename V>
+struct hash_map_slot
+{
+    uint32 Hash;    // 0 : empty
+    K Key;
+    V Value;
+};
+
+template<typename K, typename V>
+struct hash_map
+{
+    memory_arena *Arena;
+    hash_map_slot<K, V> *Slots;
+    uint32 Capacity;    // Power of 2
+    uint32 Count;
+};
+
+inline uint32 _MapSlotHash(uint32 Hash)
+{
+    return Hash ? Hash : 1;
+}
+
+template<typename K, typename V>
+void InitMap(hash_map<K, V> *Map, memory_arena *Arena, uint32 InitialCapacity = 64)
+{
+    uint32 Capacity = 8;
+    while(Capacity < InitialCapacity) Capacity <<= 1;
+
+    Map->Arena = Arena;
+    Map->Capacity = Capacity;
+    Map->Count = 0;
+    Map->Slots = (hash_map_slot<K, V>*)PushArenaData(Arena, Capacity * sizeof(hash_map_slot<K, V>));
+    memset(Map->Slots, 0, Capacity * sizeof(hash_map_slot<K, V>));
+}
+
+// NOTE - Keeps the storage for reuse
+template<typename K, typename V>
+void MapClear(hash_map<K, V> *Map)
+{
+    memset(Map->Slots, 0, Map->Capacity * sizeof(hash_map_slot<K, V>));
+    Map->Count = 0;
+}
+
+// NOTE - Returns the slot index of the key, or Capacity if absent
+template<typename K, typename V>
+uint32 _MapFindIndex(hash_map<K, V> *Map, K const &Key)
+{
+    uint32 Hash = _MapSlotHash(HashKey(Key));
+    uint32 Mask = Map->Capacity - 1;
+
+    for(uint32 Dist = 0, Idx = Hash & Mask; ; ++Dist, Idx = (Idx + 1) & Mask)
+    {
+        hash_map_slot<K, V> *Slot = &Map->Slots[Idx];
+        if(!Slot->Hash)
+        {
+            return Map->Capacity;
+        }
+
+        // NOTE - Robin Hood invariant : if we are further than this entry from
+        // its own ideal slot, the key would have taken this place.
+        uint32 SlotDist = (Idx - (Slot->Hash & Mask)) & Mask;
+        if(SlotDist < Dist)
+        {
+            return Map->Capacity;
+        }
+
+        if(Slot->Hash == Hash && KeysEqual(Slot->Key, Key))
+        {
+            return Idx;
+        }
+    }
+}
+
+template<typename K, typename V>
+V *MapFind(hash_map<K, V> *Map, K const &Key)
+{
+    uint32 Idx = _MapFindIndex(Map, Key);
+    return Idx < Map->Capacity ? &Map->Slots[Idx].Value : NULL;
+}
+
+template<typename K, typename V>
+void _MapGrow(hash_map<K, V> *Map);
+
+// NOTE - Inserts or overwrites. Returns the stored value.
+template<typename K, typename V>
+V *MapInsert(hash_map<K, V> *Map, K const &Key, V const &Value)
+{
+    V *Existing = MapFind(Map, Key);
+    if(Existing)
+    {
+        *Existing = Value;
+        return Existing;
+    }
+
+    // NOTE - Max load factor of 3/4
+    if((Map->Count + 1) * 4 > Map->Capacity * 3)
+    {
+        _MapGrow(Map);
+    }
+
+    hash_map_slot<K, V> Entry;
+    Entry.Hash = _MapSlotHash(HashKey(Key));
+    Entry.Key = Key;
+    Entry.Value = Value;
+
+    uint32 Mask = Map->Capacity - 1;
+    hash_map_slot<K, V> *Result = NULL;
+    for(uint32 Dist = 0, Idx = Entry.Hash & Mask; ; ++Dist, Idx = (Idx + 1) & Mask)
+    {
+        hash_map_slot<K, V> *Slot = &Map->Slots[Idx];
+        if(!Slot->Hash)
+        {
+            *Slot = Entry;
+            if(!Result) Result = Slot;
+            break;
+        }
+
+        uint32 SlotDist = (Idx - (Slot->Hash & Mask)) & Mask;
+        if(SlotDist < Dist)
+        {
+            // NOTE - Take the place of the richer entry, and carry it along
+            hash_map_slot<K, V> Tmp = *Slot;
+            *Slot = Entry;
+            Entry = Tmp;
+            Dist = SlotDist;
+            if(!Result) Result = Slot;
+        }
+    }
+
+    Map->Count++;
+    return &Result->Value;
+}
+
+template<typename K, typename V>
+void _MapGrow(hash_map<K, V> *Map)
+{
+    hash_map_slot<K, V> *OldSlots = Map->Slots;
+    uint32 OldCapacity = Map->Capacity;
+
+    InitMap(Map, Map->Arena, OldCapacity * 2);
+    for(uint32 i = 0; i < OldCapacity; ++i)
+    {
+        if(OldSlots[i].Hash)
+        {
+            MapInsert(Map, OldSlots[i].Key, OldSlots[i].Value);
+        }
+    }
+}
+
+template<typename K, typename V>
+bool MapRemove(hash_map<K, V> *Map, K const &Key)
+{
+    uint32 Idx = _MapFindIndex(Map, Key);
+    if(Idx == Map->Capacity)
+    {
+        return false;
+    }
+
+    uint32 Mask = Map->Capacity - 1;
+
+    // NOTE - Backward shift : pull the following displaced entries one slot closer to home
+    for(;;)
+    {
+        uint32 NextIdx = (Idx + 1) & Mask;
+        hash_map_slot<K, V> *Next = &Map->Slots[NextIdx];
+        if(!Next->Hash || ((NextIdx - (Next->Hash & Mask)) & Mask) == 0)
+        {
+            break;
+        }
+        Map->Slots[Idx] = *Next;
+        Idx = NextIdx;
+    }
+    memset(&Map->Slots[Idx], 0, sizeof(hash_map_slot<K, V>));
+
+    Map->Count--;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - String interning
+// Each distinct string is copied once in the arena and gets a stable ID.
+// Comparing interned strings is comparing IDs. ID 0 is never given out.
+//////////////////////////////////////////////////////////////////////////
+struct string_key
+{
+    char const *String;
+    uint32 Length;
+};
+
+inline uint32 HashKey(string_key const &Key)
+{
+    return HashString(Key.String, Key.Length);
+}
+
+inline bool KeysEqual(string_key const &A, string_key const &B)
+{
+    return A.Length == B.Length && 0 == memcmp(A.String, B.String, A.Length);
+}
+
+struct string_table
+{
+    memory_arena *Arena;
+    hash_map<string_key, uint32> Map;
+    arena_array<char const*> Strings;   // ID-1 -> string
+};
+
+inline void InitStringTable(string_table *Table, memory_arena *Arena, uint32 InitialCapacity = 256)
+{
+    Table->Arena = Arena;
+    InitMap(&Table->Map, Arena, InitialCapacity);
+    InitArray(&Table->Strings, Arena);
+}
+
+// NOTE - Returns 0 if the string was never interned
+inline uint32 FindInterned(string_table *Table, char const *String)
+{
+    string_key Key = { String, (uint32)strlen(String) };
+    uint32 *ID = MapFind(&Table->Map, Key);
+    return ID ? *ID : 0;
+}
+
+inline uint32 Intern(string_table *Table, char const *String)
+{
+    string_key Key = { String, (uint32)strlen(String) };
+    uint32 *ID = MapFind(&Table->Map, Key);
+    if(ID)
+    {
+        return *ID;
+    }
+
+    char *Copy = (char*)PushArenaData(Table->Arena, Key.Length + 1);
+    memcpy(Copy, String, Key.Length + 1);
+    Key.String = Copy;
+
+    ArrayPush(&Table->Strings, (char const*)Copy);
+    uint32 NewID = Table->Strings.Count;
+    MapInsert(&Table->Map, Key, NewID);
+    return NewID;
+}
+
+inline char const *InternedString(string_table *Table, uint32 ID)
+{
+    Assert(ID > 0 && ID <= Table->Strings.Count);
+    return *ArrayGet(&Table->Strings, ID - 1);
+}
+
+#endif
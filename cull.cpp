@@ -0,0 +1,177 @@
+#ifndef CULL_CPP
+#define CULL_CPP
+
+#include <xmmintrin.h>
+
+// NOTE - CPU visibility tests for the render commands (see CullRenderDraws).
+// Bounding spheres are tested 4 at a time against the frustum planes with SSE.
+// The optional occlusion test draws the triangles of a few small occluders in a
+// coarse depth buffer, then tests screen rectangles of bounding boxes against it.
+// Both are conservative : anything they're unsure about is visible.
+#define OCCLUSION_WIDTH 256
+#define OCCLUSION_HEIGHT 128
+#define CULL_INFINITE_RADIUS 1e30f  // Sphere that passes every plane
+#define CULL_NEAR_W 1e-3f           // Clip w below which a point is behind the eye
+
+// NOTE - Spheres are (Center, Radius). Reads Count rounded up to 4 spheres, the
+// caller pads. Returns how many were culled.
+uint32 FrustumCullSpheres(frustum const *Frustum, vec4f const *Spheres, uint32 Count, bool *Visible)
+{
+    __m128 PlaneX[6], PlaneY[6], PlaneZ[6], PlaneW[6];
+    for(uint32 p = 0; p < 6; ++p)
+    {
+        PlaneX[p] = _mm_set1_ps(Frustum->Planes[p].x);
+        PlaneY[p] = _mm_set1_ps(Frustum->Planes[p].y);
+        PlaneZ[p] = _mm_set1_ps(Frustum->Planes[p].z);
+        PlaneW[p] = _mm_set1_ps(Frustum->Planes[p].w);
+    }
+
+    __m128 const Zero = _mm_setzero_ps();
+    uint32 Culled = 0;
+    for(uint32 i = 0; i < Count; i += 4)
+    {
+        // NOTE - 4 AoS spheres to SoA
+        __m128 X = _mm_loadu_ps(&Spheres[i+0].x);
+        __m128 Y = _mm_loadu_ps(&Spheres[i+1].x);
+        __m128 Z = _mm_loadu_ps(&Spheres[i+2].x);
+        __m128 R = _mm_loadu_ps(&Spheres[i+3].x);
+        _MM_TRANSPOSE4_PS(X, Y, Z, R);
+
+        __m128 NegR = _mm_sub_ps(Zero, R);
+        __m128 Outside = Zero;
+        for(uint32 p = 0; p < 6; ++p)
+        {
+            __m128 Dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(PlaneX[p], X), _mm_mul_ps(PlaneY[p], Y)),
+                                     _mm_add_ps(_mm_mul_ps(PlaneZ[p], Z), PlaneW[p]));
+            Outside = _mm_or_ps(Outside, _mm_cmplt_ps(Dist, NegR));
+        }
+
+        int32 Mask = _mm_movemask_ps(Outside);
+        for(uint32 j = 0; j < 4 && i + j < Count; ++j)
+        {
+            Visible[i+j] = !(Mask & (1 << j));
+            Culled += Visible[i+j] ? 0 : 1;
+        }
+    }
+
+    return Culled;
+}
+
+// NOTE - Window depth in [0,1], nearest of what was drawn
+struct occlusion_buffer
+{
+    real32 Depth[OCCLUSION_WIDTH * OCCLUSION_HEIGHT];
+};
+
+void ClearOcclusionBuffer(occlusion_buffer *Buffer)
+{
+    for(uint32 i = 0; i < OCCLUSION_WIDTH * OCCLUSION_HEIGHT; ++i)
+    {
+        Buffer->Depth[i] = 1.f;
+    }
+}
+
+// NOTE - To window coordinates, in pixels of the occlusion buffer. False if behind the eye.
+inline bool OcclusionProject(mat4f const &MVP, vec3f P, vec3f *Window)
+{
+    vec4f Clip = MVP * vec4f(P.x, P.y, P.z, 1.f);
+    if(Clip.w < CULL_NEAR_W)
+    {
+        return false;
+    }
+
+    real32 InvW = 1.f / Clip.w;
+    Window->x = (Clip.x * InvW * 0.5f + 0.5f) * OCCLUSION_WIDTH;
+    Window->y = (Clip.y * InvW * 0.5f + 0.5f) * OCCLUSION_HEIGHT;
+    Window->z = Clip.z * InvW * 0.5f + 0.5f;
+    return true;
+}
+
+// NOTE - Pixel centers inside the triangle get its furthest depth : never nearer
+// than the real surface. Back faces are skipped like GL does, triangles crossing
+// the near plane too (fewer occluders is still correct).
+void RasterizeOccluder(occlusion_buffer *Buffer, mat4f const &MVP, vec3f const *Positions,
+                       uint32 const *Indices, uint32 IndexCount)
+{
+    for(uint32 t = 0; t + 2 < IndexCount; t += 3)
+    {
+        vec3f V0, V1, V2;
+        if(!OcclusionProject(MVP, Positions[Indices[t+0]], &V0) ||
+           !OcclusionProject(MVP, Positions[Indices[t+1]], &V1) ||
+           !OcclusionProject(MVP, Positions[Indices[t+2]], &V2))
+        {
+            continue;
+        }
+
+        real32 Area = (V1.x - V0.x) * (V2.y - V0.y) - (V2.x - V0.x) * (V1.y - V0.y);
+        if(Area <= 0.f)
+        {
+            continue;
+        }
+
+        real32 Depth = Max(V0.z, Max(V1.z, V2.z));
+        int32 MinX = Max((int32)floorf(Min(V0.x, Min(V1.x, V2.x))), 0);
+        int32 MaxX = Min((int32)ceilf(Max(V0.x, Max(V1.x, V2.x))), OCCLUSION_WIDTH - 1);
+        int32 MinY = Max((int32)floorf(Min(V0.y, Min(V1.y, V2.y))), 0);
+        int32 MaxY = Min((int32)ceilf(Max(V0.y, Max(V1.y, V2.y))), OCCLUSION_HEIGHT - 1);
+
+        for(int32 y = MinY; y <= MaxY; ++y)
+        {
+            real32 Py = y + 0.5f;
+            for(int32 x = MinX; x <= MaxX; ++x)
+            {
+                real32 Px = x + 0.5f;
+                real32 E0 = (V1.x - V0.x) * (Py - V0.y) - (V1.y - V0.y) * (Px - V0.x);
+                real32 E1 = (V2.x - V1.x) * (Py - V1.y) - (V2.y - V1.y) * (Px - V1.x);
+                real32 E2 = (V0.x - V2.x) * (Py - V2.y) - (V0.y - V2.y) * (Px - V2.x);
+                if(E0 >= 0.f && E1 >= 0.f && E2 >= 0.f)
+                {
+                    real32 *Pixel = &Buffer->Depth[y * OCCLUSION_WIDTH + x];
+                    *Pixel = Min(*Pixel, Depth);
+                }
+            }
+        }
+    }
+}
+
+// NOTE - The box's screen rectangle, grown by a pixel for the coarse coverage, is
+// occluded when every pixel in it is nearer than the box's nearest point.
+bool IsBoxOccluded(occlusion_buffer *Buffer, mat4f const &MVP, vec3f BoxMin, vec3f BoxMax)
+{
+    vec3f RectMin(CULL_INFINITE_RADIUS), RectMax(-CULL_INFINITE_RADIUS);
+    for(uint32 i = 0; i < 8; ++i)
+    {
+        vec3f Corner((i & 1) ? BoxMax.x : BoxMin.x, (i & 2) ? BoxMax.y : BoxMin.y, (i & 4) ? BoxMax.z : BoxMin.z);
+        vec3f Window;
+        if(!OcclusionProject(MVP, Corner, &Window))
+        {
+            return false;
+        }
+        RectMin = vec3f(Min(RectMin.x, Window.x), Min(RectMin.y, Window.y), Min(RectMin.z, Window.z));
+        RectMax = vec3f(Max(RectMax.x, Window.x), Max(RectMax.y, Window.y), Max(RectMax.z, Window.z));
+    }
+
+    int32 MinX = Max((int32)floorf(RectMin.x) - 1, 0);
+    int32 MaxX = Min((int32)ceilf(RectMax.x) + 1, OCCLUSION_WIDTH - 1);
+    int32 MinY = Max((int32)floorf(RectMin.y) - 1, 0);
+    int32 MaxY = Min((int32)ceilf(RectMax.y) + 1, OCCLUSION_HEIGHT - 1);
+    if(MinX > MaxX || MinY > MaxY)
+    {
+        return false;
+    }
+
+    for(int32 y = MinY; y <= MaxY; ++y)
+    {
+        for(int32 x = MinX; x <= MaxX; ++x)
+        {
+            if(Buffer->Depth[y * OCCLUSION_WIDTH + x] >= RectMin.z)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+#endif
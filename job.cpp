@@ -0,0 +1,306 @@
+#ifndef JOB_CPP
+#define JOB_CPP
+
+// NOTE - Work-stealing job system.
+// Each thread (main = 0, workers = 1..N) owns a fixed-size Chase-Lev deque :
+// the owner pushes and pops at the Bottom (LIFO, cache-warm), idle threads
+// steal from the Top of the others (FIFO, oldest and usually biggest jobs).
+// Idle workers sleep on a semaphore signaled at each submission.
+// Indices grow forever and are compared by difference, so wrapping is fine.
+#define JOB_DEQUE_SIZE 1024
+
+struct job_deque
+{
+    int32 volatile Top;     // Thieves' end
+    uint8 _Pad0[60];
+    int32 volatile Bottom;  // Owner's end
+    uint8 _Pad1[60];
+    job Entries[JOB_DEQUE_SIZE];
+};
+
+struct job_worker
+{
+    platform_thread Thread;
+    uint32 Index;
+};
+
+struct job_system
+{
+    job_deque Deques[MAX_JOB_THREADS];
+    job_worker Workers[MAX_JOB_THREADS];
+    uint32 ThreadCount;
+
+    platform_semaphore WakeUp;
+    int32 volatile IsRunning;
+};
+
+static job_system *GlobalJobSystem = NULL;
+
+// NOTE - -1 for threads the job system doesn't know about : they can still
+// submit (jobs are run inline) and wait (by stealing).
+static THREAD_LOCAL int32 JobThreadIndex = -1;
+
+// NOTE - Scratch arena given to the jobs run by this thread. The main thread's is
+// the frame ScratchArena, workers claim a thread_scratch for their whole life.
+// Threads without one borrow a thread_scratch for each job.
+static THREAD_LOCAL memory_arena *JobScratchArena = NULL;
+static game_memory *JobMemory = NULL;
+
+static inline int32 _DequeDistance(int32 From, int32 To)
+{
+    return (int32)((uint32)To - (uint32)From);
+}
+
+static inline int32 _DequeNext(int32 Index, int32 Offset = 1)
+{
+    return (int32)((uint32)Index + (uint32)Offset);
+}
+
+// NOTE - Owner only. Returns false when full.
+static bool DequePush(job_deque *Deque, job *Job)
+{
+    int32 Bottom = Deque->Bottom;
+    int32 Top = AtomicLoad32(&Deque->Top);
+    if(_DequeDistance(Top, Bottom) >= JOB_DEQUE_SIZE)
+    {
+        return false;
+    }
+
+    Deque->Entries[Bottom & (JOB_DEQUE_SIZE - 1)] = *Job;
+
+    // NOTE - Publishes the entry to the thieves
+    AtomicExchange32(&Deque->Bottom, _DequeNext(Bottom));
+    return true;
+}
+
+// NOTE - Owner only
+static bool DequePop(job_deque *Deque, job *Job)
+{
+    int32 Bottom = _DequeNext(Deque->Bottom, -1);
+
+    // NOTE - Bottom must be visible to thieves before reading Top
+    AtomicExchange32(&Deque->Bottom, Bottom);
+    int32 Top = AtomicLoad32(&Deque->Top);
+
+    int32 Remaining = _DequeDistance(Top, Bottom);
+    if(Remaining < 0)
+    {
+        // NOTE - Was empty
+        AtomicExchange32(&Deque->Bottom, Top);
+        return false;
+    }
+
+    *Job = Deque->Entries[Bottom & (JOB_DEQUE_SIZE - 1)];
+    if(Remaining > 0)
+    {
+        return true;
+    }
+
+    // NOTE - Last job : race the thieves for it
+    bool Won = AtomicCompareExchange32(&Deque->Top, Top, _DequeNext(Top));
+    AtomicExchange32(&Deque->Bottom, _DequeNext(Top));
+    return Won;
+}
+
+// NOTE - Any thread
+static bool DequeSteal(job_deque *Deque, job *Job)
+{
+    int32 Top = AtomicLoad32(&Deque->Top);
+    int32 Bottom = AtomicLoad32(&Deque->Bottom);
+    if(_DequeDistance(Top, Bottom) <= 0)
+    {
+        return false;
+    }
+
+    // NOTE - The copy is only valid if we win the CAS, otherwise discarded
+    *Job = Deque->Entries[Top & (JOB_DEQUE_SIZE - 1)];
+    return AtomicCompareExchange32(&Deque->Top, Top, _DequeNext(Top));
+}
+
+// NOTE - Spins until another thread releases one. Jobs are short, a borrowed
+// arena comes back quickly.
+static memory_arena *WaitForScratchArena()
+{
+    memory_arena *Scratch = AcquireScratchArena(JobMemory);
+    while(!Scratch)
+    {
+        CPUPause();
+        Scratch = AcquireScratchArena(JobMemory);
+    }
+    return Scratch;
+}
+
+static void ExecuteJob(job *Job)
+{
+    memory_arena *Scratch = JobScratchArena;
+    bool Borrowed = !Scratch;
+    if(Borrowed)
+    {
+        Scratch = WaitForScratchArena();
+    }
+
+    temp_memory Temp = BeginTempMemory(Scratch);
+    Job->Function(Job->Data, Scratch);
+    EndTempMemory(Temp);
+
+    if(Borrowed)
+    {
+        ReleaseScratchArena(JobMemory, Scratch);
+    }
+    if(Job->Counter)
+    {
+        AtomicAdd32(&Job->Counter->Value, -1);
+    }
+}
+
+// NOTE - Own deque first, then try to steal from the others, starting with the next one
+static bool RunOneJob(job_system *JobSystem, int32 Self)
+{
+    job Job;
+    if(Self >= 0 && DequePop(&JobSystem->Deques[Self], &Job))
+    {
+        ExecuteJob(&Job);
+        return true;
+    }
+
+    uint32 Start = (uint32)(Self + 1);
+    for(uint32 i = 0; i < JobSystem->ThreadCount; ++i)
+    {
+        uint32 Victim = (Start + i) % JobSystem->ThreadCount;
+        if((int32)Victim != Self && DequeSteal(&JobSystem->Deques[Victim], &Job))
+        {
+            ExecuteJob(&Job);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void JobWorkerThread(void *Param)
+{
+    job_worker *Worker = (job_worker*)Param;
+    job_system *JobSystem = GlobalJobSystem;
+    JobThreadIndex = Worker->Index;
+    JobScratchArena = WaitForScratchArena();
+
+    while(AtomicLoad32(&JobSystem->IsRunning))
+    {
+        if(!RunOneJob(JobSystem, JobThreadIndex))
+        {
+            PlatformWaitSemaphore(&JobSystem->WakeUp);
+        }
+    }
+
+    ReleaseScratchArena(JobMemory, JobScratchArena);
+    JobScratchArena = NULL;
+}
+
+SUBMIT_JOBS(SubmitJobs)
+{
+    if(Counter)
+    {
+        AtomicAdd32(&Counter->Value, (int32)Count);
+    }
+
+    job_system *JobSystem = GlobalJobSystem;
+    int32 Self = JobThreadIndex;
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        job Job = Jobs[i];
+        Job.Counter = Counter;
+
+        // NOTE - Unknown thread, or deque full : do it right away
+        if(!JobSystem || Self < 0 || !DequePush(&JobSystem->Deques[Self], &Job))
+        {
+            ExecuteJob(&Job);
+        }
+    }
+
+    if(JobSystem && JobSystem->ThreadCount > 1)
+    {
+        PlatformSignalSemaphore(&JobSystem->WakeUp, Min(Count, JobSystem->ThreadCount - 1));
+    }
+}
+
+WAIT_FOR_COUNTER(WaitForCounter)
+{
+    job_system *JobSystem = GlobalJobSystem;
+    while(AtomicLoad32(&Counter->Value) > 0)
+    {
+        if(!JobSystem || !RunOneJob(JobSystem, JobThreadIndex))
+        {
+            CPUPause();
+        }
+    }
+}
+
+// NOTE - One thread per core : the main thread, plus a worker for each other core.
+// Must be called from the main thread.
+void InitJobSystem(game_memory *Memory)
+{
+    job_system *JobSystem = (job_system*)PushArenaStruct(&Memory->SessionArena, job_system);
+    memset(JobSystem, 0, sizeof(job_system));
+
+    uint32 ProcessorCount = PlatformGetProcessorCount();
+    JobSystem->ThreadCount = Clamp(ProcessorCount, 1u, (uint32)MAX_JOB_THREADS);
+    JobSystem->IsRunning = 1;
+
+    JobMemory = Memory;
+    JobScratchArena = &Memory->ScratchArena;
+
+    Memory->Jobs.SubmitJobs = SubmitJobs;
+    Memory->Jobs.WaitForCounter = WaitForCounter;
+    Memory->Jobs.ThreadCount = 1;
+
+    if(!PlatformCreateSemaphore(&JobSystem->WakeUp, 0))
+    {
+        // NOTE - Jobs still work, all run inline on submission
+        printf("Job System : can't create semaphore, running single-threaded.\n");
+        return;
+    }
+
+    GlobalJobSystem = JobSystem;
+    JobThreadIndex = 0;
+
+    for(uint32 i = 1; i < JobSystem->ThreadCount; ++i)
+    {
+        job_worker *Worker = &JobSystem->Workers[i];
+        Worker->Index = i;
+        if(!PlatformCreateThread(&Worker->Thread, JobWorkerThread, Worker))
+        {
+            printf("Job System : can't create worker thread %u.\n", i);
+            JobSystem->ThreadCount = i;
+            break;
+        }
+    }
+
+    Memory->Jobs.ThreadCount = JobSystem->ThreadCount;
+
+    printf("Job System : %u threads.\n", JobSystem->ThreadCount);
+}
+
+void DestroyJobSystem(game_memory *Memory)
+{
+    job_system *JobSystem = GlobalJobSystem;
+    if(!JobSystem)
+    {
+        return;
+    }
+
+    AtomicExchange32(&JobSystem->IsRunning, 0);
+    if(JobSystem->ThreadCount > 1)
+    {
+        PlatformSignalSemaphore(&JobSystem->WakeUp, JobSystem->ThreadCount - 1);
+        for(uint32 i = 1; i < JobSystem->ThreadCount; ++i)
+        {
+            PlatformJoinThread(&JobSystem->Workers[i].Thread);
+        }
+    }
+    PlatformDestroySemaphore(&JobSystem->WakeUp);
+
+    GlobalJobSystem = NULL;
+    Memory->Jobs.ThreadCount = 1;
+}
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef JOB_H
+#define JOB_H
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - Job system interface, shared by the Platform and the Game DLL.
+// The platform owns the worker threads (see job.cpp) and hands out its entry
+// points through game_memory, so the DLL can submit work across reloads
+// without ever touching a thread itself.
+// A job is a function pointer + a data pointer. Completion is tracked with
+// a job_counter : it's incremented on submission, decremented when each job
+// ends, and WaitForCounter returns when it reaches 0. The waiting thread runs
+// pending jobs in the meantime instead of blocking.
+// Jobs get the scratch arena of the thread running them, rolled back when they end.
+//////////////////////////////////////////////////////////////////////////
+
+#define MAX_JOB_THREADS 16
+
+typedef void job_function(void *Data, memory_arena *Scratch);
+
+struct job_counter
+{
+    int32 volatile Value;
+};
+
+struct job
+{
+    job_function *Function;
+    void *Data;
+    job_counter *Counter;   // Set by SubmitJobs
+};
+
+// NOTE - Jobs are copied, the array can be released right after the call.
+// The data they point to must live until the counter reaches 0.
+#define SUBMIT_JOBS(name) void name(job *Jobs, uint32 Count, job_counter *Counter)
+typedef SUBMIT_JOBS(submit_jobs_function);
+
+#define WAIT_FOR_COUNTER(name) void name(job_counter *Counter)
+typedef WAIT_FOR_COUNTER(wait_for_counter_function);
+
+struct job_system_api
+{
+    submit_jobs_function *SubmitJobs;
+    wait_for_counter_function *WaitForCounter;
+    uint32 ThreadCount; // Workers + the main thread
+};
+
+inline job MakeJob(job_function *Function, void *Data)
+{
+    job Job = { Function, Data, NULL };
+    return Job;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - ParallelFor : splits [0, Count) in batches of at least MinBatchSize
+// and calls Function(Data, Start, End) on each, from any thread. Blocking.
+//////////////////////////////////////////////////////////////////////////
+#define PARALLEL_FOR_MAX_JOBS 64
+
+typedef void parallel_for_function(void *Data, uint32 Start, uint32 End, memory_arena *Scratch);
+
+struct parallel_for_range
+{
+    parallel_for_function *Function;
+    void *Data;
+    uint32 Start;
+    uint32 End;
+};
+
+inline void _ParallelForJob(void *Data, memory_arena *Scratch)
+{
+    parallel_for_range *Range = (parallel_for_range*)Data;
+    Range->Function(Range->Data, Range->Start, Range->End, Scratch);
+}
+
+// NOTE - Scratch is the caller's arena, for when everything runs on the calling thread
+inline void ParallelFor(job_system_api *JobSystem, uint32 Count, uint32 MinBatchSize,
+                        parallel_for_function *Function, void *Data, memory_arena *Scratch)
+{
+    if(!Count)
+    {
+        return;
+    }
+
+    uint32 BatchSize = Max(MinBatchSize, (Count + PARALLEL_FOR_MAX_JOBS - 1) / PARALLEL_FOR_MAX_JOBS);
+    BatchSize = Max(BatchSize, 1u);
+    uint32 JobCount = (Count + BatchSize - 1) / BatchSize;
+
+    if(JobCount == 1 || !JobSystem || !JobSystem->SubmitJobs || JobSystem->ThreadCount < 2)
+    {
+        temp_memory Temp = BeginTempMemory(Scratch);
+        Function(Data, 0, Count, Scratch);
+        EndTempMemory(Temp);
+        return;
+    }
+
+    parallel_for_range Ranges[PARALLEL_FOR_MAX_JOBS];
+    job Jobs[PARALLEL_FOR_MAX_JOBS];
+    for(uint32 i = 0; i < JobCount; ++i)
+    {
+        Ranges[i].Function = Function;
+        Ranges[i].Data = Data;
+        Ranges[i].Start = i * BatchSize;
+        Ranges[i].End = Min(Count, (i + 1) * BatchSize);
+        Jobs[i] = MakeJob(_ParallelForJob, &Ranges[i]);
+    }
+
+    job_counter Counter = {};
+    JobSystem->SubmitJobs(Jobs, JobCount, &Counter);
+    JobSystem->WaitForCounter(&Counter);
+}
+
+#endif
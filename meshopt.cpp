@@ -0,0 +1,324 @@
+#ifndef MESHOPT_CPP
+#define MESHOPT_CPP
+
+// NOTE - Index and vertex reordering for the generated meshes, run once when they're
+// built. Triangles are reordered for the post-transform vertex cache with Tom
+// Forsyth's "Linear-Speed Vertex Cache Optimisation", then vertices are reordered
+// in the order the triangles first use them, for the pre-transform fetch.
+// ACMR (average cache miss ratio) is the transformed vertex count per triangle,
+// measured on a FIFO cache : 3 is the worst, 0.5 about the best on a regular grid.
+#define MESH_OPT_CACHE_SIZE 32          // Modeled LRU cache of the optimizer
+#define MESH_OPT_ACMR_CACHE_SIZE 16     // FIFO cache the ACMR is measured with
+#define MESH_OPT_MAX_VALENCE 32         // Valence scores past this are computed
+
+struct mesh_opt_tables
+{
+    real32 CacheScore[MESH_OPT_CACHE_SIZE];
+    real32 ValenceScore[MESH_OPT_MAX_VALENCE];
+};
+
+real32 ComputeACMR(uint32 const *Indices, uint32 IndexCount, uint32 VertexCount, memory_arena *Scratch)
+{
+    if(IndexCount < 3)
+    {
+        return 0.f;
+    }
+
+    // NOTE - A vertex is in the FIFO when fewer than CacheSize misses happened since its own
+    uint32 *Stamps = (uint32*)PushArenaData(Scratch, VertexCount * sizeof(uint32));
+    memset(Stamps, 0, VertexCount * sizeof(uint32));
+
+    uint32 Time = MESH_OPT_ACMR_CACHE_SIZE + 1;
+    uint32 Misses = 0;
+    for(uint32 i = 0; i < IndexCount; ++i)
+    {
+        uint32 V = Indices[i];
+        if(Time - Stamps[V] > MESH_OPT_ACMR_CACHE_SIZE)
+        {
+            Stamps[V] = Time++;
+            ++Misses;
+        }
+    }
+
+    return Misses / (real32)(IndexCount / 3);
+}
+
+static mesh_opt_tables MakeMeshOptTables()
+{
+    mesh_opt_tables Tables;
+    for(uint32 i = 0; i < MESH_OPT_CACHE_SIZE; ++i)
+    {
+        // NOTE - The last triangle's vertices get a fixed score, so that its
+        // neighbours don't get picked in a strip-like order
+        Tables.CacheScore[i] = (i < 3) ? 0.75f : powf(1.f - (i - 3) / (real32)(MESH_OPT_CACHE_SIZE - 3), 1.5f);
+    }
+    for(uint32 i = 0; i < MESH_OPT_MAX_VALENCE; ++i)
+    {
+        Tables.ValenceScore[i] = (i == 0) ? 0.f : 2.f / sqrtf((real32)i);
+    }
+    return Tables;
+}
+
+inline real32 MeshOptVertexScore(mesh_opt_tables const *Tables, int32 CachePos, uint32 Valence)
+{
+    if(Valence == 0)
+    {
+        return -1.f;    // Not used anymore
+    }
+
+    real32 Score = (CachePos >= 0) ? Tables->CacheScore[CachePos] : 0.f;
+    Score += (Valence < MESH_OPT_MAX_VALENCE) ? Tables->ValenceScore[Valence] : 2.f / sqrtf((real32)Valence);
+    return Score;
+}
+
+// NOTE - Dst can't be Indices. Greedy : the next triangle is the best scored among
+// the ones touching the cache, or the first one left when none does.
+void OptimizeVertexCache(uint32 *Dst, uint32 const *Indices, uint32 IndexCount, uint32 VertexCount, memory_arena *Scratch)
+{
+    uint32 TriCount = IndexCount / 3;
+    if(!TriCount)
+    {
+        return;
+    }
+
+    mesh_opt_tables Tables = MakeMeshOptTables();
+
+    // NOTE - Triangles using each vertex, as slices of one array
+    uint32 *Valence = (uint32*)PushArenaData(Scratch, VertexCount * sizeof(uint32));
+    uint32 *AdjOffsets = (uint32*)PushArenaData(Scratch, VertexCount * sizeof(uint32));
+    uint32 *AdjTris = (uint32*)PushArenaData(Scratch, IndexCount * sizeof(uint32));
+    memset(Valence, 0, VertexCount * sizeof(uint32));
+    for(uint32 i = 0; i < IndexCount; ++i)
+    {
+        Valence[Indices[i]]++;
+    }
+    uint32 Offset = 0;
+    for(uint32 v = 0; v < VertexCount; ++v)
+    {
+        AdjOffsets[v] = Offset;
+        Offset += Valence[v];
+        Valence[v] = 0;
+    }
+    for(uint32 i = 0; i < IndexCount; ++i)
+    {
+        uint32 V = Indices[i];
+        AdjTris[AdjOffsets[V] + Valence[V]++] = i / 3;
+    }
+
+    int32 *CachePos = (int32*)PushArenaData(Scratch, VertexCount * sizeof(int32));
+    real32 *VertexScores = (real32*)PushArenaData(Scratch, VertexCount * sizeof(real32));
+    for(uint32 v = 0; v < VertexCount; ++v)
+    {
+        CachePos[v] = -1;
+        VertexScores[v] = MeshOptVertexScore(&Tables, -1, Valence[v]);
+    }
+
+    real32 *TriScores = (real32*)PushArenaData(Scratch, TriCount * sizeof(real32));
+    bool *TriEmitted = (bool*)PushArenaData(Scratch, TriCount * sizeof(bool));
+    int32 BestTri = 0;
+    for(uint32 t = 0; t < TriCount; ++t)
+    {
+        TriScores[t] = VertexScores[Indices[t*3+0]] + VertexScores[Indices[t*3+1]] + VertexScores[Indices[t*3+2]];
+        TriEmitted[t] = false;
+        if(TriScores[t] > TriScores[BestTri])
+        {
+            BestTri = (int32)t;
+        }
+    }
+
+    // NOTE - One more than 3 vertices over the cache : the ones pushed out this step
+    uint32 Cache[MESH_OPT_CACHE_SIZE + 3];
+    uint32 NewCache[MESH_OPT_CACHE_SIZE + 3];
+    uint32 CacheCount = 0;
+    uint32 NextUnemitted = 0;
+
+    for(uint32 Emitted = 0; Emitted < TriCount; ++Emitted)
+    {
+        if(BestTri < 0)
+        {
+            while(TriEmitted[NextUnemitted])
+            {
+                ++NextUnemitted;
+            }
+            BestTri = (int32)NextUnemitted;
+        }
+
+        uint32 const *Tri = &Indices[BestTri * 3];
+        Dst[Emitted*3+0] = Tri[0];
+        Dst[Emitted*3+1] = Tri[1];
+        Dst[Emitted*3+2] = Tri[2];
+        TriEmitted[BestTri] = true;
+
+        // NOTE - Out of the adjacency of its vertices, swapped with the last one
+        uint32 NewCount = 0;
+        for(uint32 k = 0; k < 3; ++k)
+        {
+            uint32 V = Tri[k];
+            uint32 *Adj = &AdjTris[AdjOffsets[V]];
+            for(uint32 a = 0; a < Valence[V]; ++a)
+            {
+                if(Adj[a] == (uint32)BestTri)
+                {
+                    Adj[a] = Adj[--Valence[V]];
+                    break;
+                }
+            }
+            NewCache[NewCount++] = V;
+        }
+
+        // NOTE - LRU : the triangle's vertices first, then the ones already there
+        for(uint32 c = 0; c < CacheCount; ++c)
+        {
+            uint32 V = Cache[c];
+            if(V != Tri[0] && V != Tri[1] && V != Tri[2])
+            {
+                NewCache[NewCount++] = V;
+            }
+        }
+
+        for(uint32 c = 0; c < NewCount; ++c)
+        {
+            uint32 V = NewCache[c];
+            CachePos[V] = (c < MESH_OPT_CACHE_SIZE) ? (int32)c : -1;
+            VertexScores[V] = MeshOptVertexScore(&Tables, CachePos[V], Valence[V]);
+        }
+
+        CacheCount = Min(NewCount, (uint32)MESH_OPT_CACHE_SIZE);
+        memcpy(Cache, NewCache, CacheCount * sizeof(uint32));
+
+        // NOTE - Only the triangles touching the cache changed score
+        BestTri = -1;
+        real32 BestScore = -1.f;
+        for(uint32 c = 0; c < NewCount; ++c)
+        {
+            uint32 V = NewCache[c];
+            uint32 *Adj = &AdjTris[AdjOffsets[V]];
+            for(uint32 a = 0; a < Valence[V]; ++a)
+            {
+                uint32 T = Adj[a];
+                real32 Score = VertexScores[Indices[T*3+0]] + VertexScores[Indices[T*3+1]] + VertexScores[Indices[T*3+2]];
+                TriScores[T] = Score;
+                if(Score > BestScore)
+                {
+                    BestScore = Score;
+                    BestTri = (int32)T;
+                }
+            }
+        }
+    }
+}
+
+// NOTE - Remap[Old] = New, vertices get numbered in the order the indices first use
+// them, unused ones at the end. Rewrites the indices, apply Remap to the vertex
+// data with RemapVertexStream.
+void OptimizeVertexFetch(uint32 *Remap, uint32 *Indices, uint32 IndexCount, uint32 VertexCount)
+{
+    for(uint32 v = 0; v < VertexCount; ++v)
+    {
+        Remap[v] = 0xFFFFFFFF;
+    }
+
+    uint32 Next = 0;
+    for(uint32 i = 0; i < IndexCount; ++i)
+    {
+        uint32 &New = Remap[Indices[i]];
+        if(New == 0xFFFFFFFF)
+        {
+            New = Next++;
+        }
+        Indices[i] = New;
+    }
+
+    for(uint32 v = 0; v < VertexCount; ++v)
+    {
+        if(Remap[v] == 0xFFFFFFFF)
+        {
+            Remap[v] = Next++;
+        }
+    }
+}
+
+void RemapVertexStream(void *Data, uint32 Stride, uint32 VertexCount, uint32 const *Remap, memory_arena *Scratch)
+{
+    uint8 *Copy = (uint8*)PushArenaData(Scratch, (uint64)VertexCount * Stride);
+    memcpy(Copy, Data, (size_t)VertexCount * Stride);
+    for(uint32 v = 0; v < VertexCount; ++v)
+    {
+        memcpy((uint8*)Data + (size_t)Remap[v] * Stride, Copy + (size_t)v * Stride, Stride);
+    }
+}
+
+// NOTE - IEEE half, rounded to nearest. Values too small for a normal half become 0,
+// too big ones infinity : fine for vertex data.
+uint16 FloatToHalf(real32 Value)
+{
+    uint32 Bits;
+    memcpy(&Bits, &Value, sizeof(Bits));
+
+    uint32 Sign = (Bits >> 16) & 0x8000;
+    int32 Exponent = (int32)((Bits >> 23) & 0xFF) - 127 + 15;
+    uint32 Mantissa = Bits & 0x7FFFFF;
+    if(Exponent <= 0)
+    {
+        return (uint16)Sign;
+    }
+    if(Exponent >= 31)
+    {
+        return (uint16)(Sign | 0x7C00);
+    }
+
+    // NOTE - A carry out of the mantissa correctly bumps the exponent
+    uint32 Half = Sign | ((uint32)Exponent << 10) | (Mantissa >> 13);
+    if(Mantissa & 0x1000)
+    {
+        ++Half;
+    }
+    return (uint16)Half;
+}
+
+// NOTE - Octahedral mapping : the unit sphere projected on the |x|+|y|+|z| = 1
+// octahedron, whose lower half is folded over the upper one, to 2 snorm16.
+// Decoded by OctDecodeNormal in vert.glsl. A zero normal decodes as +Z.
+void OctEncodeNormal(vec3f N, int16 *Encoded)
+{
+    real32 L1 = fabsf(N.x) + fabsf(N.y) + fabsf(N.z);
+    real32 X = 0.f, Y = 0.f;
+    if(L1 > 0.f)
+    {
+        X = N.x / L1;
+        Y = N.y / L1;
+        if(N.z < 0.f)
+        {
+            real32 FoldX = (1.f - fabsf(Y)) * (X >= 0.f ? 1.f : -1.f);
+            real32 FoldY = (1.f - fabsf(X)) * (Y >= 0.f ? 1.f : -1.f);
+            X = FoldX;
+            Y = FoldY;
+        }
+    }
+
+    Encoded[0] = (int16)roundf(Clamp(X, -1.f, 1.f) * 32767.f);
+    Encoded[1] = (int16)roundf(Clamp(Y, -1.f, 1.f) * 32767.f);
+}
+
+// NOTE - Cache order in place, then the fetch order when Remap is given. Logs the
+// ACMR before and after.
+void OptimizeMeshIndices(char const *Name, uint32 *Indices, uint32 IndexCount, uint32 VertexCount,
+                         uint32 *Remap, memory_arena *Scratch)
+{
+    real32 ACMRBefore = ComputeACMR(Indices, IndexCount, VertexCount, Scratch);
+
+    uint32 *Optimized = (uint32*)PushArenaData(Scratch, IndexCount * sizeof(uint32));
+    OptimizeVertexCache(Optimized, Indices, IndexCount, VertexCount, Scratch);
+    memcpy(Indices, Optimized, IndexCount * sizeof(uint32));
+
+    if(Remap)
+    {
+        OptimizeVertexFetch(Remap, Indices, IndexCount, VertexCount);
+    }
+
+    real32 ACMRAfter = ComputeACMR(Indices, IndexCount, VertexCount, Scratch);
+    printf("Mesh %s : %u vertices, %u triangles, ACMR %.3f -> %.3f\n", Name, VertexCount, IndexCount / 3,
+           ACMRBefore, ACMRAfter);
+}
+
+#endif
@@ -0,0 +1,694 @@
+#ifndef PROFILER_CPP
+#define PROFILER_CPP
+
+#if RADAR_PROFILE
+
+#define PROFILE_MAIN_ROOT   0xFFFFFFFF
+#define PROFILE_WORKER_ROOT 0xFFFFFFFE
+
+profiler *GlobalProfiler = NULL;
+THREAD_LOCAL int32 ProfileThreadIndex = -1;
+gpu_profiler *GlobalGpuProfiler = NULL;
+
+// NOTE - Must be called from the main thread, which becomes thread 0
+void InitProfiler(game_memory *Memory, char const *CaptureDir)
+{
+    profiler *Profiler = (profiler*)PushArenaStruct(&Memory->SessionArena, profiler);
+    memset(Profiler, 0, sizeof(profiler));
+    InitMap(&Profiler->NodeMap, &Memory->SessionArena, 2 * PROFILE_MAX_NODES);
+
+    strncpy(Profiler->CaptureDir, CaptureDir, MAX_PATH - 1);
+    Profiler->CaptureThreshold = (real32)Memory->Config.CaptureThresholdMs;
+
+    // NOTE - Rough first calibration, refined every frame afterwards
+    real64 WallStart = PlatformGetWallClock();
+    uint64 ClockStart = ReadCPUTimer();
+    while(PlatformGetWallClock() - WallStart < 0.005) {}
+    Profiler->CyclesPerSecond = (ReadCPUTimer() - ClockStart) / (PlatformGetWallClock() - WallStart);
+
+    Profiler->CurrentFrame = &Profiler->Frames[0];
+    Profiler->CurrentFrame->BeginClock = ReadCPUTimer();
+    Profiler->FrameBeginWallClock = PlatformGetWallClock();
+
+    ProfileThreadIndex = 0;
+    Profiler->ThreadCount = 1;
+    GlobalProfiler = Profiler;
+}
+
+static uint32 GetProfileNode(profiler *Profiler, char const *Name, uint32 Parent, uint32 Depth)
+{
+    uint64 Key = ((uint64)HashString(Name, (uint32)strlen(Name)) << 32) | Parent;
+    uint32 *Found = MapFind(&Profiler->NodeMap, Key);
+    if(Found)
+    {
+        return *Found;
+    }
+
+    if(Profiler->NodeCount >= PROFILE_MAX_NODES)
+    {
+        return PROFILE_MAIN_ROOT;
+    }
+
+    uint32 NodeIdx = Profiler->NodeCount++;
+    profile_node *Node = &Profiler->Nodes[NodeIdx];
+    memset(Node, 0, sizeof(profile_node));
+    Node->Name = Name;
+    Node->Parent = Parent;
+    Node->Depth = Depth;
+    MapInsert(&Profiler->NodeMap, Key, NodeIdx);
+    return NodeIdx;
+}
+
+static void ComputeHistoryStats(real32 *History, uint32 Count, real32 *OutMin, real32 *OutAvg, real32 *OutMax)
+{
+    real32 Lo = Count ? 1e9f : 0.f, Sum = 0.f, Hi = 0.f;
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        Lo = Min(Lo, History[i]);
+        Hi = Max(Hi, History[i]);
+        Sum += History[i];
+    }
+    *OutMin = Lo;
+    *OutAvg = Count ? Sum / Count : 0.f;
+    *OutMax = Hi;
+}
+
+// NOTE - Rebuilds the zone hierarchy from the raw events of a frame, per thread.
+// Blocks that straddle the frame boundary aren't counted.
+static void ProcessProfileFrame(profiler *Profiler, profile_frame *Frame, uint32 Slot)
+{
+    struct open_block
+    {
+        uint32 Node;
+        uint64 Clock;
+    };
+    open_block Stacks[PROFILE_MAX_THREADS][PROFILE_MAX_DEPTH];
+    uint32 Depths[PROFILE_MAX_THREADS] = {};
+    uint32 Overflows[PROFILE_MAX_THREADS] = {};
+
+    for(uint32 i = 0; i < Profiler->NodeCount; ++i)
+    {
+        Profiler->Nodes[i].FrameCycles = 0;
+        Profiler->Nodes[i].FrameCalls = 0;
+    }
+
+    uint32 EventCount = Min((uint32)Frame->EventCount, (uint32)PROFILE_MAX_EVENTS);
+    if((uint32)Frame->EventCount > PROFILE_MAX_EVENTS)
+    {
+        Profiler->DroppedEvents += Frame->EventCount - PROFILE_MAX_EVENTS;
+    }
+
+    for(uint32 i = 0; i < EventCount; ++i)
+    {
+        profile_event *Event = &Frame->Events[i];
+        uint32 Thread = Event->ThreadIndex;
+        if(Thread >= PROFILE_MAX_THREADS)
+        {
+            continue;
+        }
+
+        uint32 &Depth = Depths[Thread];
+        if(Event->Type == PROFILE_BEGIN)
+        {
+            if(Depth == PROFILE_MAX_DEPTH)
+            {
+                Overflows[Thread]++;
+                continue;
+            }
+
+            uint32 Parent = Depth ? Stacks[Thread][Depth-1].Node : (Thread ? PROFILE_WORKER_ROOT : PROFILE_MAIN_ROOT);
+            open_block *Block = &Stacks[Thread][Depth++];
+            Block->Node = GetProfileNode(Profiler, Event->Name, Parent, Depth - 1);
+            Block->Clock = Event->Clock;
+        }
+        else
+        {
+            if(Overflows[Thread])
+            {
+                Overflows[Thread]--;
+                continue;
+            }
+            if(!Depth)
+            {
+                // NOTE - Opened in the previous frame
+                continue;
+            }
+
+            open_block *Block = &Stacks[Thread][--Depth];
+            if(Block->Node < Profiler->NodeCount)
+            {
+                profile_node *Node = &Profiler->Nodes[Block->Node];
+                Node->FrameCycles += Event->Clock - Block->Clock;
+                Node->FrameCalls++;
+            }
+        }
+    }
+
+    real64 MsPerCycle = 1000.0 / Frame->CyclesPerSecond;
+    uint32 HistoryCount = Min(Profiler->FrameIndex + 1, (uint32)PROFILE_HISTORY);
+    for(uint32 i = 0; i < Profiler->NodeCount; ++i)
+    {
+        profile_node *Node = &Profiler->Nodes[i];
+        Node->History[Slot] = (real32)(Node->FrameCycles * MsPerCycle);
+        Node->Calls = Node->FrameCalls;
+        ComputeHistoryStats(Node->History, HistoryCount, &Node->Min, &Node->Avg, &Node->Max);
+    }
+
+    Profiler->FrameHistory[Slot] = (real32)((Frame->EndClock - Frame->BeginClock) * MsPerCycle);
+    ComputeHistoryStats(Profiler->FrameHistory, HistoryCount, &Profiler->FrameMin, &Profiler->FrameAvg, &Profiler->FrameMax);
+}
+
+// NOTE - Closes the current frame, processes it, and starts recording the next one
+void ProfileNewFrame()
+{
+    profiler *Profiler = GlobalProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    profile_frame *Frame = Profiler->CurrentFrame;
+    uint64 EndClock = ReadCPUTimer();
+    real64 WallClock = PlatformGetWallClock();
+
+    // NOTE - Everything since InitProfiler is startup (context, assets, envmaps),
+    // not a frame : it would go over the capture threshold on every launch
+    if(!Profiler->LoopStarted)
+    {
+        Profiler->LoopStarted = true;
+        Frame->EventCount = 0;
+        Frame->BeginClock = EndClock;
+        Profiler->FrameBeginWallClock = WallClock;
+        return;
+    }
+
+    // NOTE - The cycle counter rate isn't known exactly (and might not be constant
+    // on old CPUs) : measure it against the wall clock over each frame, smoothed.
+    real64 WallElapsed = WallClock - Profiler->FrameBeginWallClock;
+    if(WallElapsed > 0.0)
+    {
+        real64 Measured = (EndClock - Frame->BeginClock) / WallElapsed;
+        Profiler->CyclesPerSecond = 0.9 * Profiler->CyclesPerSecond + 0.1 * Measured;
+    }
+    Frame->EndClock = EndClock;
+    Frame->CyclesPerSecond = Profiler->CyclesPerSecond;
+
+    uint32 Slot = Profiler->FrameIndex % PROFILE_HISTORY;
+    ProcessProfileFrame(Profiler, Frame, Slot);
+
+    if(Profiler->CaptureCooldown)
+    {
+        Profiler->CaptureCooldown--;
+    }
+    else if(Profiler->CaptureThreshold > 0.f && Profiler->FrameHistory[Slot] > Profiler->CaptureThreshold)
+    {
+        printf("Profiler : %.2fms frame, over the %.0fms capture threshold.\n", Profiler->FrameHistory[Slot], Profiler->CaptureThreshold);
+        Profiler->CaptureRequested = true;
+    }
+
+    Profiler->FrameIndex++;
+    profile_frame *NextFrame = &Profiler->Frames[Profiler->FrameIndex % PROFILE_HISTORY];
+    NextFrame->EventCount = 0;
+    NextFrame->BeginClock = EndClock;
+    Profiler->FrameBeginWallClock = WallClock;
+    Profiler->CurrentFrame = NextFrame;
+}
+
+// NOTE - Chrome Trace Event format, written by hand : a capture is up to
+// PROFILE_HISTORY * PROFILE_MAX_EVENTS events, too many to build a cJSON tree.
+// One track per profiler thread, plus a track with the frame boundaries.
+// Timestamps are in microseconds since the start of the oldest frame.
+static bool ProfilerWriteTrace(profiler *Profiler, char const *Filename)
+{
+    FILE *fp = fopen(Filename, "w");
+    if(!fp)
+    {
+        printf("Profiler : can't open %s for writing.\n", Filename);
+        return false;
+    }
+
+    // NOTE - The slot being recorded holds the oldest frame once the ring is full
+    uint32 FrameCount = Min(Profiler->FrameIndex, (uint32)PROFILE_HISTORY - 1);
+    uint32 FirstFrame = Profiler->FrameIndex - FrameCount;
+    uint32 ThreadCount = Min((uint32)Profiler->ThreadCount, (uint32)PROFILE_MAX_THREADS);
+    uint32 FrameTrack = PROFILE_MAX_THREADS;
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Radar\"}}");
+    fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"Frames\"}}", FrameTrack);
+    for(uint32 i = 0; i < ThreadCount; ++i)
+    {
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}",
+                i, i ? "Thread" : "Main", i);
+    }
+
+    real64 FrameStart = 0.0;
+    for(uint32 f = 0; f < FrameCount; ++f)
+    {
+        uint32 FrameNumber = FirstFrame + f;
+        profile_frame *Frame = &Profiler->Frames[FrameNumber % PROFILE_HISTORY];
+        real64 UsPerCycle = 1e6 / Frame->CyclesPerSecond;
+        real64 FrameDuration = (Frame->EndClock - Frame->BeginClock) * UsPerCycle;
+
+        fprintf(fp, ",\n{\"name\":\"Frame %u\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                FrameNumber, FrameTrack, FrameStart, FrameDuration);
+
+        uint32 EventCount = Min((uint32)Frame->EventCount, (uint32)PROFILE_MAX_EVENTS);
+        for(uint32 i = 0; i < EventCount; ++i)
+        {
+            profile_event *Event = &Frame->Events[i];
+            real64 Time = FrameStart + (real64)(int64)(Event->Clock - Frame->BeginClock) * UsPerCycle;
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}",
+                    Event->Name, Event->Type == PROFILE_BEGIN ? 'B' : 'E', Event->ThreadIndex, Time);
+        }
+
+        FrameStart += FrameDuration;
+    }
+
+    fprintf(fp, "\n]}\n");
+    bool Valid = !ferror(fp);
+    fclose(fp);
+
+    if(Valid)
+    {
+        printf("Profiler : %u frames captured in %s.\n", FrameCount, Filename);
+    }
+    else
+    {
+        printf("Profiler : error writing %s.\n", Filename);
+    }
+    return Valid;
+}
+
+void ProfilerApplyConfig(game_config const *Config)
+{
+    if(GlobalProfiler)
+    {
+        GlobalProfiler->CaptureThreshold = (real32)Config->CaptureThresholdMs;
+    }
+}
+
+// NOTE - Dumps the last frames to CaptureDir on F4, or when a frame went over the
+// threshold. The ring is refilled before the threshold can trigger another capture,
+// so that a slow stretch doesn't write a file per frame (writing one is a hitch too).
+void ProfilerUpdateCapture(game_input *Input)
+{
+    profiler *Profiler = GlobalProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    if(KEY_UP(Input->KeyF4))
+    {
+        Profiler->CaptureRequested = true;
+    }
+
+    if(!Profiler->CaptureRequested)
+    {
+        return;
+    }
+    Profiler->CaptureRequested = false;
+    Profiler->CaptureCooldown = PROFILE_HISTORY;
+
+    if(!PlatformMakeDirectory(Profiler->CaptureDir))
+    {
+        printf("Profiler : can't create %s.\n", Profiler->CaptureDir);
+        return;
+    }
+
+    char Date[32];
+    time_t Now = time(NULL);
+    strftime(Date, sizeof(Date), "%Y%m%d_%H%M%S", localtime(&Now));
+
+    path Filename;
+    int Length = snprintf(Filename, MAX_PATH, "%strace_%s_%u.json", Profiler->CaptureDir, Date, Profiler->FrameIndex);
+    if(Length < 0 || Length >= MAX_PATH)
+    {
+        printf("Profiler : capture path too long in %s.\n", Profiler->CaptureDir);
+        return;
+    }
+    ProfilerWriteTrace(Profiler, Filename);
+}
+
+// NOTE - Needs a valid GL context. Disabled without timer queries (GL 3.3).
+// LogPath can be NULL, otherwise every resolved frame is appended to it.
+void InitGpuProfiler(game_memory *Memory, char const *LogPath)
+{
+    if(!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query)
+    {
+        printf("GPU Profiler : no timer queries available, disabled.\n");
+        return;
+    }
+
+    gpu_profiler *Profiler = (gpu_profiler*)PushArenaStruct(&Memory->SessionArena, gpu_profiler);
+    memset(Profiler, 0, sizeof(gpu_profiler));
+
+    for(uint32 i = 0; i < GPU_PROFILE_LATENCY; ++i)
+    {
+        gpu_profile_frame *Frame = &Profiler->Frames[i];
+        glGenQueries(GPU_PROFILE_QUERIES, Frame->Queries);
+    }
+
+    if(LogPath)
+    {
+        Profiler->Log = fopen(LogPath, "w");
+        if(Profiler->Log)
+        {
+            fprintf(Profiler->Log, "# frame : total ms | zone ms ...\n");
+        }
+        else
+        {
+            printf("GPU Profiler : can't open %s for writing.\n", LogPath);
+        }
+    }
+
+    GlobalGpuProfiler = Profiler;
+}
+
+void DestroyGpuProfiler()
+{
+    gpu_profiler *Profiler = GlobalGpuProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    for(uint32 i = 0; i < GPU_PROFILE_LATENCY; ++i)
+    {
+        gpu_profile_frame *Frame = &Profiler->Frames[i];
+        glDeleteQueries(GPU_PROFILE_QUERIES, Frame->Queries);
+    }
+
+    if(Profiler->Log)
+    {
+        fclose(Profiler->Log);
+    }
+
+    GlobalGpuProfiler = NULL;
+}
+
+static gpu_zone_stats *GetGpuZoneStats(gpu_profiler *Profiler, char const *Name, uint32 Depth)
+{
+    for(uint32 i = 0; i < Profiler->ZoneCount; ++i)
+    {
+        gpu_zone_stats *Zone = &Profiler->Zones[i];
+        if(Zone->Name == Name || !strcmp(Zone->Name, Name))
+        {
+            return Zone;
+        }
+    }
+
+    if(Profiler->ZoneCount >= GPU_PROFILE_MAX_ZONES)
+    {
+        return NULL;
+    }
+
+    gpu_zone_stats *Zone = &Profiler->Zones[Profiler->ZoneCount++];
+    memset(Zone, 0, sizeof(gpu_zone_stats));
+    Zone->Name = Name;
+    Zone->Depth = Depth;
+    return Zone;
+}
+
+// NOTE - Zones with the same name are summed over the frame
+static void ResolveGpuFrame(gpu_profiler *Profiler, gpu_profile_frame *Frame)
+{
+    // NOTE - All queries complete in order, the last one issued tells for all
+    uint32 LastQuery = Frame->Queries[1];
+    GLuint Available = 0;
+    glGetQueryObjectuiv(LastQuery, GL_QUERY_RESULT_AVAILABLE, &Available);
+    if(!Available)
+    {
+        Profiler->LateFrames++;
+        return;
+    }
+
+    uint32 QueryCount = 2 + 2 * Frame->ZoneCount;
+    GLuint64 Timestamps[GPU_PROFILE_QUERIES];
+    for(uint32 i = 0; i < QueryCount; ++i)
+    {
+        glGetQueryObjectui64v(Frame->Queries[i], GL_QUERY_RESULT, &Timestamps[i]);
+    }
+
+    uint32 Slot = Profiler->ResolvedCount % PROFILE_HISTORY;
+    uint32 HistoryCount = Min(Profiler->ResolvedCount + 1, (uint32)PROFILE_HISTORY);
+    for(uint32 i = 0; i < Profiler->ZoneCount; ++i)
+    {
+        Profiler->Zones[i].History[Slot] = 0.f;
+    }
+
+    for(uint32 i = 0; i < Frame->ZoneCount; ++i)
+    {
+        gpu_zone_stats *Zone = GetGpuZoneStats(Profiler, Frame->ZoneNames[i], Frame->ZoneDepths[i]);
+        if(Zone)
+        {
+            GLuint64 Begin = Timestamps[2 + 2 * i], End = Timestamps[3 + 2 * i];
+            Zone->History[Slot] += (End > Begin) ? (real32)((End - Begin) * 1e-6) : 0.f;
+        }
+    }
+
+    GLuint64 FrameBegin = Timestamps[0], FrameEnd = Timestamps[1];
+    Profiler->FrameHistory[Slot] = (FrameEnd > FrameBegin) ? (real32)((FrameEnd - FrameBegin) * 1e-6) : 0.f;
+
+    for(uint32 i = 0; i < Profiler->ZoneCount; ++i)
+    {
+        gpu_zone_stats *Zone = &Profiler->Zones[i];
+        ComputeHistoryStats(Zone->History, HistoryCount, &Zone->Min, &Zone->Avg, &Zone->Max);
+    }
+    ComputeHistoryStats(Profiler->FrameHistory, HistoryCount, &Profiler->FrameMin, &Profiler->FrameAvg, &Profiler->FrameMax);
+
+    if(Profiler->Log)
+    {
+        fprintf(Profiler->Log, "%u : %.3f", Profiler->ResolvedCount, Profiler->FrameHistory[Slot]);
+        for(uint32 i = 0; i < Profiler->ZoneCount; ++i)
+        {
+            fprintf(Profiler->Log, " | %s %.3f", Profiler->Zones[i].Name, Profiler->Zones[i].History[Slot]);
+        }
+        fprintf(Profiler->Log, "\n");
+    }
+
+    Profiler->ResolvedCount++;
+}
+
+// NOTE - Reads back the frame that used this set of queries GPU_PROFILE_LATENCY
+// frames ago, then starts recording a new one with them
+void GpuProfileBeginFrame()
+{
+    gpu_profiler *Profiler = GlobalGpuProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    gpu_profile_frame *Frame = &Profiler->Frames[Profiler->FrameIndex % GPU_PROFILE_LATENCY];
+    if(Frame->Issued)
+    {
+        ResolveGpuFrame(Profiler, Frame);
+    }
+
+    Frame->ZoneCount = 0;
+    Frame->Issued = false;
+    Profiler->ZoneDepth = 0;
+    glQueryCounter(Frame->Queries[0], GL_TIMESTAMP);
+}
+
+void GpuProfileEndFrame()
+{
+    gpu_profiler *Profiler = GlobalGpuProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    gpu_profile_frame *Frame = &Profiler->Frames[Profiler->FrameIndex % GPU_PROFILE_LATENCY];
+    Assert(Profiler->ZoneDepth == 0);
+    glQueryCounter(Frame->Queries[1], GL_TIMESTAMP);
+    Frame->Issued = true;
+    Profiler->FrameIndex++;
+}
+
+void GpuProfileBeginZone(char const *Name)
+{
+    gpu_profiler *Profiler = GlobalGpuProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    gpu_profile_frame *Frame = &Profiler->Frames[Profiler->FrameIndex % GPU_PROFILE_LATENCY];
+    int32 ZoneIdx = -1;
+    if(Frame->ZoneCount < GPU_PROFILE_MAX_ZONES)
+    {
+        ZoneIdx = Frame->ZoneCount++;
+        Frame->ZoneNames[ZoneIdx] = Name;
+        Frame->ZoneDepths[ZoneIdx] = Profiler->ZoneDepth;
+        glQueryCounter(Frame->Queries[2 + 2 * ZoneIdx], GL_TIMESTAMP);
+    }
+    else
+    {
+        Profiler->DroppedZones++;
+    }
+
+    if(Profiler->ZoneDepth < GPU_PROFILE_MAX_DEPTH)
+    {
+        Profiler->ZoneStack[Profiler->ZoneDepth] = ZoneIdx;
+    }
+    Profiler->ZoneDepth++;
+}
+
+void GpuProfileEndZone()
+{
+    gpu_profiler *Profiler = GlobalGpuProfiler;
+    if(!Profiler || !Profiler->ZoneDepth)
+    {
+        return;
+    }
+
+    gpu_profile_frame *Frame = &Profiler->Frames[Profiler->FrameIndex % GPU_PROFILE_LATENCY];
+    Profiler->ZoneDepth--;
+    int32 ZoneIdx = (Profiler->ZoneDepth < GPU_PROFILE_MAX_DEPTH) ? Profiler->ZoneStack[Profiler->ZoneDepth] : -1;
+    if(ZoneIdx >= 0)
+    {
+        glQueryCounter(Frame->Queries[3 + 2 * ZoneIdx], GL_TIMESTAMP);
+    }
+}
+
+static void DrawProfileNodes(profiler *Profiler, uint32 Parent, font *Font, int32 X, int32 *Y, int32 Width)
+{
+    uint32 Children[PROFILE_MAX_NODES];
+    uint32 ChildCount = 0;
+    for(uint32 i = 0; i < Profiler->NodeCount; ++i)
+    {
+        if(Profiler->Nodes[i].Parent == Parent)
+        {
+            // NOTE - Insertion sort, most expensive first
+            uint32 j = ChildCount++;
+            while(j > 0 && Profiler->Nodes[Children[j-1]].Avg < Profiler->Nodes[i].Avg)
+            {
+                Children[j] = Children[j-1];
+                --j;
+            }
+            Children[j] = i;
+        }
+    }
+
+    real32 FrameAvg = Max(Profiler->FrameAvg, 1e-3f);
+    for(uint32 i = 0; i < ChildCount; ++i)
+    {
+        profile_node *Node = &Profiler->Nodes[Children[i]];
+
+        char Line[UI_STRINGLEN];
+        char Indented[64];
+        snprintf(Indented, sizeof(Indented), "%*s%s", 2 * (Node->Depth + 1), "", Node->Name);
+        snprintf(Line, UI_STRINGLEN, "%-32.32s %7.3f %7.3f %7.3f %5.1f%% %5u",
+                 Indented, Node->Avg, Node->Min, Node->Max, 100.f * Node->Avg / FrameAvg, Node->Calls);
+        uiMakeText(Line, Font, vec3i(X, *Y, 1), col4f(0.9, 0.9, 0.9, 1), Width);
+        *Y += Font->LineGap;
+
+        DrawProfileNodes(Profiler, Children[i], Font, X, Y, Width);
+    }
+}
+
+// NOTE - Table of the zones, children sorted by average time, stats over the
+// last PROFILE_HISTORY frames. Toggled with F3.
+void ProfilerDrawOverlay(game_context *Context, game_input *Input, font *Font, render_stats const *RenderStats)
+{
+    profiler *Profiler = GlobalProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    if(KEY_UP(Input->KeyF3))
+    {
+        Profiler->ShowOverlay = !Profiler->ShowOverlay;
+    }
+
+    if(!Profiler->ShowOverlay)
+    {
+        return;
+    }
+
+    gpu_profiler *GpuProfiler = GlobalGpuProfiler;
+
+    int32 X = 10, Y = 40;
+    int32 Width = Context->WindowWidth - 2 * X;
+    int32 LineCount = 6 + Profiler->NodeCount;
+    if(GpuProfiler)
+    {
+        LineCount += 3 + GpuProfiler->ZoneCount;
+    }
+    uiBeginPanel("", vec3i(X - 5, Y - 5, 0), vec2i(Width, LineCount * Font->LineGap + 10), col4f(0, 0, 0, 0.7));
+
+    char Line[UI_STRINGLEN];
+    snprintf(Line, UI_STRINGLEN, "CPU - last %u frames - %u threads%s", Min(Profiler->FrameIndex, (uint32)PROFILE_HISTORY),
+             (uint32)Profiler->ThreadCount, Profiler->DroppedEvents ? " - EVENTS DROPPED" : "");
+    uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.7, 0.1, 1), Width);
+    Y += Font->LineGap;
+
+    snprintf(Line, UI_STRINGLEN, "%-32s %7s %7s %7s %6s %5s", "Zone (ms)", "avg", "min", "max", "frame", "calls");
+    uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.7, 0.1, 1), Width);
+    Y += Font->LineGap;
+
+    snprintf(Line, UI_STRINGLEN, "%-32s %7.3f %7.3f %7.3f", "Frame", Profiler->FrameAvg, Profiler->FrameMin, Profiler->FrameMax);
+    uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.9, 0.9, 1), Width);
+    Y += Font->LineGap;
+
+    snprintf(Line, UI_STRINGLEN, "GL state calls : %u, %u redundant filtered", GLState.LastCalls, GLState.LastFiltered);
+    uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.9, 0.9, 1), Width);
+    Y += Font->LineGap;
+
+    snprintf(Line, UI_STRINGLEN, "Objects : %u, culled %u frustum, %u occluded, %u draw calls", RenderStats->ObjectCount,
+             RenderStats->FrustumCulled, RenderStats->OcclusionCulled, RenderStats->DrawCount);
+    uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.9, 0.9, 1), Width);
+    Y += Font->LineGap;
+
+    DrawProfileNodes(Profiler, PROFILE_MAIN_ROOT, Font, X, &Y, Width);
+
+    // NOTE - Job zones run on the workers, outside of the main thread hierarchy
+    uiMakeText("Worker threads", Font, vec3i(X, Y, 1), col4f(0.9, 0.7, 0.1, 1), Width);
+    Y += Font->LineGap;
+    DrawProfileNodes(Profiler, PROFILE_WORKER_ROOT, Font, X, &Y, Width);
+
+    if(GpuProfiler)
+    {
+        Y += Font->LineGap;
+        snprintf(Line, UI_STRINGLEN, "GPU - last %u frames, %d frames late%s", Min(GpuProfiler->ResolvedCount, (uint32)PROFILE_HISTORY),
+                 GPU_PROFILE_LATENCY, GpuProfiler->LateFrames ? " - RESULTS DROPPED" : "");
+        uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.7, 0.1, 1), Width);
+        Y += Font->LineGap;
+
+        snprintf(Line, UI_STRINGLEN, "%-32s %7.3f %7.3f %7.3f", "Frame", GpuProfiler->FrameAvg, GpuProfiler->FrameMin, GpuProfiler->FrameMax);
+        uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.9, 0.9, 1), Width);
+        Y += Font->LineGap;
+
+        real32 FrameAvg = Max(GpuProfiler->FrameAvg, 1e-3f);
+        for(uint32 i = 0; i < GpuProfiler->ZoneCount; ++i)
+        {
+            gpu_zone_stats *Zone = &GpuProfiler->Zones[i];
+            char Indented[64];
+            snprintf(Indented, sizeof(Indented), "%*s%s", 2 * (Zone->Depth + 1), "", Zone->Name);
+            snprintf(Line, UI_STRINGLEN, "%-32.32s %7.3f %7.3f %7.3f %5.1f%%",
+                     Indented, Zone->Avg, Zone->Min, Zone->Max, 100.f * Zone->Avg / FrameAvg);
+            uiMakeText(Line, Font, vec3i(X, Y, 1), col4f(0.9, 0.9, 0.9, 1), Width);
+            Y += Font->LineGap;
+        }
+    }
+}
+
+#else
+
+void InitProfiler(game_memory *Memory, char const *CaptureDir) {}
+void ProfileNewFrame() {}
+void ProfilerUpdateCapture(game_input *Input) {}
+void ProfilerApplyConfig(game_config const *Config) {}
+void ProfilerDrawOverlay(game_context *Context, game_input *Input, font *Font, render_stats const *RenderStats) {}
+void InitGpuProfiler(game_memory *Memory, char const *LogPath) {}
+void DestroyGpuProfiler() {}
+void GpuProfileBeginFrame() {}
+void GpuProfileEndFrame() {}
+
+#endif
+
+#endif
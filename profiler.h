@@ -0,0 +1,244 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - CPU Profiler. Platform side only.
+// TIMED_BLOCK("Name") records a begin event in its scope and an end event
+// when leaving it. Events from all threads go into a per-frame buffer, which
+// is turned into a hierarchy of zones at the end of each frame (profiler.cpp).
+// Names must be string literals (or otherwise static).
+// Compiled out unless RADAR_PROFILE is 1, which is the default in DEBUG.
+// The last frames can be dumped to a Chrome Trace Event file (F4 or when a
+// frame goes over iCaptureThresholdMs), to open in chrome://tracing or Perfetto.
+// The GPU counterpart (GPU_ZONE) is at the end of this file.
+//////////////////////////////////////////////////////////////////////////
+
+#ifndef RADAR_PROFILE
+#ifdef DEBUG
+#define RADAR_PROFILE 1
+#else
+#define RADAR_PROFILE 0
+#endif
+#endif
+
+#if RADAR_PROFILE
+
+#define PROFILE_MAX_EVENTS 4096     // Per frame
+#define PROFILE_HISTORY 120         // Frames of raw events and stats kept
+#define PROFILE_MAX_THREADS 16
+#define PROFILE_MAX_DEPTH 32
+#define PROFILE_MAX_NODES 256
+
+#if RADAR_UNIX && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+// NOTE - Raw cycle counter. Converted to time with the per-frame calibration.
+inline uint64 ReadCPUTimer()
+{
+#if RADAR_WIN32 || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec TS;
+    clock_gettime(CLOCK_MONOTONIC, &TS);
+    return (uint64)TS.tv_sec * 1000000000ULL + (uint64)TS.tv_nsec;
+#endif
+}
+
+enum profile_event_type
+{
+    PROFILE_BEGIN,
+    PROFILE_END
+};
+
+struct profile_event
+{
+    uint64 Clock;
+    char const *Name;
+    uint16 ThreadIndex;
+    uint16 Type;
+};
+
+struct profile_frame
+{
+    uint64 BeginClock;
+    uint64 EndClock;
+    real64 CyclesPerSecond;
+    int32 volatile EventCount;
+    profile_event Events[PROFILE_MAX_EVENTS];
+};
+
+struct profile_node
+{
+    char const *Name;
+    uint32 Parent;
+    uint32 Depth;
+
+    uint64 FrameCycles;     // Accumulated while processing a frame
+    uint32 FrameCalls;
+
+    real32 History[PROFILE_HISTORY];    // Per-frame total, in ms
+    uint32 Calls;
+    real32 Min, Avg, Max;
+};
+
+struct profiler
+{
+    // NOTE - Ring of raw frames, Frames[FrameIndex % PROFILE_HISTORY] is being recorded
+    profile_frame Frames[PROFILE_HISTORY];
+    uint32 FrameIndex;
+    profile_frame *CurrentFrame;
+
+    int32 volatile ThreadCount;
+    real64 CyclesPerSecond;
+    real64 FrameBeginWallClock;
+    bool LoopStarted;           // The first ProfileNewFrame only drops the startup
+
+    profile_node Nodes[PROFILE_MAX_NODES];
+    uint32 NodeCount;
+    hash_map<uint64, uint32> NodeMap;   // (Name hash, Parent) -> Node
+
+    real32 FrameHistory[PROFILE_HISTORY];
+    real32 FrameMin, FrameAvg, FrameMax;
+    uint32 DroppedEvents;
+
+    bool ShowOverlay;
+
+    // NOTE - Trace captures of the whole ring, see ProfilerUpdateCapture
+    path CaptureDir;
+    real32 CaptureThreshold;    // In ms, 0 to disable
+    uint32 CaptureCooldown;     // Frames before the threshold can trigger again
+    bool CaptureRequested;
+};
+
+extern profiler *GlobalProfiler;
+extern THREAD_LOCAL int32 ProfileThreadIndex;
+
+inline void ProfileRecordEvent(char const *Name, profile_event_type Type)
+{
+    profiler *Profiler = GlobalProfiler;
+    if(!Profiler)
+    {
+        return;
+    }
+
+    if(ProfileThreadIndex < 0)
+    {
+        ProfileThreadIndex = AtomicAdd32(&Profiler->ThreadCount, 1) - 1;
+    }
+
+    // NOTE - Events racing with the frame switch land in the previous frame,
+    // and are just ignored if it was already processed.
+    profile_frame *Frame = Profiler->CurrentFrame;
+    int32 Idx = AtomicAdd32(&Frame->EventCount, 1) - 1;
+    if(Idx < PROFILE_MAX_EVENTS)
+    {
+        profile_event *Event = &Frame->Events[Idx];
+        Event->Name = Name;
+        Event->ThreadIndex = (uint16)ProfileThreadIndex;
+        Event->Type = (uint16)Type;
+        Event->Clock = ReadCPUTimer();
+    }
+}
+
+struct timed_block
+{
+    char const *Name;
+
+    timed_block(char const *BlockName)
+    {
+        Name = BlockName;
+        ProfileRecordEvent(Name, PROFILE_BEGIN);
+    }
+
+    ~timed_block()
+    {
+        ProfileRecordEvent(Name, PROFILE_END);
+    }
+};
+
+#define _TIMED_BLOCK_VAR2(Line) _TimedBlock##Line
+#define _TIMED_BLOCK_VAR(Line) _TIMED_BLOCK_VAR2(Line)
+#define TIMED_BLOCK(Name) timed_block _TIMED_BLOCK_VAR(__LINE__)(Name)
+#define TIMED_FUNCTION() TIMED_BLOCK(__FUNCTION__)
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - GPU Profiler. Main thread only, with the GL context current.
+// GPU_ZONE("Name") puts a GL_TIMESTAMP query at both ends of its scope.
+// Each frame has its own set of queries, in a ring of GPU_PROFILE_LATENCY
+// frames : results are read when the set comes back around, long after the
+// GPU is done with them, so reading never stalls the pipeline.
+//////////////////////////////////////////////////////////////////////////
+#define GPU_PROFILE_LATENCY 4
+#define GPU_PROFILE_MAX_ZONES 32    // Per frame
+#define GPU_PROFILE_MAX_DEPTH 8
+#define GPU_PROFILE_QUERIES (2 + 2 * GPU_PROFILE_MAX_ZONES)
+
+struct gpu_profile_frame
+{
+    // NOTE - [0] and [1] : frame begin and end, then a begin/end pair per zone
+    uint32 Queries[GPU_PROFILE_QUERIES];
+    char const *ZoneNames[GPU_PROFILE_MAX_ZONES];
+    uint32 ZoneDepths[GPU_PROFILE_MAX_ZONES];
+    uint32 ZoneCount;
+    bool Issued;
+};
+
+struct gpu_zone_stats
+{
+    char const *Name;
+    uint32 Depth;
+    real32 History[PROFILE_HISTORY];    // Per-frame total, in ms
+    real32 Min, Avg, Max;
+};
+
+struct gpu_profiler
+{
+    gpu_profile_frame Frames[GPU_PROFILE_LATENCY];
+    uint32 FrameIndex;      // Frames[FrameIndex % GPU_PROFILE_LATENCY] is being recorded
+
+    int32 ZoneStack[GPU_PROFILE_MAX_DEPTH];
+    uint32 ZoneDepth;
+
+    gpu_zone_stats Zones[GPU_PROFILE_MAX_ZONES];
+    uint32 ZoneCount;
+    uint32 ResolvedCount;
+    real32 FrameHistory[PROFILE_HISTORY];
+    real32 FrameMin, FrameAvg, FrameMax;
+    uint32 LateFrames;      // Results not available yet when read, discarded
+    uint32 DroppedZones;
+
+    FILE *Log;
+};
+
+extern gpu_profiler *GlobalGpuProfiler;
+
+void GpuProfileBeginZone(char const *Name);
+void GpuProfileEndZone();
+
+struct gpu_timed_block
+{
+    gpu_timed_block(char const *Name)
+    {
+        GpuProfileBeginZone(Name);
+    }
+
+    ~gpu_timed_block()
+    {
+        GpuProfileEndZone();
+    }
+};
+
+#define _GPU_ZONE_VAR2(Line) _GpuZone##Line
+#define _GPU_ZONE_VAR(Line) _GPU_ZONE_VAR2(Line)
+#define GPU_ZONE(Name) gpu_timed_block _GPU_ZONE_VAR(__LINE__)(Name)
+
+#else
+
+#define TIMED_BLOCK(Name)
+#define TIMED_FUNCTION()
+#define GPU_ZONE(Name)
+
+#endif
+
+#endif
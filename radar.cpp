@@ -1,20 +1,25 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "sun.h"
 #include "radar.h"
 #include "render.h"
 
-#define MAX_SHADERS 32
+// NOTE - The data is mapped from this file offset on unix : a multiple of every
+// page size in use (4KB x64, 16KB or 64KB arm64 and ppc64)
+#define SNAPSHOT_DATA_OFFSET Kilobytes(64)
 
 // PLATFORM
 int RadarMain(int argc, char **argv);
+#include "watch.h"
 #if RADAR_WIN32
 #include "radar_win32.cpp"
 #elif RADAR_UNIX
 #include "radar_unix.cpp"
 #endif
+#include "profiler.h"
 
 // EXTERNAL
 #include "cJSON.h"
@@ -41,38 +46,21 @@ struct game_context
     int WindowWidth;
     int WindowHeight;
 
-    uint32 Shaders3D[MAX_SHADERS];
-    uint32 Shaders3DCount;
-    uint32 Shaders2D[MAX_SHADERS];
-    uint32 Shaders2DCount;
-
+    bool Headless;      // Hidden window, no audio, no VSync
     bool IsRunning;
     bool IsValid;
 };
 
-void RegisterShader3D(game_context *Context, uint32 ProgramID)
-{
-    Assert(Context->Shaders3DCount < MAX_SHADERS);
-    Context->Shaders3D[Context->Shaders3DCount++] = ProgramID;
-}
-
-void RegisterShader2D(game_context *Context, uint32 ProgramID)
-{
-    Assert(Context->Shaders2DCount < MAX_SHADERS);
-    Context->Shaders2D[Context->Shaders2DCount++] = ProgramID;
-}
-
-void RegisteredShaderClear(game_context *Context)
-{
-    Context->Shaders3DCount = 0;
-    Context->Shaders2DCount = 0;
-}
-
 // IMPLEMENTATION
 #include "utils.cpp"
+#include "job.cpp"
+#include "meshopt.cpp"
 #include "render.cpp"
+#include "cull.cpp"
+#include "render_commands.cpp"
 #include "sound.cpp"
 #include "water.cpp"
+#include "snapshot.cpp"
 
 bool FramePressedKeys[350] = {};
 bool FrameReleasedKeys[350] = {};
@@ -92,6 +80,8 @@ int ResizeHeight;
 bool Resized = true;
 
 #include "ui.cpp"
+#include "profiler.cpp"
+#include "bench.cpp"
 
 game_memory InitMemory()
 {
@@ -99,14 +89,23 @@ game_memory InitMemory()
 
     Memory.PermanentMemPoolSize = Megabytes(32);
     Memory.SessionMemPoolSize = Megabytes(512);
-    Memory.ScratchMemPoolSize = Megabytes(64);
+    Memory.ScratchMemPoolSize = Megabytes(64) + MAX_THREAD_SCRATCH * THREAD_SCRATCH_SIZE;
 
-    Memory.PermanentMemPool = calloc(1, Memory.PermanentMemPoolSize);
-    Memory.SessionMemPool = calloc(1, Memory.SessionMemPoolSize);
-    Memory.ScratchMemPool = calloc(1, Memory.ScratchMemPoolSize);
+    Memory.PermanentMemPool = PlatformAllocateMemory(Memory.PermanentMemPoolSize);
+    Memory.SessionMemPool = PlatformAllocateMemory(Memory.SessionMemPoolSize);
+    Memory.ScratchMemPool = PlatformAllocateMemory(Memory.ScratchMemPoolSize);
 
     InitArena(&Memory.SessionArena, Memory.SessionMemPoolSize, Memory.SessionMemPool);
-    InitArena(&Memory.ScratchArena, Memory.ScratchMemPoolSize, Memory.ScratchMemPool);
+
+    // NOTE - Per-thread scratch arenas live at the end of the ScratchMemPool
+    uint64 ThreadScratchSize = MAX_THREAD_SCRATCH * THREAD_SCRATCH_SIZE;
+    InitArena(&Memory.ScratchArena, Memory.ScratchMemPoolSize - ThreadScratchSize, Memory.ScratchMemPool);
+    uint8 *ThreadScratchBase = (uint8*)Memory.ScratchMemPool + Memory.ScratchArena.Capacity;
+    for(uint32 i = 0; i < MAX_THREAD_SCRATCH; ++i)
+    {
+        InitArena(&Memory.ThreadScratch[i].Arena, THREAD_SCRATCH_SIZE, ThreadScratchBase + i * THREAD_SCRATCH_SIZE);
+        Memory.ThreadScratch[i].InUse = 0;
+    }
 
     Memory.IsValid = Memory.PermanentMemPool && Memory.SessionMemPool && Memory.ScratchMemPool;
     Memory.IsInitialized = false;
@@ -118,9 +117,9 @@ void DestroyMemory(game_memory *Memory)
 {
     if(Memory->IsValid)
     {
-        free(Memory->PermanentMemPool);
-        free(Memory->SessionMemPool);
-        free(Memory->ScratchMemPool);
+        PlatformFreeMemory(Memory->PermanentMemPool, Memory->PermanentMemPoolSize);
+        PlatformFreeMemory(Memory->SessionMemPool, Memory->SessionMemPoolSize);
+        PlatformFreeMemory(Memory->ScratchMemPool, Memory->ScratchMemPoolSize);
         Memory->PermanentMemPoolSize = 0;
         Memory->SessionMemPoolSize = 0;
         Memory->ScratchMemPoolSize = 0;
@@ -130,59 +129,120 @@ void DestroyMemory(game_memory *Memory)
     }
 }
 
-void ParseConfig(game_memory *Memory, char *ConfigPath)
+void DefaultConfig(game_config *Config)
 {
-    game_config &Config = Memory->Config;
+    Config->WindowWidth = 960;
+    Config->WindowHeight = 540;
+    Config->MSAA = 0;
+    Config->FullScreen = false;
+    Config->VSync = false;
+    Config->TargetFPS = 60;
+    Config->SimulationHz = 60;
+    Config->CaptureThresholdMs = 0;
+    Config->FOV = 75.f;
+    Config->AnisotropicFiltering = 1;
+    Config->OcclusionCulling = false;
+    Config->PackedVertices = false;
+
+    Config->CameraSpeedBase = 20.f;
+    Config->CameraSpeedMult = 2.f;
+    Config->CameraSpeedAngular = 30.f;
+    Config->CameraPosition = vec3f(1, 1, 1);
+    Config->CameraTarget = vec3f(0, 0, 0);
+}
 
-    void *Content = ReadFileContents(&Memory->ScratchArena, ConfigPath, 0);
-    if(Content)
+// NOTE - Config readers : a missing or mistyped key leaves the value alone
+static void ConfigReadInt(cJSON *root, char const *Name, int32 *Value)
+{
+    cJSON *Item = cJSON_GetObjectItem(root, Name);
+    if(Item && Item->type == cJSON_Number)
     {
-        cJSON *root = cJSON_Parse((char*)Content);
-        if(root)
-        {
-            Config.WindowWidth = cJSON_GetObjectItem(root, "iWindowWidth")->valueint;
-            Config.WindowHeight = cJSON_GetObjectItem(root, "iWindowHeight")->valueint;
-            Config.MSAA = cJSON_GetObjectItem(root, "iMSAA")->valueint;
-            Config.FullScreen = cJSON_GetObjectItem(root, "bFullScreen")->valueint != 0;
-            Config.VSync = cJSON_GetObjectItem(root, "bVSync")->valueint != 0;
-            Config.FOV = (real32)cJSON_GetObjectItem(root, "fFOV")->valuedouble;
-            Config.AnisotropicFiltering = cJSON_GetObjectItem(root, "iAnisotropicFiltering")->valueint;
+        *Value = Item->valueint;
+    }
+}
 
-            Config.CameraSpeedBase = (real32)cJSON_GetObjectItem(root, "fCameraSpeedBase")->valuedouble;
-            Config.CameraSpeedMult = (real32)cJSON_GetObjectItem(root, "fCameraSpeedMult")->valuedouble;
-            Config.CameraSpeedAngular = (real32)cJSON_GetObjectItem(root, "fCameraSpeedAngular")->valuedouble;
+static void ConfigReadBool(cJSON *root, char const *Name, bool *Value)
+{
+    cJSON *Item = cJSON_GetObjectItem(root, Name);
+    if(Item && Item->type == cJSON_Number)
+    {
+        *Value = Item->valueint != 0;
+    }
+    else if(Item && (Item->type == cJSON_True || Item->type == cJSON_False))
+    {
+        *Value = Item->type == cJSON_True;
+    }
+}
 
-            cJSON *CameraPositionVector = cJSON_GetObjectItem(root, "vCameraPosition");
-            Config.CameraPosition.x = (real32)cJSON_GetArrayItem(CameraPositionVector, 0)->valuedouble;
-            Config.CameraPosition.y = (real32)cJSON_GetArrayItem(CameraPositionVector, 1)->valuedouble;
-            Config.CameraPosition.z = (real32)cJSON_GetArrayItem(CameraPositionVector, 2)->valuedouble;
+static void ConfigReadReal(cJSON *root, char const *Name, real32 *Value)
+{
+    cJSON *Item = cJSON_GetObjectItem(root, Name);
+    if(Item && Item->type == cJSON_Number)
+    {
+        *Value = (real32)Item->valuedouble;
+    }
+}
 
-            cJSON *CameraTargetVector = cJSON_GetObjectItem(root, "vCameraTarget");
-            Config.CameraTarget.x = (real32)cJSON_GetArrayItem(CameraTargetVector, 0)->valuedouble;
-            Config.CameraTarget.y = (real32)cJSON_GetArrayItem(CameraTargetVector, 1)->valuedouble;
-            Config.CameraTarget.z = (real32)cJSON_GetArrayItem(CameraTargetVector, 2)->valuedouble;
-        }
-        else
+static void ConfigReadVec3(cJSON *root, char const *Name, vec3f *Value)
+{
+    cJSON *Item = cJSON_GetObjectItem(root, Name);
+    if(Item && Item->type == cJSON_Array && cJSON_GetArraySize(Item) == 3)
+    {
+        for(int i = 0; i < 3; ++i)
         {
-            printf("Error parsing Config File as JSON.\n");
+            cJSON *Component = cJSON_GetArrayItem(Item, i);
+            if(Component->type != cJSON_Number)
+            {
+                return;
+            }
         }
+        Value->x = (real32)cJSON_GetArrayItem(Item, 0)->valuedouble;
+        Value->y = (real32)cJSON_GetArrayItem(Item, 1)->valuedouble;
+        Value->z = (real32)cJSON_GetArrayItem(Item, 2)->valuedouble;
     }
-    else
+}
+
+// NOTE - Overrides the current config with the keys found in the file : call
+// DefaultConfig before the first one. On a live reload, keys missing from the
+// file keep their running value. Returns false if the file couldn't be read or parsed.
+bool ParseConfig(game_memory *Memory, char *ConfigPath)
+{
+    game_config &Config = Memory->Config;
+
+    void *Content = ReadFileContents(&Memory->ScratchArena, ConfigPath, 0);
+    if(!Content)
     {
-        Config.WindowWidth = 960;
-        Config.WindowHeight = 540;
-        Config.MSAA = 0;
-        Config.FullScreen = false;
-        Config.VSync = false;
-        Config.FOV = 75.f;
-        Config.AnisotropicFiltering = 1;
+        return false;
+    }
 
-        Config.CameraSpeedBase = 20.f;
-        Config.CameraSpeedMult = 2.f;
-        Config.CameraSpeedAngular = 30.f;
-        Config.CameraPosition = vec3f(1, 1, 1);
-        Config.CameraTarget = vec3f(0, 0, 0);
+    cJSON *root = cJSON_Parse((char*)Content);
+    if(!root)
+    {
+        printf("Error parsing Config File as JSON.\n");
+        return false;
     }
+
+    ConfigReadInt(root, "iWindowWidth", &Config.WindowWidth);
+    ConfigReadInt(root, "iWindowHeight", &Config.WindowHeight);
+    ConfigReadInt(root, "iMSAA", &Config.MSAA);
+    ConfigReadBool(root, "bFullScreen", &Config.FullScreen);
+    ConfigReadBool(root, "bVSync", &Config.VSync);
+    ConfigReadInt(root, "iTargetFPS", &Config.TargetFPS);
+    ConfigReadInt(root, "iSimulationHz", &Config.SimulationHz);
+    ConfigReadInt(root, "iCaptureThresholdMs", &Config.CaptureThresholdMs);
+    ConfigReadReal(root, "fFOV", &Config.FOV);
+    ConfigReadInt(root, "iAnisotropicFiltering", &Config.AnisotropicFiltering);
+    ConfigReadBool(root, "bOcclusionCulling", &Config.OcclusionCulling);
+    ConfigReadBool(root, "bPackedVertices", &Config.PackedVertices);
+
+    ConfigReadReal(root, "fCameraSpeedBase", &Config.CameraSpeedBase);
+    ConfigReadReal(root, "fCameraSpeedMult", &Config.CameraSpeedMult);
+    ConfigReadReal(root, "fCameraSpeedAngular", &Config.CameraSpeedAngular);
+    ConfigReadVec3(root, "vCameraPosition", &Config.CameraPosition);
+    ConfigReadVec3(root, "vCameraTarget", &Config.CameraTarget);
+
+    cJSON_Delete(root);
+    return true;
 }
 
 void ProcessKeyboardEvent(GLFWwindow *Window, int Key, int Scancode, int Action, int Mods)
@@ -238,22 +298,6 @@ void ProcessErrorEvent(int Error, const char* Description)
     printf("GLFW Error : %s\n", Description);
 }
 
-void UpdateShaderProjection(game_context *Context)
-{
-    // Notify the shaders that uses it
-    for(uint32 i = 0; i < Context->Shaders3DCount; ++i)
-    {
-        glUseProgram(Context->Shaders3D[i]);
-        SendMat4(glGetUniformLocation(Context->Shaders3D[i], "ProjMatrix"), Context->ProjectionMatrix3D);
-    }
-
-    for(uint32 i = 0; i < Context->Shaders2DCount; ++i)
-    {
-        glUseProgram(Context->Shaders2D[i]);
-        SendMat4(glGetUniformLocation(Context->Shaders2D[i], "ProjMatrix"), Context->ProjectionMatrix2D);
-    }
-}
-
 void WindowResized(game_context *Context)
 {
     Resized = false;
@@ -264,8 +308,6 @@ void WindowResized(game_context *Context)
     Context->ProjectionMatrix3D = mat4f::Perspective(Context->FOV, 
             Context->WindowWidth / (real32)Context->WindowHeight, 0.1f, 10000.f);
     Context->ProjectionMatrix2D = mat4f::Ortho(0, Context->WindowWidth, 0, Context->WindowHeight, 0.1f, 1000.f);
-
-    UpdateShaderProjection(Context);
 }
 
 key_state BuildKeyState(int32 Key)
@@ -290,6 +332,8 @@ mouse_state BuildMouseState(int32 MouseButton)
 
 void GetFrameInput(game_context *Context, game_input *Input)
 {
+    TIMED_FUNCTION();
+
     memset(FrameReleasedKeys, 0, sizeof(FrameReleasedKeys));
     memset(FramePressedKeys, 0, sizeof(FramePressedKeys));
     memset(FrameReleasedMouseButton, 0, sizeof(FrameReleasedMouseButton));
@@ -323,12 +367,17 @@ void GetFrameInput(game_context *Context, game_input *Input)
     Input->KeyD = BuildKeyState(GLFW_KEY_D);
     Input->KeyR = BuildKeyState(GLFW_KEY_R);
     Input->KeyF = BuildKeyState(GLFW_KEY_F);
+    Input->KeyL = BuildKeyState(GLFW_KEY_L);
     Input->KeyLShift = BuildKeyState(GLFW_KEY_LEFT_SHIFT);
     Input->KeyLCtrl = BuildKeyState(GLFW_KEY_LEFT_CONTROL);
     Input->KeyLAlt = BuildKeyState(GLFW_KEY_LEFT_ALT);
     Input->KeySpace = BuildKeyState(GLFW_KEY_SPACE);
     Input->KeyF1 = BuildKeyState(GLFW_KEY_F1);
     Input->KeyF2 = BuildKeyState(GLFW_KEY_F2);
+    Input->KeyF3 = BuildKeyState(GLFW_KEY_F3);
+    Input->KeyF4 = BuildKeyState(GLFW_KEY_F4);
+    Input->KeyF5 = BuildKeyState(GLFW_KEY_F5);
+    Input->KeyF9 = BuildKeyState(GLFW_KEY_F9);
     Input->KeyF11 = BuildKeyState(GLFW_KEY_F11);
     Input->KeyNumPlus = BuildKeyState(GLFW_KEY_KP_ADD);
     Input->KeyNumMinus = BuildKeyState(GLFW_KEY_KP_SUBTRACT);
@@ -337,14 +386,15 @@ void GetFrameInput(game_context *Context, game_input *Input)
 
     Input->MouseLeft = BuildMouseState(GLFW_MOUSE_BUTTON_LEFT);
     Input->MouseRight = BuildMouseState(GLFW_MOUSE_BUTTON_RIGHT);
-
-    Input->dTimeFixed = 0.1f; // 100FPS
 }
 
-game_context InitContext(game_memory *Memory)
+// NOTE - Headless still needs a display for GLFW : on servers without one, run
+// it under Xvfb, with Mesa's llvmpipe when there is no GPU either.
+game_context InitContext(game_memory *Memory, bool Headless)
 {
     game_context Context = {};
     game_config const &Config = Memory->Config;
+    Context.Headless = Headless;
 
     bool GLFWValid = false, GLEWValid = false, ALValid = false;
 
@@ -354,14 +404,22 @@ game_context InitContext(game_memory *Memory)
         char WindowName[64];
         snprintf(WindowName, 64, "Radar v%d.%d.%d", RADAR_MAJOR, RADAR_MINOR, RADAR_PATCH);
 
+        if(Headless)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        }
+
         Context.Window = glfwCreateWindow(Config.WindowWidth, Config.WindowHeight, WindowName, NULL, NULL);
         if(Context.Window)
         {
             glfwMakeContextCurrent(Context.Window);
 
             // TODO - Only in windowed mode for debug
-		    glfwSetWindowPos(Context.Window, 800, 400);
-            glfwSwapInterval(Config.VSync);
+            if(!Headless)
+            {
+		        glfwSetWindowPos(Context.Window, 800, 400);
+            }
+            glfwSwapInterval(Headless ? 0 : Config.VSync);
 
             glfwSetKeyCallback(Context.Window, ProcessKeyboardEvent);
             glfwSetMouseButtonCallback(Context.Window, ProcessMouseButtonEvent);
@@ -398,18 +456,21 @@ game_context InitContext(game_memory *Memory)
 
                 glClearColor(Context.ClearColor.x, Context.ClearColor.y, Context.ClearColor.z, Context.ClearColor.w);
 
-                glEnable(GL_CULL_FACE);
+                // NOTE - Nothing is known of the fresh context, the first calls all go through
+                InvalidateGLState();
+
+                GLEnable(GL_CULL_FACE);
                 glCullFace(GL_BACK);
                 glFrontFace(GL_CCW);
 
-                glEnable(GL_DEPTH_TEST);
-                glDepthFunc(GL_LESS);
+                GLEnable(GL_DEPTH_TEST);
+                GLDepthFunc(GL_LESS);
 
-                glEnable(GL_BLEND);
-                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                GLEnable(GL_BLEND);
+                GLBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-                glEnable(GL_POINT_SPRITE);
-                glEnable(GL_PROGRAM_POINT_SIZE);
+                GLEnable(GL_POINT_SPRITE);
+                GLEnable(GL_PROGRAM_POINT_SIZE);
 
                 {
                     path TexPath;
@@ -447,7 +508,8 @@ game_context InitContext(game_memory *Memory)
         printf("Couldn't init GLFW.\n");
     }
 
-    ALValid = InitAL();
+    // NOTE - No audio device when headless, nothing is played anyway
+    ALValid = Headless || InitAL();
 
     if(GLFWValid && GLEWValid && ALValid)
     {
@@ -470,62 +532,98 @@ void DestroyContext(game_context *Context)
     glfwTerminate();
 }
 
-uint32 Program1, Program3D, ProgramSkybox;
-uint32 ProgramWater;
+shader_program Program1, Program3D, ProgramSkybox;
+shader_program ProgramWater;
 
-void ReloadShaders(game_memory *Memory, game_context *Context, path ExecutableFullPath)
+void SetupTextShader(shader_program *Program)
 {
-    RegisteredShaderClear(Context);
+    SendInt(GetUniform(Program, UniformName("DiffuseTexture")), 0);
+}
 
-    path VSPath;
-    path FSPath;
-    MakeRelativePath(VSPath, ExecutableFullPath, "data/shaders/text_vert.glsl");
-    MakeRelativePath(FSPath, ExecutableFullPath, "data/shaders/text_frag.glsl");
-    Program1 = BuildShader(Memory, VSPath, FSPath);
-    glUseProgram(Program1);
-    SendInt(glGetUniformLocation(Program1, "DiffuseTexture"), 0);
-    CheckGLError("Text Shader");
+void SetupMeshShader(shader_program *Program)
+{
+    SendInt(GetUniform(Program, UniformName("Albedo")), 0);
+    SendInt(GetUniform(Program, UniformName("Metallic")), 1);
+    SendInt(GetUniform(Program, UniformName("Roughness")), 2);
+    SendInt(GetUniform(Program, UniformName("Skybox")), 3);
+    SendInt(GetUniform(Program, UniformName("IrradianceCubemap")), 4);
+}
 
-    RegisterShader2D(Context, Program1);
+void SetupSkyboxShader(shader_program *Program)
+{
+    SendInt(GetUniform(Program, UniformName("Skybox")), 0);
+}
 
-    MakeRelativePath(VSPath, ExecutableFullPath, "data/shaders/vert.glsl");
-    MakeRelativePath(FSPath, ExecutableFullPath, "data/shaders/frag.glsl");
-    Program3D = BuildShader(Memory, VSPath, FSPath);
-    glUseProgram(Program3D);
-    SendInt(glGetUniformLocation(Program3D, "Albedo"), 0);
-    SendInt(glGetUniformLocation(Program3D, "Metallic"), 1);
-    SendInt(glGetUniformLocation(Program3D, "Roughness"), 2);
-    SendInt(glGetUniformLocation(Program3D, "Skybox"), 3);
-    SendInt(glGetUniformLocation(Program3D, "IrradianceCubemap"), 4);
-    CheckGLError("Mesh Shader");
+void SetupWaterShader(shader_program *Program)
+{
+    SendInt(GetUniform(Program, UniformName("Skybox")), 0);
+    SendInt(GetUniform(Program, UniformName("IrradianceCubemap")), 1);
+}
 
-    RegisterShader3D(Context, Program3D);
+typedef void shader_setup_function(shader_program *Program);
 
-    MakeRelativePath(VSPath, ExecutableFullPath, "data/shaders/skybox_vert.glsl");
-    MakeRelativePath(FSPath, ExecutableFullPath, "data/shaders/skybox_frag.glsl");
-    ProgramSkybox = BuildShader(Memory, VSPath, FSPath);
-    glUseProgram(ProgramSkybox);
-    SendInt(glGetUniformLocation(ProgramSkybox, "Skybox"), 0);
-    CheckGLError("Skybox Shader");
+// NOTE - Every program built from data/shaders/, so that a single one can be
+// rebuilt when one of its sources changes on disk
+struct shader_entry
+{
+    shader_program *Program;
+    char const *VSName;
+    char const *FSName;
+    shader_setup_function *Setup;   // Constant uniforms, with the program bound
+};
 
-    RegisterShader3D(Context, ProgramSkybox);
+// NOTE - The projections, camera and light come from the shared uniform blocks
+// (see uniform_block), nothing to send per program when those change
+static shader_entry ShaderTable[] = {
+    { &Program1,      "text_vert.glsl",   "text_frag.glsl",   SetupTextShader   },
+    { &Program3D,     "vert.glsl",        "frag.glsl",        SetupMeshShader   },
+    { &ProgramSkybox, "skybox_vert.glsl", "skybox_frag.glsl", SetupSkyboxShader },
+    { &ProgramWater,  "water_vert.glsl",  "water_frag.glsl",  SetupWaterShader  },
+    { &uiProgram,     "ui_vert.glsl",     "ui_frag.glsl",     uiSetupShader     },
+};
 
-    MakeRelativePath(VSPath, ExecutableFullPath, "data/shaders/water_vert.glsl");
-    MakeRelativePath(FSPath, ExecutableFullPath, "data/shaders/water_frag.glsl");
-    ProgramWater = BuildShader(Memory, VSPath, FSPath);
-    glUseProgram(ProgramWater);
-    SendInt(glGetUniformLocation(ProgramWater, "Skybox"), 0);
-    SendInt(glGetUniformLocation(ProgramWater, "IrradianceCubemap"), 1);
-    CheckGLError("Water Shader");
+#define SHADER_COUNT (sizeof(ShaderTable) / sizeof(ShaderTable[0]))
 
-    RegisterShader3D(Context, ProgramWater);
+// NOTE - Keeps the previous program if the new sources don't build, so that a
+// typo saved in an editor doesn't take the rendering down
+bool ReloadShader(game_memory *Memory, path ExecutableFullPath, uint32 ShaderIdx)
+{
+    shader_entry *Entry = &ShaderTable[ShaderIdx];
 
-    uiReloadShaders(Memory, Context, ExecutableFullPath);
-    CheckGLError("UI Shader");
+    path VSPath, FSPath, Name;
+    snprintf(Name, MAX_PATH, "data/shaders/%s", Entry->VSName);
+    MakeRelativePath(VSPath, ExecutableFullPath, Name);
+    snprintf(Name, MAX_PATH, "data/shaders/%s", Entry->FSName);
+    MakeRelativePath(FSPath, ExecutableFullPath, Name);
 
-    UpdateShaderProjection(Context);
-    
-    glUseProgram(0);
+    uint32 Program = BuildShader(Memory, VSPath, FSPath);
+    if(!Program)
+    {
+        printf("Keeping the previous %s/%s program.\n", Entry->VSName, Entry->FSName);
+        return false;
+    }
+
+    if(Entry->Program->ID)
+    {
+        GLDeleteProgram(Entry->Program->ID);
+    }
+    Entry->Program->ID = Program;
+    ReflectShaderUniforms(Entry->Program, &Memory->SessionArena);
+
+    GLUseProgram(Program);
+    Entry->Setup(Entry->Program);
+    CheckGLError(Entry->VSName);
+
+    GLUseProgram(0);
+    return true;
+}
+
+void ReloadShaders(game_memory *Memory, path ExecutableFullPath)
+{
+    for(uint32 i = 0; i < SHADER_COUNT; ++i)
+    {
+        ReloadShader(Memory, ExecutableFullPath, i);
+    }
 }
 
 void InitializeFromGame(game_memory *Memory)
@@ -538,13 +636,14 @@ void InitializeFromGame(game_memory *Memory)
 
     water_system *WaterSystem = System->WaterSystem;
     WaterSystem->VAO = MakeVertexArrayObject();
-    WaterSystem->VBO[0] = AddIBO(GL_STATIC_DRAW, WaterSystem->IndexCount * sizeof(uint32), WaterSystem->IndexData);
+    WaterSystem->VBO[0] = MakeIndexBuffer(WaterSystem->IndexData, WaterSystem->IndexCount,
+                                          Square(water_system::WaterN + 1), &WaterSystem->IndexType);
     WaterSystem->VBO[1] = AddEmptyVBO(WaterSystem->VertexDataSize, GL_STATIC_DRAW);
     size_t VertSize = WaterSystem->VertexCount * sizeof(real32);
     FillVBO(0, 3, GL_FLOAT, 0, VertSize, WaterSystem->VertexData);
     FillVBO(1, 3, GL_FLOAT, VertSize, VertSize, WaterSystem->VertexData + WaterSystem->VertexCount);
     FillVBO(2, 3, GL_FLOAT, 2*VertSize, VertSize, WaterSystem->VertexData + 2 * WaterSystem->VertexCount);
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 
     Memory->IsGameInitialized = true;
     Memory->IsInitialized = true;
@@ -567,7 +666,11 @@ void MakeUI(game_memory *Memory, game_context *Context, font *Font)
     ui_frame_stack *UIStack = System->UIStack;
     for(uint32 i = 0; i < UIStack->TextLineCount; ++i)
     {
-        ui_text_line *Line = &UIStack->TextLines[i];
+        ui_text_line *Line = PoolGetStruct(System->UITextLines, UIStack->TextLines[i], ui_text_line);
+        if(!Line)
+        {
+            continue;
+        }
         // TODO - handle different fonts
         uiMakeText(Line->String, Font, Line->Position, Line->Color, Context->WindowWidth);
     }
@@ -581,29 +684,578 @@ void MakeUI(game_memory *Memory, game_context *Context, font *Font)
 #endif
 }
 
+struct command_line
+{
+    char *RecordName;       // --record <name> : record input from the 1st frame
+    char *PlaybackName;     // --playback <name> : replay a recording in a loop
+    int32 PlaybackLoops;    // --loops <n> : quit after n playback loops, 0 for never
+    char *GpuLogName;       // --gpu-log <file> : write the GPU zone timings of every frame
+    bool Headless;          // --headless : hidden window, scripted camera, then quit
+    uint32 BenchFrames;     // --frames <n> : frames to run headless
+    char *SummaryName;      // --summary <file> : timing summary of a headless or bench run
+    char *BenchScript;      // --bench <script> : run a scripted flythrough, then quit
+    char *CSVName;          // --csv <file> : per-frame times of a bench run
+};
+
+command_line ParseCommandLine(int argc, char **argv)
+{
+    command_line CmdLine = {};
+
+    for(int i = 1; i < argc; ++i)
+    {
+        bool HasValue = (i + 1) < argc;
+        if(!strcmp(argv[i], "--record") && HasValue)
+        {
+            CmdLine.RecordName = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--playback") && HasValue)
+        {
+            CmdLine.PlaybackName = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--loops") && HasValue)
+        {
+            CmdLine.PlaybackLoops = atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--gpu-log") && HasValue)
+        {
+            CmdLine.GpuLogName = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--headless"))
+        {
+            CmdLine.Headless = true;
+        }
+        else if(!strcmp(argv[i], "--frames") && HasValue)
+        {
+            CmdLine.BenchFrames = (uint32)atoi(argv[++i]);
+        }
+        else if(!strcmp(argv[i], "--summary") && HasValue)
+        {
+            CmdLine.SummaryName = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--bench") && HasValue)
+        {
+            CmdLine.BenchScript = argv[++i];
+        }
+        else if(!strcmp(argv[i], "--csv") && HasValue)
+        {
+            CmdLine.CSVName = argv[++i];
+        }
+        else
+        {
+            printf("Unknown or incomplete command line argument %s.\n", argv[i]);
+        }
+    }
+
+    return CmdLine;
+}
+
+void UpdateInputReplay(input_replay *Replay, command_line *CmdLine, game_memory *Memory, 
+                       game_context *Context, game_input *Input, real64 CurrentTime)
+{
+    if(!Memory->IsGameInitialized)
+    {
+        return;
+    }
+
+    replay_mode LastMode = Replay->Mode;
+
+    // NOTE - Modes requested on the command line start as soon as there is a game state.
+    // Otherwise, L cycles Idle -> Recording -> Playing -> Idle
+    if(CmdLine->RecordName)
+    {
+        BeginInputRecording(Replay, Memory);
+        CmdLine->RecordName = NULL;
+    }
+    else if(CmdLine->PlaybackName)
+    {
+        BeginInputPlayback(Replay, Memory, CurrentTime);
+        CmdLine->PlaybackName = NULL;
+    }
+    else if(KEY_UP(Input->KeyL))
+    {
+        switch(Replay->Mode)
+        {
+            case REPLAY_IDLE:
+                BeginInputRecording(Replay, Memory);
+                break;
+            case REPLAY_RECORDING:
+                EndInputRecording(Replay);
+                BeginInputPlayback(Replay, Memory, CurrentTime);
+                break;
+            case REPLAY_PLAYING:
+                EndInputPlayback(Replay);
+                break;
+        }
+    }
+
+    if(Replay->Mode == REPLAY_RECORDING)
+    {
+        RecordInput(Replay, Input);
+    }
+    else if(Replay->Mode == REPLAY_PLAYING)
+    {
+        bool LoopDone = PlaybackInput(Replay, Memory, Input, CurrentTime);
+        if(LoopDone && CmdLine->PlaybackLoops > 0 && Replay->LoopCount >= (uint32)CmdLine->PlaybackLoops)
+        {
+            Context->IsRunning = false;
+        }
+    }
+
+    // NOTE - Playback runs at full speed
+    if(LastMode != Replay->Mode && (LastMode == REPLAY_PLAYING || Replay->Mode == REPLAY_PLAYING))
+    {
+        glfwSwapInterval(Replay->Mode == REPLAY_PLAYING ? 0 : Memory->Config.VSync);
+    }
+}
+
+// NOTE - Frame limiter, used when VSync is off.
+// Sleeping is cheap but the OS wakes us up late by a variable amount, so we
+// sleep until a margin before the deadline and spin the rest. The margin
+// follows the oversleep actually observed on this machine.
+#define FRAME_REPORT_PERIOD 5.0
+#define FRAME_SPIN_MARGIN_MIN 0.00025
+#define FRAME_SPIN_MARGIN_MAX 0.004
+
+struct frame_stats
+{
+    uint32 Count;
+    uint32 LateCount;
+    real64 Min;
+    real64 Max;
+    real64 Mean;
+    real64 M2;          // Sum of squared deviations, for the variance
+    real64 SleepTime;
+    real64 SpinTime;
+};
+
+struct frame_limiter
+{
+    real64 TargetSecondsPerFrame;   // 0 : unlimited
+    real64 NextDeadline;
+    real64 LastFrameEnd;
+    real64 SpinMargin;
+
+    real64 NextReport;
+    frame_stats Period;
+    frame_stats Total;
+};
+
+void ResetFrameStats(frame_stats *Stats)
+{
+    *Stats = frame_stats();
+    Stats->Min = 1e9;
+}
+
+void AccumulateFrameStats(frame_stats *Stats, real64 FrameTime, real64 Target)
+{
+    Stats->Count++;
+    Stats->Min = Min(Stats->Min, FrameTime);
+    Stats->Max = Max(Stats->Max, FrameTime);
+
+    // NOTE - Welford's online variance
+    real64 Delta = FrameTime - Stats->Mean;
+    Stats->Mean += Delta / Stats->Count;
+    Stats->M2 += Delta * (FrameTime - Stats->Mean);
+
+    if(Target > 0.0 && FrameTime > Target * 1.05)
+    {
+        Stats->LateCount++;
+    }
+}
+
+void PrintFrameStats(char const *Label, frame_stats *Stats, real64 Target)
+{
+    if(Stats->Count < 2)
+    {
+        return;
+    }
+
+    real64 StdDev = sqrt(Stats->M2 / (Stats->Count - 1));
+    real64 Elapsed = Stats->Mean * Stats->Count;
+    printf("%s : %u frames, avg %.3fms, min %.3fms, max %.3fms, jitter (stddev) %.3fms",
+           Label, Stats->Count, 1000.0 * Stats->Mean, 1000.0 * Stats->Min, 1000.0 * Stats->Max, 1000.0 * StdDev);
+    if(Target > 0.0)
+    {
+        printf(", target %.3fms, %u late, %.1f%% asleep, %.1f%% spinning",
+               1000.0 * Target, Stats->LateCount, 100.0 * Stats->SleepTime / Elapsed, 100.0 * Stats->SpinTime / Elapsed);
+    }
+    printf(".\n");
+}
+
+void SetFrameLimiterTarget(frame_limiter *Limiter, int32 TargetFPS)
+{
+    Limiter->TargetSecondsPerFrame = TargetFPS > 0 ? 1.0 / (real64)TargetFPS : 0.0;
+}
+
+void InitFrameLimiter(frame_limiter *Limiter, int32 TargetFPS)
+{
+    real64 Now = PlatformGetWallClock();
+
+    SetFrameLimiterTarget(Limiter, TargetFPS);
+    Limiter->NextDeadline = Now;
+    Limiter->LastFrameEnd = 0.0;
+    Limiter->SpinMargin = 0.001;
+    Limiter->NextReport = Now + FRAME_REPORT_PERIOD;
+    ResetFrameStats(&Limiter->Period);
+    ResetFrameStats(&Limiter->Total);
+}
+
+// NOTE - Called once per frame, right before presenting it
+void WaitForFrameDeadline(frame_limiter *Limiter, bool Enabled)
+{
+    real64 Target = Limiter->TargetSecondsPerFrame;
+    real64 Now = PlatformGetWallClock();
+    real64 SleepTime = 0.0, SpinTime = 0.0;
+
+    if(Enabled && Target > 0.0)
+    {
+        // NOTE - More than a frame late (hitch, window drag, breakpoint...) :
+        // don't rush frames to catch up, restart the schedule from now.
+        if(Now > Limiter->NextDeadline + Target)
+        {
+            Limiter->NextDeadline = Now;
+        }
+
+        real64 WakeTime = Limiter->NextDeadline - Limiter->SpinMargin;
+        if(Now < WakeTime)
+        {
+            PlatformSleepUntil(WakeTime);
+            real64 Woken = PlatformGetWallClock();
+            real64 Oversleep = Woken - WakeTime;
+
+            // NOTE - Widen the margin right away if it was too short, narrow it slowly
+            if(Oversleep > Limiter->SpinMargin)
+                Limiter->SpinMargin = Min(Oversleep * 1.25, FRAME_SPIN_MARGIN_MAX);
+            else
+                Limiter->SpinMargin = Max(Limiter->SpinMargin * 0.99, FRAME_SPIN_MARGIN_MIN);
+
+            SleepTime = Woken - Now;
+            Now = Woken;
+        }
+
+        real64 SpinStart = Now;
+        while(Now < Limiter->NextDeadline)
+        {
+            CPUPause();
+            Now = PlatformGetWallClock();
+        }
+        SpinTime = Now - SpinStart;
+
+        Limiter->NextDeadline += Target;
+    }
+    else
+    {
+        Limiter->NextDeadline = Now;
+        Target = 0.0;
+    }
+
+    // NOTE - No previous frame to measure against on the first one
+    if(Limiter->LastFrameEnd > 0.0)
+    {
+        real64 FrameTime = Now - Limiter->LastFrameEnd;
+        frame_stats *AllStats[2] = { &Limiter->Period, &Limiter->Total };
+        for(uint32 i = 0; i < 2; ++i)
+        {
+            AccumulateFrameStats(AllStats[i], FrameTime, Target);
+            AllStats[i]->SleepTime += SleepTime;
+            AllStats[i]->SpinTime += SpinTime;
+        }
+    }
+    Limiter->LastFrameEnd = Now;
+
+    if(Now >= Limiter->NextReport)
+    {
+        if(Enabled && Target > 0.0)
+        {
+            PrintFrameStats("Frame pacing", &Limiter->Period, Target);
+        }
+        ResetFrameStats(&Limiter->Period);
+        Limiter->NextReport = Now + FRAME_REPORT_PERIOD;
+    }
+}
+
+// NOTE - Fixed timestep accumulator. Frame time is clamped so that a long
+// hitch doesn't turn into a burst of steps, and so are the steps per frame :
+// past that, the simulation slows down instead of spiraling.
+#define MAX_FRAME_TIME 0.25
+#define MAX_STEPS_PER_FRAME 8
+
+struct fixed_timestep
+{
+    real64 StepTime;
+    real64 Accumulator;
+};
+
+void InitFixedTimestep(fixed_timestep *Timestep, int32 SimulationHz)
+{
+    Timestep->StepTime = 1.0 / (real64)Max(SimulationHz, 1);
+    Timestep->Accumulator = 0.0;
+}
+
+void AdvanceFixedTimestep(fixed_timestep *Timestep, game_input *Input)
+{
+    Timestep->Accumulator += Min(Input->dTime, MAX_FRAME_TIME);
+
+    uint32 StepCount = (uint32)(Timestep->Accumulator / Timestep->StepTime);
+    if(StepCount > MAX_STEPS_PER_FRAME)
+    {
+        StepCount = MAX_STEPS_PER_FRAME;
+        Timestep->Accumulator = fmod(Timestep->Accumulator, Timestep->StepTime) + StepCount * Timestep->StepTime;
+    }
+    Timestep->Accumulator -= StepCount * Timestep->StepTime;
+
+    Input->dTimeFixed = Timestep->StepTime;
+    Input->FixedStepCount = StepCount;
+    Input->Alpha = (real32)(Timestep->Accumulator / Timestep->StepTime);
+}
+
+// NOTE - Game code reload. The new library is copied under a new name and
+// loaded on its own thread while the old one keeps running, then swapped in
+// at the start of a frame. Nothing from the old one is running at that point :
+// the jobs the game submits are all waited for inside GameUpdate.
+struct game_code_loader
+{
+    path SrcPath;
+    path LoadedPath;    // Copy currently in use
+    path LoadingPath;
+    uint32 Version;
+
+    platform_thread Thread;
+    bool Threaded;
+    game_code Code;
+    int32 volatile Done;
+
+    bool InFlight;
+    bool Pending;       // Changed again during the load
+};
+
+static void MakeGameCodeCopyPath(path Dst, uint32 Version)
+{
+    path Name;
+    snprintf(Name, MAX_PATH, DllDynamicCopyFormat, Version);
+    MakeRelativePath(Dst, ExecutableFullPath, Name);
+}
+
+static void _GameCodeLoaderThread(void *Param)
+{
+    game_code_loader *Loader = (game_code_loader*)Param;
+    Loader->Code = LoadGameCode(Loader->SrcPath, Loader->LoadingPath);
+    AtomicExchange32(&Loader->Done, 1);
+}
+
+// NOTE - The first load is synchronous, there is nothing to run in the meantime
+game_code InitGameCodeLoader(game_code_loader *Loader, path DllSrcPath)
+{
+    memset(Loader, 0, sizeof(game_code_loader));
+    memcpy(Loader->SrcPath, DllSrcPath, MAX_PATH);
+    MakeGameCodeCopyPath(Loader->LoadedPath, Loader->Version);
+    return LoadGameCode(Loader->SrcPath, Loader->LoadedPath);
+}
+
+void BeginGameCodeReload(game_code_loader *Loader)
+{
+    if(Loader->InFlight)
+    {
+        Loader->Pending = true;
+        return;
+    }
+
+    MakeGameCodeCopyPath(Loader->LoadingPath, ++Loader->Version);
+    Loader->Done = 0;
+    Loader->InFlight = true;
+    Loader->Threaded = PlatformCreateThread(&Loader->Thread, _GameCodeLoaderThread, Loader);
+    if(!Loader->Threaded)
+    {
+        _GameCodeLoaderThread(Loader);
+    }
+}
+
+// NOTE - Called at the frame boundary. Returns true if Game was replaced.
+// A library that failed to load is dropped and the current one kept.
+bool EndGameCodeReload(game_code_loader *Loader, game_code *Game)
+{
+    if(!Loader->InFlight || !AtomicLoad32(&Loader->Done))
+    {
+        return false;
+    }
+
+    if(Loader->Threaded)
+    {
+        PlatformJoinThread(&Loader->Thread);
+    }
+    Loader->InFlight = false;
+
+    bool Swapped = Loader->Code.IsValid;
+    if(Swapped)
+    {
+        UnloadGameCode(Game, Loader->LoadedPath);
+        *Game = Loader->Code;
+        memcpy(Loader->LoadedPath, Loader->LoadingPath, MAX_PATH);
+    }
+    else
+    {
+        printf("Game code reload failed, keeping the previous version.\n");
+        UnloadGameCode(&Loader->Code, Loader->LoadingPath);
+    }
+
+    if(Loader->Pending)
+    {
+        Loader->Pending = false;
+        BeginGameCodeReload(Loader);
+    }
+
+    return Swapped;
+}
+
+void DestroyGameCodeLoader(game_code_loader *Loader, game_code *Game)
+{
+    if(Loader->InFlight)
+    {
+        if(Loader->Threaded)
+        {
+            PlatformJoinThread(&Loader->Thread);
+        }
+        UnloadGameCode(&Loader->Code, Loader->LoadingPath);
+    }
+    UnloadGameCode(Game, Loader->LoadedPath);
+}
+
+// NOTE - Hot reload : the platform watches the executable directory for the
+// game code and the config, and the shaders directory (watch.h).
+enum watch_directory
+{
+    WATCH_EXECUTABLE,
+    WATCH_SHADERS,
+
+    WATCH_DIRECTORY_COUNT
+};
+
+struct file_changes
+{
+    bool GameCode;
+    bool Config;
+    bool Lost;          // Notifications were dropped, anything might have changed
+    uint32 Shaders;     // A bit per ShaderTable entry
+};
+
+// NOTE - Called once per frame. An editor or a linker can report the same file
+// several times in a row, it's only reloaded once.
+file_changes DrainFileChanges(platform_file_watcher *Watcher)
+{
+    file_changes Changes = {};
+    if(!Watcher->IsValid)
+    {
+        return Changes;
+    }
+
+    file_change Change;
+    while(PopFileChange(&Watcher->Queue, &Change))
+    {
+        if(Change.Directory == WATCH_EXECUTABLE)
+        {
+            Changes.GameCode |= !strcmp(Change.Name, DllName);
+            Changes.Config |= !strcmp(Change.Name, "config.json");
+        }
+        else if(Change.Directory == WATCH_SHADERS)
+        {
+            for(uint32 i = 0; i < SHADER_COUNT; ++i)
+            {
+                if(!strcmp(Change.Name, ShaderTable[i].VSName) || !strcmp(Change.Name, ShaderTable[i].FSName))
+                {
+                    Changes.Shaders |= 1 << i;
+                }
+            }
+        }
+    }
+
+    if(AtomicExchange32(&Watcher->Queue.Overflow, 0))
+    {
+        Changes.Lost = true;
+        Changes.Config = true;
+        Changes.Shaders = (1 << SHADER_COUNT) - 1;
+    }
+
+    return Changes;
+}
+
+// NOTE - Applies what can change while running. The window size, MSAA, fullscreen
+// and anisotropic filtering are only read at startup.
+void ApplyConfigChanges(game_memory *Memory, game_context *Context, game_config const *OldConfig,
+                        frame_limiter *Limiter, fixed_timestep *Timestep)
+{
+    game_config const &Config = Memory->Config;
+
+    if(Config.VSync != OldConfig->VSync && !Context->Headless)
+    {
+        glfwSwapInterval(Config.VSync);
+    }
+
+    if(Config.FOV != OldConfig->FOV)
+    {
+        // NOTE - Rebuilds the projection at the next frame
+        Context->FOV = Config.FOV;
+        Resized = true;
+    }
+
+    SetFrameLimiterTarget(Limiter, Config.TargetFPS);
+    Timestep->StepTime = 1.0 / (real64)Max(Config.SimulationHz, 1);
+    ProfilerApplyConfig(&Config);
+
+    // NOTE - The camera speeds are in the game state, the game applies them itself
+    Memory->ConfigChanged = true;
+}
+
 int RadarMain(int argc, char **argv)
 {
+    command_line CmdLine = ParseCommandLine(argc, argv);
+
     path DllSrcPath;
-    path DllDstPath;
 
     GetExecutablePath(ExecutableFullPath);
     MakeRelativePath(DllSrcPath, ExecutableFullPath, DllName);
-    MakeRelativePath(DllDstPath, ExecutableFullPath, DllDynamicCopyName);
 
     path ConfigPath;
     MakeRelativePath(ConfigPath, ExecutableFullPath, "config.json");
 
+    path QuickSavePath;
+    MakeRelativePath(QuickSavePath, ExecutableFullPath, "quicksave.rsnp");
+
+    path CaptureDir;
+    MakeRelativePath(CaptureDir, ExecutableFullPath, "captures/");
+
     game_memory Memory = InitMemory();
+    DefaultConfig(&Memory.Config);
     ParseConfig(&Memory, ConfigPath);
-    game_context Context = InitContext(&Memory);
-    game_code Game = LoadGameCode(DllSrcPath, DllDstPath);
+    if(Memory.IsValid)
+    {
+        InitProfiler(&Memory, CaptureDir);
+        InitJobSystem(&Memory);
+    }
+    game_context Context = InitContext(&Memory, CmdLine.Headless);
+    int ExitCode = (Context.IsValid && Memory.IsValid) ? 0 : 1;
+    game_code_loader GameLoader;
+    game_code Game = InitGameCodeLoader(&GameLoader, DllSrcPath);
     game_config const &Config = Memory.Config;
 
     if(Context.IsValid && Memory.IsValid)
     {
         real64 CurrentTime, LastTime = glfwGetTime();
-        int GameRefreshHz = 60;
-        real64 TargetSecondsPerFrame = 1.0 / (real64)GameRefreshHz;
+
+        frame_limiter Limiter;
+        InitFrameLimiter(&Limiter, Config.TargetFPS);
+
+        fixed_timestep Timestep;
+        InitFixedTimestep(&Timestep, Config.SimulationHz);
+
+        path ShadersDir;
+        MakeRelativePath(ShadersDir, ExecutableFullPath, "data/shaders/");
+        char const *WatchedDirectories[WATCH_DIRECTORY_COUNT] = { ExecutableFullPath, ShadersDir };
+
+        platform_file_watcher Watcher;
+        if(!PlatformStartFileWatcher(&Watcher, WatchedDirectories, WATCH_DIRECTORY_COUNT))
+        {
+            printf("File Watcher : unavailable, polling the game code instead.\n");
+        }
 
         uiInit(&Context);
 
@@ -612,10 +1264,21 @@ int RadarMain(int argc, char **argv)
 
         System->ConsoleLog = (console_log*)PushArenaStruct(&Memory.SessionArena, console_log);
         System->SoundData = (tmp_sound_data*)PushArenaStruct(&Memory.SessionArena, tmp_sound_data);
+        System->UITextLines = (memory_pool*)PushArenaStruct(&Memory.SessionArena, memory_pool);
+        InitPoolStruct(System->UITextLines, &Memory.SessionArena, ui_text_line, UI_MAXTEXTLINES);
 
-        ReloadShaders(&Memory, &Context, ExecutableFullPath);
-        glActiveTexture(GL_TEXTURE0);
+        InitUniformBuffers();
+        InitUniformNames(&Memory.SessionArena);
+        ReloadShaders(&Memory, ExecutableFullPath);
+        GLActiveTexture(0);
         CheckGLError("Start");
+
+        path GpuLogPath;
+        if(CmdLine.GpuLogName)
+        {
+            MakeRelativePath(GpuLogPath, ExecutableFullPath, CmdLine.GpuLogName);
+        }
+        InitGpuProfiler(&Memory, CmdLine.GpuLogName ? GpuLogPath : NULL);
 /////////////////////////
     // TEMP TESTS
 #if 0
@@ -662,28 +1325,13 @@ int RadarMain(int argc, char **argv)
         font ConsoleFont = LoadFont(&Memory, "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf", 14);
 #endif
 
-        // Cube Meshes Test
-        mesh Cube = MakeUnitCube();
-        real32 Dim = 20.0f;
-        vec3f LowDim = -Dim/2;
-        vec3f CubePos[] = {
-            LowDim + vec3f(Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX),
-            LowDim + vec3f(Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX),
-            LowDim + vec3f(Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX),
-            LowDim + vec3f(Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX),
-            LowDim + vec3f(Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX)
-        };
-        vec3f CubeRot[] = {
-            vec3f(2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX),
-            vec3f(2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX),
-            vec3f(2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX),
-            vec3f(2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX),
-            vec3f(2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX)
-        };
-        mesh Sphere = MakeUnitSphere();
-
-        int PlaneWidth = 256;
-        mesh UnderPlane = Make3DPlane(&Memory, vec2i(PlaneWidth, PlaneWidth), 1, 10);
+        // NOTE - The static scene meshes share one mesh_buffer, the render commands
+        // draw them with one multi-draw per pass and texture set
+        mesh_buffer StaticMeshes = MakeMeshBuffer(Config.PackedVertices);
+        mesh Cube = MakeUnitCube(true, &Memory, &StaticMeshes);
+        mesh Sphere = MakeUnitSphere(true, &Memory, &StaticMeshes);
+
+        mesh UnderPlane = Make3DPlane(&Memory, vec2i(RENDER_PLANE_WIDTH, RENDER_PLANE_WIDTH), 1, 10, false, &StaticMeshes);
 
 
         // Cubemaps Test
@@ -714,50 +1362,168 @@ int RadarMain(int argc, char **argv)
             }
         }
 
-        mesh SkyboxCube = MakeUnitCube(false);
+        mesh SkyboxCube = MakeUnitCube(false, &Memory, &StaticMeshes);
         uint32 TestCubemap = MakeCubemap(CubemapPaths, false, false, 0, 0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, TestCubemap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, TestCubemap);
-        glActiveTexture(GL_TEXTURE0);
+        GLBindTexture(0, GL_TEXTURE_CUBE_MAP, TestCubemap);
+        GLBindTexture(1, GL_TEXTURE_CUBE_MAP, TestCubemap);
+        GLActiveTexture(0);
 
         uint32 HDRCubemapEnvmap, HDRIrradianceEnvmap;
         ComputeIrradianceCubemap(&Memory, ExecutableFullPath, "data/envmap_monument.hdr", &HDRCubemapEnvmap, &HDRIrradianceEnvmap);
         uint32 EnvmapToUse = HDRCubemapEnvmap; 
 
+        render_resources RenderResources = {};
+        RenderResources.Programs[RENDER_SHADER_MESH] = &Program3D;
+        RenderResources.Programs[RENDER_SHADER_WATER] = &ProgramWater;
+        RenderResources.Programs[RENDER_SHADER_SKYBOX] = &ProgramSkybox;
+        RenderResources.Meshes[RENDER_MESH_CUBE] = Cube;
+        RenderResources.Meshes[RENDER_MESH_SPHERE] = Sphere;
+        RenderResources.Meshes[RENDER_MESH_PLANE] = UnderPlane;
+        RenderResources.Meshes[RENDER_MESH_SKYBOX] = SkyboxCube;
+        RenderResources.VertexFormat = StaticMeshes.Format;
+        RenderResources.Textures[RENDER_TEXTURE_CRATE] = Texture1;
+        RenderResources.Textures[RENDER_TEXTURE_DEFAULT] = Context.DefaultDiffuseTexture;
+        RenderResources.Textures[RENDER_TEXTURE_IRRADIANCE] = HDRIrradianceEnvmap;
+        RenderResources.TextureTargets[RENDER_TEXTURE_CRATE] = GL_TEXTURE_2D;
+        RenderResources.TextureTargets[RENDER_TEXTURE_DEFAULT] = GL_TEXTURE_2D;
+        RenderResources.TextureTargets[RENDER_TEXTURE_ENVMAP] = GL_TEXTURE_CUBE_MAP;
+        RenderResources.TextureTargets[RENDER_TEXTURE_IRRADIANCE] = GL_TEXTURE_CUBE_MAP;
+
+        InitRenderBuffers(&Memory, &RenderResources);
+
+        System->RenderCommands = (render_commands*)PushArenaStruct(&Memory.SessionArena, render_commands);
+        InitRenderCommands(&Memory, System->RenderCommands);
+
         bool LastDisableMouse = false;
 
+        bench_run Bench = {};
+        if(CmdLine.BenchScript)
+        {
+            InitBenchRun(&Bench, &Memory, CmdLine.BenchScript, 0,
+                         CmdLine.SummaryName ? CmdLine.SummaryName : "bench_summary.json",
+                         CmdLine.CSVName ? CmdLine.CSVName : "bench_frames.csv");
+            if(!Bench.IsActive)
+            {
+                Context.IsRunning = false;
+                ExitCode = 1;
+            }
+        }
+        else if(CmdLine.Headless)
+        {
+            InitBenchRun(&Bench, &Memory, NULL, CmdLine.BenchFrames,
+                         CmdLine.SummaryName ? CmdLine.SummaryName : "headless_summary.json", CmdLine.CSVName);
+        }
+
+        // NOTE - Bench runs measure the frames as fast as they go, VSync would only measure the display
+        if(Bench.IsActive)
+        {
+            glfwSwapInterval(0);
+        }
+
+        input_replay Replay;
+        char const *ReplayName = CmdLine.PlaybackName ? CmdLine.PlaybackName : (CmdLine.RecordName ? CmdLine.RecordName : "loop");
+        InitInputReplay(&Replay, ExecutableFullPath, ReplayName);
+
         while(Context.IsRunning)
         {
+            ProfileNewFrame();
+            GpuProfileBeginFrame();
+            GLStateNewFrame();
+
             game_input Input = {};
 
             CurrentTime = glfwGetTime();
             Input.dTime = CurrentTime - LastTime;
 
             LastTime = CurrentTime;
-            State->EngineTime += Input.dTime;
 
             // NOTE - Each frame, clear the Scratch Arena Data
             // TODO - Is this too often ? Maybe let it stay several frames
             ClearArena(&Memory.ScratchArena);
 
             GetFrameInput(&Context, &Input);        
+            ProfilerUpdateCapture(&Input);
+
+            if(Bench.IsActive)
+            {
+                BeginBenchFrame(&Bench, &Input);
+            }
+
+            // NOTE - Before the replay, so that recordings keep the exact step counts
+            AdvanceFixedTimestep(&Timestep, &Input);
+
+            // NOTE - Might replace the whole Input (dTime and steps included) when playing back
+            UpdateInputReplay(&Replay, &CmdLine, &Memory, &Context, &Input, CurrentTime);
+            State->EngineTime += Input.dTime;
 
             if(Resized) WindowResized(&Context);
 
-            if(CheckNewDllVersion(&Game, DllSrcPath))
+            file_changes Changes = DrainFileChanges(&Watcher);
+
+            bool GameCodeChanged = (Watcher.IsValid && !Changes.Lost) ? Changes.GameCode : CheckNewDllVersion(&Game, DllSrcPath);
+            if(GameCodeChanged)
             {
-                UnloadGameCode(&Game, NULL);
-                Game = LoadGameCode(DllSrcPath, DllDstPath);
+                BeginGameCodeReload(&GameLoader);
+            }
+            EndGameCodeReload(&GameLoader, &Game);
+
+            if(Changes.Config)
+            {
+                game_config OldConfig = Memory.Config;
+                if(ParseConfig(&Memory, ConfigPath))
+                {
+                    ApplyConfigChanges(&Memory, &Context, &OldConfig, &Limiter, &Timestep);
+                    printf("Config reloaded.\n");
+                }
+                else
+                {
+                    // NOTE - Probably caught mid-save, keep the running one
+                    Memory.Config = OldConfig;
+                }
+            }
+
+            for(uint32 i = 0; i < SHADER_COUNT; ++i)
+            {
+                if(Changes.Shaders & (1 << i))
+                {
+                    ReloadShader(&Memory, ExecutableFullPath, i);
+                }
+            }
+
+            if(KEY_UP(Input.KeyF5) && Memory.IsGameInitialized)
+            {
+                real64 SnapshotStart = glfwGetTime();
+                if(SaveGameSnapshot(&Memory, QuickSavePath))
+                {
+                    printf("Quicksave written in %.2fms.\n", 1000.0 * (glfwGetTime() - SnapshotStart));
+                }
+            }
+
+            if(KEY_UP(Input.KeyF9) && Memory.IsGameInitialized)
+            {
+                real64 SnapshotStart = glfwGetTime();
+                if(LoadGameSnapshot(&Memory, QuickSavePath))
+                {
+                    printf("Quicksave loaded in %.2fms.\n", 1000.0 * (glfwGetTime() - SnapshotStart));
+                }
             }
 
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
             uiBeginFrame(&Memory, &Input);
-            Game.GameUpdate(&Memory, &Input);
+            ResetRenderCommands(System->RenderCommands);
+            System->RenderCommands->ProjMatrix = Context.ProjectionMatrix3D;
+            {
+                TIMED_BLOCK("GameUpdate");
+                Game.GameUpdate(&Memory, &Input);
+            }
             if(!Memory.IsInitialized)
             {
                 InitializeFromGame(&Memory);
+                RenderResources.Meshes[RENDER_MESH_WATER].VAO = System->WaterSystem->VAO;
+                RenderResources.Instances.MeshVAOs[RENDER_MESH_WATER] = 0;
+                RenderResources.Meshes[RENDER_MESH_WATER].IndexCount = System->WaterSystem->IndexCount;
+                RenderResources.Meshes[RENDER_MESH_WATER].IndexType = System->WaterSystem->IndexType;
             }
 
 #if 0
@@ -790,7 +1556,7 @@ int RadarMain(int argc, char **argv)
 
             if(KEY_DOWN(Input.KeyLShift) && KEY_UP(Input.KeyF11))
             {
-                ReloadShaders(&Memory, &Context, ExecutableFullPath);
+                ReloadShaders(&Memory, ExecutableFullPath);
             }
 
             if(KEY_UP(Input.KeyF1))
@@ -807,197 +1573,70 @@ int RadarMain(int argc, char **argv)
                     EnvmapToUse = HDRCubemapEnvmap;
             }
 
+            UpdateWater(&Memory.Jobs, &Memory.ScratchArena, State, System, &Input, State->WaterState, State->WaterStateInterp);
 
-            game_camera &Camera = State->Camera;
-            mat4f ViewMatrix = mat4f::LookAt(Camera.Position, Camera.Target, Camera.Up);
-
-            { // NOTE - CUBE DRAWING Test Put somewhere else
-                glUseProgram(Program3D);
-                {
-
-                    uint32 Loc = glGetUniformLocation(Program3D, "ViewMatrix");
-                    SendMat4(Loc, ViewMatrix);
-                    CheckGLError("ViewMatrix");
-                }
-
-                uint32 Loc = glGetUniformLocation(Program3D, "LightColor");
-                SendVec4(Loc, State->LightColor);
-                Loc = glGetUniformLocation(Program3D, "SunDirection");
-                SendVec3(Loc, State->LightDirection);
-                Loc = glGetUniformLocation(Program3D, "CameraPos");
-                SendVec3(Loc, State->Camera.Position);
-                glBindVertexArray(Cube.VAO);
-                glBindTexture(GL_TEXTURE_2D, Texture1);
-                mat4f ModelMatrix;// = mat4f::Translation(State->PlayerPosition);
-                Loc = glGetUniformLocation(Program3D, "ModelMatrix");
-                for(uint32 i = 0; i < 5; ++i)
-                {
-                    ModelMatrix.FromTRS(CubePos[i], CubeRot[i], vec3f(1.f));
-                    SendMat4(Loc, ModelMatrix);
-                    CheckGLError("ModelMatrix");
-                    glDrawElements(GL_TRIANGLES, Cube.IndexCount, GL_UNSIGNED_INT, 0);
-                }
+            RenderResources.Textures[RENDER_TEXTURE_ENVMAP] = EnvmapToUse;
+            RenderResources.ProjMatrix = Context.ProjectionMatrix3D;
+            RenderResources.OrthoMatrix = Context.ProjectionMatrix2D;
+            RenderResources.OcclusionCulling = Memory.Config.OcclusionCulling;
+            render_stats RenderStats = ExecuteRenderCommands(&Memory, System->RenderCommands, &RenderResources);
 
-                real32 hW = PlaneWidth/2.f;
-                ModelMatrix.FromTRS(vec3f(-hW, -7.f, -hW), vec3f(0), vec3f(1));
-                SendMat4(Loc, ModelMatrix);
-                glBindVertexArray(UnderPlane.VAO);
-                glDrawElements(GL_TRIANGLES, UnderPlane.IndexCount, GL_UNSIGNED_INT, 0);
+            {
+                TIMED_BLOCK("MakeUI");
+                MakeUI(&Memory, &Context, &ConsoleFont);
+                ProfilerDrawOverlay(&Context, &Input, &ConsoleFont, &RenderStats);
+            }
+            {
+                GPU_ZONE("UI");
+                uiDraw();
             }
+            GpuProfileEndFrame();
 
-            { // NOTE - Sphere Array Test for PBR
-                glUseProgram(Program3D);
-                {
-                    uint32 Loc = glGetUniformLocation(Program3D, "ViewMatrix");
-                    SendMat4(Loc, ViewMatrix);
-                    CheckGLError("ViewMatrix");
-                }
-                uint32 Loc = glGetUniformLocation(Program3D, "LightColor");
-                SendVec4(Loc, State->LightColor);
-                Loc = glGetUniformLocation(Program3D, "SunDirection");
-                SendVec3(Loc, State->LightDirection);
-                Loc = glGetUniformLocation(Program3D, "CameraPos");
-                SendVec3(Loc, State->Camera.Position);
-
-                glBindVertexArray(Sphere.VAO);
-                mat4f ModelMatrix;
-                Loc = glGetUniformLocation(Program3D, "ModelMatrix");
-
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, Context.DefaultDiffuseTexture);
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, Context.DefaultDiffuseTexture);
-                glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, Context.DefaultDiffuseTexture);
-                glActiveTexture(GL_TEXTURE3);
-                glBindTexture(GL_TEXTURE_CUBE_MAP, EnvmapToUse);
-                glActiveTexture(GL_TEXTURE4);
-                glBindTexture(GL_TEXTURE_CUBE_MAP, HDRIrradianceEnvmap);
-
-                int Count = 5;
-                uint32 AlbedoLoc = glGetUniformLocation(Program3D, "AlbedoMult");
-                uint32 MetallicLoc = glGetUniformLocation(Program3D, "MetallicMult");
-                uint32 RoughnessLoc = glGetUniformLocation(Program3D, "RoughnessMult");
-                SendVec3(AlbedoLoc, vec3f(1));
-                for(int j = 0; j < Count; ++j)
-                {
-                    SendFloat(MetallicLoc, (j+1)/(real32)Count);
-                    for(int i = 0; i < Count; ++i)
-                    {
-                        SendFloat(RoughnessLoc, (i+1)/(real32)Count);
-                        ModelMatrix.FromTRS(vec3f(0, 3*(j+1), 3*(i+1)), vec3f(0.f), vec3f(1.f));
-                        SendMat4(Loc, ModelMatrix);
-                        glDrawElements(GL_TRIANGLES, Sphere.IndexCount, GL_UNSIGNED_INT, 0);
-                    }
-                }
-                glActiveTexture(GL_TEXTURE0);
+            {
+                // NOTE - VSync already paces the frames, and playback runs unthrottled
+                TIMED_BLOCK("Frame Wait");
+                WaitForFrameDeadline(&Limiter, !Config.VSync && Replay.Mode != REPLAY_PLAYING && !Bench.IsActive);
             }
-#if 1
-            UpdateWater(State, System, &Input, State->WaterState, State->WaterStateInterp);
-            { // NOTE - Water Rendering Test
-                glUseProgram(ProgramWater);
-                glDisable(GL_CULL_FACE);
-                {
-                    uint32 Loc = glGetUniformLocation(ProgramWater, "ViewMatrix");
-                    SendMat4(Loc, ViewMatrix);
-                    CheckGLError("ViewMatrix");
-                }
-                uint32 Loc = glGetUniformLocation(ProgramWater, "LightColor");
-                SendVec4(Loc, State->LightColor);
-                Loc = glGetUniformLocation(ProgramWater, "CameraPos");
-                SendVec3(Loc, State->Camera.Position);
-                Loc = glGetUniformLocation(ProgramWater, "SunDirection");
-                SendVec3(Loc, State->LightDirection);
-                Loc = glGetUniformLocation(ProgramWater, "Time");
-                SendFloat(Loc, State->EngineTime);
-
-                water_system *WaterSystem = System->WaterSystem;
-
-                real32 hW = PlaneWidth/2.f;
-
-                Loc = glGetUniformLocation(ProgramWater, "ModelMatrix");
-                mat4f ModelMatrix;
-                glBindVertexArray(WaterSystem->VAO);
-
-                water_beaufort_state *WaterStateA = &WaterSystem->States[State->WaterState];
-                water_beaufort_state *WaterStateB = &WaterSystem->States[State->WaterState + 1];
-                real32 dWidth = Mix((real32)WaterStateA->Width, (real32)WaterStateB->Width, State->WaterStateInterp);
-                //dWidth *= (State->WaterState+1) * 1.5;
-
-                real32 Interp = (State->WaterState+1) + State->WaterStateInterp;
-                
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_CUBE_MAP, EnvmapToUse);
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_CUBE_MAP, HDRIrradianceEnvmap);
-
-
-                int Repeat = 5;
-                int Middle = (Repeat-1)/2;
-                for(int j = 0; j < Repeat; ++j)
-                {
-                    for(int i = 0; i < Repeat; ++i)
-                    {
-                        // MIDDLE
-                        real32 PositionScale = dWidth * (Interp);
-                        vec3f Position(PositionScale * (Middle-i), 0.f, PositionScale * (Middle-j));
-                        vec3f Scale(Interp, Interp, Interp);
-                        vec3f Rotation(0, State->WaterDirection, 0);
-                        mat4f RotationMatrix;
-                        RotationMatrix.FromAxisAngle(Rotation);
-                        ModelMatrix.FromTRS(Position, vec3f(0), Scale);
-                        ModelMatrix = RotationMatrix * ModelMatrix;
-
-                        SendMat4(Loc, ModelMatrix);
-                        glDrawElements(GL_TRIANGLES, WaterSystem->IndexCount, GL_UNSIGNED_INT, 0);
-                    }
-                }
-                glEnable(GL_CULL_FACE);
+            {
+                TIMED_BLOCK("SwapBuffers");
+                glfwSwapBuffers(Context.Window);
             }
-#endif
-
-            { // NOTE - Skybox Rendering Test, put somewhere else
-                glDisable(GL_CULL_FACE);
-                glDepthFunc(GL_LEQUAL);
-                CheckGLError("Skybox");
-
-                glUseProgram(ProgramSkybox);
-                {
-                    // NOTE - remove translation component from the ViewMatrix for the skybox
-                    mat4f SkyViewMatrix = ViewMatrix;
-                    SkyViewMatrix.SetTranslation(vec3f(0.f));
-                    uint32 Loc = glGetUniformLocation(ProgramSkybox, "ViewMatrix");
-                    SendMat4(Loc, SkyViewMatrix);
-                    CheckGLError("ViewMatrix Skybox");
-                }
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_CUBE_MAP, EnvmapToUse);
-                glBindVertexArray(SkyboxCube.VAO);
-                glDrawElements(GL_TRIANGLES, SkyboxCube.IndexCount, GL_UNSIGNED_INT, 0);
 
-                glDepthFunc(GL_LESS);
-                glEnable(GL_CULL_FACE);
+            if(Bench.IsActive && !EndBenchFrame(&Bench))
+            {
+                Context.IsRunning = false;
             }
+        }
 
-            MakeUI(&Memory, &Context, &ConsoleFont);
-            uiDraw();
-
-            glfwSwapBuffers(Context.Window);
+        if(Bench.IsActive && !WriteBenchSummary(&Bench, &Memory))
+        {
+            ExitCode = 1;
         }
 
+        PrintFrameStats("Session frame times", &Limiter.Total, Config.VSync ? 0.0 : Limiter.TargetSecondsPerFrame);
+        PlatformStopFileWatcher(&Watcher);
+
+        if(Replay.Mode == REPLAY_RECORDING) EndInputRecording(&Replay);
+        if(Replay.Mode == REPLAY_PLAYING) EndInputPlayback(&Replay);
+
         // TODO - Destroy Console meshes
         DestroyMesh(&Cube);
         DestroyMesh(&SkyboxCube);
         DestroyMesh(&UnderPlane);
-        glDeleteTextures(1, &Texture1);
-        glDeleteProgram(Program1);
-        glDeleteProgram(Program3D);
-        glDeleteProgram(ProgramSkybox);
+        DestroyMeshBuffer(&StaticMeshes);
+        GLDeleteTextures(1, &Texture1);
+        GLDeleteProgram(Program1.ID);
+        GLDeleteProgram(Program3D.ID);
+        GLDeleteProgram(ProgramSkybox.ID);
+        DestroyRenderBuffers(&RenderResources);
+        DestroyUniformBuffers();
+        DestroyGpuProfiler();
     }
 
+    DestroyJobSystem(&Memory);
     DestroyMemory(&Memory);
     DestroyContext(&Context);
-    UnloadGameCode(&Game, DllDstPath);
+    DestroyGameCodeLoader(&GameLoader, &Game);
 
-    return 0;
+    return ExitCode;
 }
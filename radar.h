@@ -17,8 +17,13 @@ struct game_config
     int32  MSAA;
     bool   FullScreen;
     bool   VSync;
+    int32  TargetFPS;   // Frame limiter when VSync is off, 0 for unlimited
+    int32  SimulationHz;
+    int32  CaptureThresholdMs;  // Frame time that triggers a trace capture, 0 to disable
     real32 FOV;
     int32  AnisotropicFiltering;
+    bool   OcclusionCulling;    // CPU occlusion test after the frustum test
+    bool   PackedVertices;      // Half-size vertices for the static meshes, see packed_vertex
 
     real32 CameraSpeedBase;
     real32 CameraSpeedMult;
@@ -41,6 +46,12 @@ inline void InitArena(memory_arena *Arena, uint64 Capacity, void *BasePtr)
     Arena->Size = 0;
 }
 
+// NOTE - Restart an arena from scratch without touching its memory, contrary to ClearArena
+inline void ResetArena(memory_arena *Arena)
+{
+    Arena->Size = 0;
+}
+
 inline void ClearArena(memory_arena *Arena)
 {
     // TODO - Do we need to wipe this to 0 each time ? Profile it to see if its 
@@ -60,6 +71,254 @@ inline void *_PushArenaData(memory_arena *Arena, uint64 Size)
     return (void*)MemoryPtr;
 }
 
+// NOTE - Fixed-size object pool carved out of an arena (usually the SessionArena).
+// Free slots are chained through their own memory (intrusive free list), so
+// Alloc and Free are O(1). Each slot has a generation counter, bumped on Free,
+// that lets PoolGet reject handles to objects that don't exist anymore.
+#define POOL_INVALID_INDEX 0xFFFFFFFF
+#define POOL_CACHE_SIZE 32
+
+struct pool_handle
+{
+    uint32 Index;
+    uint32 Generation; // 0 is never a valid generation
+};
+
+struct memory_pool
+{
+    uint8  *Slots;
+    uint32 *Generations;
+    uint32 SlotSize;
+    uint32 Capacity;
+    uint32 UsedCount;   // Slots currently out of the pool (live or in a pool_cache)
+    uint32 HighWater;   // Slots ever handed out, the rest was never touched
+    uint32 FreeHead;    // First slot of the free list
+    int32 volatile Lock;
+};
+
+// NOTE - Per-thread stash of free slots. Threads allocating and freeing a lot
+// go through this so they take the pool lock once every POOL_CACHE_SIZE/2 ops.
+struct pool_cache
+{
+    memory_pool *Pool;
+    uint32 Count;
+    uint32 Indices[POOL_CACHE_SIZE];
+};
+
+inline pool_handle InvalidPoolHandle()
+{
+    pool_handle Handle = { POOL_INVALID_INDEX, 0 };
+    return Handle;
+}
+
+#define InitPoolStruct(Pool, Arena, Struct, Capacity) InitPool((Pool), (Arena), sizeof(Struct), (Capacity))
+inline void InitPool(memory_pool *Pool, memory_arena *Arena, uint32 ElementSize, uint32 Capacity)
+{
+    // A free slot must be able to hold the index of the next free slot. Keep them 8B aligned.
+    uint32 SlotSize = Max(ElementSize, (uint32)sizeof(uint32));
+    SlotSize = (SlotSize + 7) & ~7;
+
+    Pool->Slots = (uint8*)PushArenaData(Arena, (uint64)SlotSize * Capacity);
+    Pool->Generations = (uint32*)PushArenaData(Arena, sizeof(uint32) * Capacity);
+    Pool->SlotSize = SlotSize;
+    Pool->Capacity = Capacity;
+    Pool->UsedCount = 0;
+    Pool->HighWater = 0;
+    Pool->FreeHead = POOL_INVALID_INDEX;
+    Pool->Lock = 0;
+
+    for(uint32 i = 0; i < Capacity; ++i)
+    {
+        Pool->Generations[i] = 1;
+    }
+}
+
+inline uint8 *_PoolSlot(memory_pool *Pool, uint32 Index)
+{
+    return Pool->Slots + (uint64)Index * Pool->SlotSize;
+}
+
+// NOTE - Expects the pool lock to be held
+inline uint32 _PoolTakeSlot(memory_pool *Pool)
+{
+    uint32 Index = POOL_INVALID_INDEX;
+    if(Pool->FreeHead != POOL_INVALID_INDEX)
+    {
+        Index = Pool->FreeHead;
+        Pool->FreeHead = *(uint32*)_PoolSlot(Pool, Index);
+    }
+    else if(Pool->HighWater < Pool->Capacity)
+    {
+        Index = Pool->HighWater++;
+    }
+
+    if(Index != POOL_INVALID_INDEX)
+    {
+        Pool->UsedCount++;
+    }
+    return Index;
+}
+
+// NOTE - Expects the pool lock to be held
+inline void _PoolGiveSlot(memory_pool *Pool, uint32 Index)
+{
+    *(uint32*)_PoolSlot(Pool, Index) = Pool->FreeHead;
+    Pool->FreeHead = Index;
+    Pool->UsedCount--;
+}
+
+// NOTE - Bumps the slot's generation if the handle is still valid, false if it was
+// stale. A compare-and-swap : of several threads freeing the same handle, only one
+// retires the slot and gives it back.
+inline bool _PoolRetireSlot(memory_pool *Pool, pool_handle Handle)
+{
+    if(Handle.Index >= Pool->HighWater)
+    {
+        return false;
+    }
+
+    // NOTE - Skip 0 when wrapping so that a zeroed handle is never valid
+    uint32 Generation = Handle.Generation + 1;
+    Generation = Generation ? Generation : 1;
+    return AtomicCompareExchange32((int32 volatile*)&Pool->Generations[Handle.Index], (int32)Handle.Generation, (int32)Generation);
+}
+
+inline pool_handle _PoolHandleFromIndex(memory_pool *Pool, uint32 Index)
+{
+    pool_handle Handle = { Index, Pool->Generations[Index] };
+    memset(_PoolSlot(Pool, Index), 0, Pool->SlotSize);
+    return Handle;
+}
+
+// NOTE - Returns an invalid handle if the pool is full. Memory is zeroed.
+inline pool_handle PoolAlloc(memory_pool *Pool)
+{
+    BeginSpinLock(&Pool->Lock);
+    uint32 Index = _PoolTakeSlot(Pool);
+    EndSpinLock(&Pool->Lock);
+
+    Assert(Index != POOL_INVALID_INDEX);
+    if(Index == POOL_INVALID_INDEX)
+    {
+        return InvalidPoolHandle();
+    }
+    return _PoolHandleFromIndex(Pool, Index);
+}
+
+inline bool PoolIsValid(memory_pool *Pool, pool_handle Handle)
+{
+    return Handle.Index < Pool->HighWater && Pool->Generations[Handle.Index] == Handle.Generation;
+}
+
+#define PoolGetStruct(Pool, Handle, Struct) ((Struct*)PoolGet((Pool), (Handle)))
+inline void *PoolGet(memory_pool *Pool, pool_handle Handle)
+{
+    return PoolIsValid(Pool, Handle) ? (void*)_PoolSlot(Pool, Handle.Index) : NULL;
+}
+
+// NOTE - Freeing a stale handle is a no-op
+inline void PoolFree(memory_pool *Pool, pool_handle Handle)
+{
+    BeginSpinLock(&Pool->Lock);
+    if(_PoolRetireSlot(Pool, Handle))
+    {
+        _PoolGiveSlot(Pool, Handle.Index);
+    }
+    EndSpinLock(&Pool->Lock);
+}
+
+inline void InitPoolCache(pool_cache *Cache, memory_pool *Pool)
+{
+    Cache->Pool = Pool;
+    Cache->Count = 0;
+}
+
+inline pool_handle PoolCacheAlloc(pool_cache *Cache)
+{
+    memory_pool *Pool = Cache->Pool;
+    if(Cache->Count == 0)
+    {
+        BeginSpinLock(&Pool->Lock);
+        while(Cache->Count < POOL_CACHE_SIZE / 2)
+        {
+            uint32 Index = _PoolTakeSlot(Pool);
+            if(Index == POOL_INVALID_INDEX) break;
+            Cache->Indices[Cache->Count++] = Index;
+        }
+        EndSpinLock(&Pool->Lock);
+    }
+
+    Assert(Cache->Count > 0);
+    if(Cache->Count == 0)
+    {
+        return InvalidPoolHandle();
+    }
+    return _PoolHandleFromIndex(Pool, Cache->Indices[--Cache->Count]);
+}
+
+// NOTE - Gives back every cached slot to the pool. Call before a thread exits.
+inline void PoolCacheFlush(pool_cache *Cache, uint32 KeepCount = 0)
+{
+    memory_pool *Pool = Cache->Pool;
+    BeginSpinLock(&Pool->Lock);
+    while(Cache->Count > KeepCount)
+    {
+        _PoolGiveSlot(Pool, Cache->Indices[--Cache->Count]);
+    }
+    EndSpinLock(&Pool->Lock);
+}
+
+inline void PoolCacheFree(pool_cache *Cache, pool_handle Handle)
+{
+    memory_pool *Pool = Cache->Pool;
+    if(!_PoolRetireSlot(Pool, Handle)) return;
+
+    if(Cache->Count == POOL_CACHE_SIZE)
+    {
+        PoolCacheFlush(Cache, POOL_CACHE_SIZE / 2);
+    }
+    Cache->Indices[Cache->Count++] = Handle.Index;
+}
+
+// NOTE - Marker to roll back an arena to a previous state, e.g. at the end
+// of a job that used a long-lived scratch arena.
+struct temp_memory
+{
+    memory_arena *Arena;
+    uint64 Size;
+};
+
+inline temp_memory BeginTempMemory(memory_arena *Arena)
+{
+    temp_memory Temp = { Arena, Arena->Size };
+    return Temp;
+}
+
+inline void EndTempMemory(temp_memory Temp)
+{
+    Assert(Temp.Arena->Size >= Temp.Size);
+    Temp.Arena->Size = Temp.Size;
+}
+
+// NOTE - Per-thread scratch arenas, sub-allocated from the end of the ScratchMemPool.
+// The main ScratchArena is cleared by the platform each frame and is for the main
+// thread only, since its bump isn't atomic. Any other thread doing engine work
+// (loaders, jobs, audio) claims one of these instead.
+// Every job worker keeps one, the spares are for the other threads.
+#define THREAD_SCRATCH_SPARE 8
+#define MAX_THREAD_SCRATCH (MAX_JOB_THREADS + THREAD_SCRATCH_SPARE)
+#define THREAD_SCRATCH_SIZE Megabytes(2)
+
+struct thread_scratch
+{
+    memory_arena Arena;
+    int32 volatile InUse;
+};
+
+#include "containers.h"
+#include "bvh.h"
+#include "job.h"
+
 #define POOL_OFFSET(Pool, Structure) ((uint8*)(Pool) + sizeof(Structure))
 // NOTE - This memory is allocated at startup
 // Each pool is then mapped according to the needed layout
@@ -89,19 +348,62 @@ struct game_memory
     // last more than 1 frame is not a good idea.
     // Use cases : temp buffers for quick operations, vertex data before storing
     // in managed GL VBOs or AL audio buffers.
+    // NOTE - Main thread only. Other threads use AcquireScratchArena.
     void *ScratchMemPool;
     uint64 ScratchMemPoolSize;
     memory_arena ScratchArena;
+    thread_scratch ThreadScratch[MAX_THREAD_SCRATCH];
+
+    // NOTE - Filled by the platform, see job.h
+    job_system_api Jobs;
+
+    // NOTE - Set by the platform when config.json was reloaded, cleared by the game
+    bool ConfigChanged;
 
     bool IsValid;
     bool IsInitialized;
     bool IsGameInitialized;
 };
 
+// NOTE - Claims a free per-thread scratch arena, returned empty. Release it at the end
+// of the job, or keep it for a whole frame and release it at the frame boundary.
+// Returns NULL if all of them are taken, the caller waits or does without.
+inline memory_arena *AcquireScratchArena(game_memory *Memory)
+{
+    for(uint32 i = 0; i < MAX_THREAD_SCRATCH; ++i)
+    {
+        thread_scratch *Scratch = &Memory->ThreadScratch[i];
+        if(AtomicCompareExchange32(&Scratch->InUse, 0, 1))
+        {
+            ResetArena(&Scratch->Arena);
+            return &Scratch->Arena;
+        }
+    }
+
+    return NULL;
+}
+
+inline void ReleaseScratchArena(game_memory *Memory, memory_arena *Arena)
+{
+    for(uint32 i = 0; i < MAX_THREAD_SCRATCH; ++i)
+    {
+        thread_scratch *Scratch = &Memory->ThreadScratch[i];
+        if(&Scratch->Arena == Arena)
+        {
+            ResetArena(Arena);
+            AtomicExchange32(&Scratch->InUse, 0);
+            return;
+        }
+    }
+
+    Assert(!"Not a thread scratch arena");
+}
+
 // NOTE - Systems declarations
 #include "sound.h"
 #include "water.h"
 #include "ui.h"
+#include "render_commands.h"
 
 struct game_system
 {
@@ -109,12 +411,15 @@ struct game_system
     tmp_sound_data *SoundData;
     water_system *WaterSystem;
     ui_frame_stack *UIStack;
+    memory_pool *UITextLines;           // ui_text_line, see ui_frame_stack
+    render_commands *RenderCommands;    // Reset by the platform before each GameUpdate
     void *DLLStorage;
 };
 
 struct game_camera
 {
     vec3f Position;
+    vec3f PreviousPosition; // Before the last fixed step, to interpolate
     vec3f Target;
     vec3f Up;
     vec3f Forward;
@@ -131,6 +436,8 @@ struct game_camera
     vec2i  LastMousePos;
 };
 
+// NOTE - Lives in the PermanentMemPool and is saved/loaded as raw bytes by
+// the snapshot system : keep it pointer-free.
 struct game_state
 {
     real64 EngineTime;
@@ -140,10 +447,21 @@ struct game_state
     vec4f LightColor;
     vec3f LightDirection;
 
+    bool   IsNight;
+    // DayPhase: 0 = noon, pi = midnight
+    real32 DayPhase;
+    // Varies with season
+    real32 EarthTilt;
+    // Latitude: -pi/2 = South pole, +pi/2 = North pole
+    real32 Latitude;
+
     real64 WaterCounter;
     real32 WaterStateInterp;
     real32 WaterDirection;
     int    WaterState;
+
+    vec3f CubePositions[5];
+    vec3f CubeRotations[5];
 };
 
 typedef uint8 key_state;
@@ -161,7 +479,13 @@ typedef uint8 mouse_state;
 struct game_input
 {
     real64 dTime;
+
+    // NOTE - Fixed timestep : the game simulates FixedStepCount steps of
+    // dTimeFixed this frame. Alpha is the fraction of a step left over in the
+    // accumulator, to blend the last two simulated states when rendering.
     real64 dTimeFixed;
+    uint32 FixedStepCount;
+    real32 Alpha;
 
     int32  MousePosX;
     int32  MousePosY;
@@ -172,12 +496,17 @@ struct game_input
     key_state KeyD;
     key_state KeyR;
     key_state KeyF;
+    key_state KeyL;
     key_state KeyLShift;
     key_state KeyLCtrl;
     key_state KeyLAlt;
     key_state KeySpace;
     key_state KeyF1;
     key_state KeyF2;
+    key_state KeyF3;
+    key_state KeyF4;
+    key_state KeyF5;
+    key_state KeyF9;
     key_state KeyF11;
     key_state KeyNumPlus;
     key_state KeyNumMinus;
@@ -186,6 +515,17 @@ struct game_input
 
     mouse_state MouseLeft;
     mouse_state MouseRight;
+
+    // NOTE - Scripted runs (headless, benchmarks) : the camera is put there
+    // instead of following the controls
+    bool CameraOverride;
+    vec3f CameraPosition;
+    vec3f CameraTarget;
+    bool WaterOverride;
+    int32 WaterState;
+    real32 WaterStateInterp;
+    bool DayPhaseOverride;
+    real32 DayPhase;
 };
 
 void *ReadFileContents(memory_arena *Arena, char *Filename, int *FileSize);
@@ -18,9 +18,11 @@
 #if defined(_WIN32) || defined(_WIN64)
 #   define RADAR_WIN32 1
 #   define DLLEXPORT extern "C" __declspec(dllexport)
+#   define THREAD_LOCAL __declspec(thread)
 #elif defined(__unix__) || defined (__unix) || defined(unix)
 #   define RADAR_UNIX 1
 #   define DLLEXPORT extern "C"
+#   define THREAD_LOCAL __thread
 #   include <stddef.h>
 #else
 #   error "Unknown OS. Only Windows & Linux supported for now."
@@ -57,5 +59,92 @@ typedef char path[MAX_PATH];
 #define Megabytes(num) (1024LL*Kilobytes(num))
 #define Gigabytes(num) (1024LL*Megabytes(num))
 
+// NOTE - Atomics. All of them are full barriers (sequentially consistent).
+// Inline so that the Game DLL gets its own copy without any link dependency.
+#if RADAR_WIN32
+#include <intrin.h>
+inline int32 AtomicAdd32(int32 volatile *Value, int32 Addend)
+{
+    return _InterlockedExchangeAdd((long volatile*)Value, Addend) + Addend;
+}
+
+inline int32 AtomicExchange32(int32 volatile *Value, int32 NewValue)
+{
+    return _InterlockedExchange((long volatile*)Value, NewValue);
+}
+
+inline bool AtomicCompareExchange32(int32 volatile *Value, int32 Expected, int32 NewValue)
+{
+    return _InterlockedCompareExchange((long volatile*)Value, NewValue, Expected) == Expected;
+}
+
+inline void FullMemoryBarrier()
+{
+    _ReadWriteBarrier();
+    _mm_mfence();
+}
+
+inline void CPUPause()
+{
+    _mm_pause();
+}
+
+// NOTE - Aligned 32-bit loads are atomic on x86/x64, and MSVC gives volatile
+// reads acquire semantics. The barrier keeps the compiler from hoisting it.
+inline int32 AtomicLoad32(int32 volatile *Value)
+{
+    int32 Result = *Value;
+    _ReadWriteBarrier();
+    return Result;
+}
+#else
+inline int32 AtomicAdd32(int32 volatile *Value, int32 Addend)
+{
+    return __atomic_add_fetch(Value, Addend, __ATOMIC_SEQ_CST);
+}
+
+inline int32 AtomicExchange32(int32 volatile *Value, int32 NewValue)
+{
+    return __atomic_exchange_n(Value, NewValue, __ATOMIC_SEQ_CST);
+}
+
+inline bool AtomicCompareExchange32(int32 volatile *Value, int32 Expected, int32 NewValue)
+{
+    return __atomic_compare_exchange_n(Value, &Expected, NewValue, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+inline void FullMemoryBarrier()
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+inline void CPUPause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+inline int32 AtomicLoad32(int32 volatile *Value)
+{
+    return __atomic_load_n(Value, __ATOMIC_SEQ_CST);
+}
+#endif
+
+
+// NOTE - Only meant for very short critical sections (a few instructions)
+inline void BeginSpinLock(int32 volatile *Lock)
+{
+    while(!AtomicCompareExchange32(Lock, 0, 1))
+    {
+        CPUPause();
+    }
+}
+
+inline void EndSpinLock(int32 volatile *Lock)
+{
+    AtomicExchange32(Lock, 0);
+}
+
 
 #endif
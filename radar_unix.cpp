@@ -5,9 +5,17 @@
 #include <time.h>
 #include <dlfcn.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <poll.h>
+#include <sys/inotify.h>
 
 static path DllName = "sun.so";
-static path DllDynamicCopyName = "sun_temp.so";
+static char const DllDynamicCopyFormat[] = "sun_temp_%u.so";   // A new name per reload
 
 struct game_code
 {
@@ -52,35 +60,79 @@ time_t FindLastWriteTime(path Path)
     return Info.st_mtime;
 }
 
-static void CopyFile(path Src, path Dst)
+// NOTE - No CopyFile on Linux. The copy stays in the kernel : copy_file_range
+// (which can even share the blocks on CoW filesystems), or sendfile where it isn't
+// supported (kernels before 4.5, or across filesystems before 5.3).
+static bool CopyFile(path Src, path Dst)
 {
-    // NOTE - No CopyFile on Linux : open Src, read it and copy it in Dst
-    int SFD = open(Src, O_RDONLY);
-    int DFD = open(Dst, O_WRONLY | O_CREAT | O_TRUNC, S_IRWXU);
-    char FileBuf[Kilobytes(4)];
+    int SFD = open(Src, O_RDONLY | O_CLOEXEC);
+    if(SFD == -1)
+    {
+        return false;
+    }
 
-    // Read until we can't anymore
-    while(1)
+    struct stat Info;
+    int DFD = -1;
+    if(0 == fstat(SFD, &Info))
+    {
+        DFD = open(Dst, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRWXU);
+    }
+    if(DFD == -1)
+    {
+        close(SFD);
+        return false;
+    }
+
+    off_t Remaining = Info.st_size;
+    bool UseSendfile = false;
+    while(Remaining > 0)
     {
-        ssize_t Read = read(SFD, FileBuf, sizeof(FileBuf));
-        if(!Read)
+        ssize_t Copied = -1;
+        if(!UseSendfile)
+        {
+            Copied = copy_file_range(SFD, NULL, DFD, NULL, Remaining, 0);
+            if((Copied == -1 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) || Copied == 0)
+            {
+                // NOTE - Both work from the current file offsets, sendfile picks up where it stopped
+                UseSendfile = true;
+                continue;
+            }
+        }
+        else
+        {
+            Copied = sendfile(DFD, SFD, NULL, Remaining);
+        }
+
+        if(Copied == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if(Copied <= 0)
         {
             break;
         }
-        write(DFD, FileBuf, Read);
+        Remaining -= Copied;
     }
 
     close(SFD);
-    close(DFD);
+    bool Valid = (close(DFD) == 0) && (Remaining == 0);
+    if(!Valid)
+    {
+        printf("Can't copy %s to %s.\n", Src, Dst);
+    }
+    return Valid;
 }
 
 game_code LoadGameCode(path DllSrcPath, path DllDstPath)
 {
     game_code Result = {};
+    Result.GameUpdate = GameUpdateStub;
 
-    CopyFile(DllSrcPath, DllDstPath);
+    if(!CopyFile(DllSrcPath, DllDstPath))
+    {
+        return Result;
+    }
 
-    Result.GameUpdate = GameUpdateStub;
     Result.GameDLL = dlopen(DllDstPath, RTLD_NOW);
 
     if(Result.GameDLL)
@@ -123,6 +175,341 @@ bool CheckNewDllVersion(game_code *Game, path DllPath)
     return false;
 }
 
+// NOTE - Page-aligned, zeroed memory. Needed for the pools so that snapshots
+// can be mapped directly over them.
+void *PlatformAllocateMemory(uint64 Size)
+{
+    void *Memory = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (Memory == MAP_FAILED) ? NULL : Memory;
+}
+
+void PlatformFreeMemory(void *Memory, uint64 Size)
+{
+    if(Memory)
+    {
+        munmap(Memory, Size);
+    }
+}
+
+// NOTE - Writes the Header (padded to SNAPSHOT_DATA_OFFSET) and the Data in one
+// gathered write to a temp file, then renames it over Filename. The rename
+// matters : a previous snapshot of that name might still be mapped in memory.
+bool PlatformWriteSnapshot(char *Filename, void *Header, uint32 HeaderSize, void *Data, uint64 DataSize)
+{
+    Assert(HeaderSize <= SNAPSHOT_DATA_OFFSET);
+
+    path TmpFilename;
+    snprintf(TmpFilename, MAX_PATH, "%s.tmp", Filename);
+
+    int FD = open(TmpFilename, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if(FD == -1)
+    {
+        printf("Snapshot : can't open %s for writing.\n", TmpFilename);
+        return false;
+    }
+
+    uint8 HeaderPage[SNAPSHOT_DATA_OFFSET] = {};
+    memcpy(HeaderPage, Header, HeaderSize);
+
+    struct iovec IOV[2];
+    IOV[0].iov_base = HeaderPage;
+    IOV[0].iov_len = SNAPSHOT_DATA_OFFSET;
+    IOV[1].iov_base = Data;
+    IOV[1].iov_len = DataSize;
+
+    // NOTE - writev is allowed to stop early, even inside the header : finish
+    // with what remains of the header, then of the data
+    uint64 Total = SNAPSHOT_DATA_OFFSET + DataSize;
+    uint64 Written = 0;
+    while(Written < Total)
+    {
+        ssize_t Ret;
+        if(Written == 0)
+        {
+            Ret = writev(FD, IOV, 2);
+        }
+        else if(Written < SNAPSHOT_DATA_OFFSET)
+        {
+            Ret = write(FD, HeaderPage + Written, SNAPSHOT_DATA_OFFSET - Written);
+        }
+        else
+        {
+            uint64 DataOffset = Written - SNAPSHOT_DATA_OFFSET;
+            Ret = write(FD, (uint8*)Data + DataOffset, DataSize - DataOffset);
+        }
+
+        if(Ret == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        if(Ret <= 0)
+        {
+            break;
+        }
+        Written += Ret;
+    }
+    close(FD);
+
+    if(Written != Total || rename(TmpFilename, Filename) != 0)
+    {
+        printf("Snapshot : error writing %s.\n", Filename);
+        unlink(TmpFilename);
+        return false;
+    }
+
+    return true;
+}
+
+// NOTE - Checks that the snapshot header matches ExpectedHeader byte for byte,
+// then maps the Data part of the file copy-on-write over Dst (page-aligned).
+// Pages are brought in lazily by the kernel, no copy is done here. Read in
+// instead when it can't be mapped.
+bool PlatformReadSnapshot(char *Filename, void *ExpectedHeader, uint32 HeaderSize, void *Dst, uint64 DataSize)
+{
+    Assert(HeaderSize <= SNAPSHOT_DATA_OFFSET);
+
+    int FD = open(Filename, O_RDONLY);
+    if(FD == -1)
+    {
+        printf("Snapshot : can't open %s.\n", Filename);
+        return false;
+    }
+
+    uint8 Header[SNAPSHOT_DATA_OFFSET];
+    struct stat Info;
+    uint64 PageSize = (uint64)sysconf(_SC_PAGESIZE);
+    bool Valid = pread(FD, Header, HeaderSize, 0) == (ssize_t)HeaderSize &&
+                 0 == memcmp(Header, ExpectedHeader, HeaderSize) &&
+                 0 == fstat(FD, &Info) &&
+                 (uint64)Info.st_size == SNAPSHOT_DATA_OFFSET + DataSize;
+
+    if(Valid)
+    {
+        bool Mappable = (SNAPSHOT_DATA_OFFSET % PageSize) == 0 && ((uintptr_t)Dst % PageSize) == 0;
+        void *Mapped = Mappable ? mmap(Dst, DataSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, FD, SNAPSHOT_DATA_OFFSET)
+                                : MAP_FAILED;
+        if(Mapped != Dst)
+        {
+            uint64 Read = 0;
+            while(Read < DataSize)
+            {
+                ssize_t Ret = pread(FD, (uint8*)Dst + Read, DataSize - Read, SNAPSHOT_DATA_OFFSET + Read);
+                if(Ret == -1 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(Ret <= 0)
+                {
+                    break;
+                }
+                Read += Ret;
+            }
+
+            Valid = (Read == DataSize);
+            if(!Valid)
+            {
+                printf("Snapshot : couldn't map or read %s.\n", Filename);
+            }
+        }
+    }
+    else
+    {
+        printf("Snapshot : %s is not compatible with this build.\n", Filename);
+    }
+
+    close(FD);
+    return Valid;
+}
+
+typedef void platform_thread_function(void *Param);
+
+struct platform_thread
+{
+    pthread_t Handle;
+    platform_thread_function *Function;
+    void *Param;
+};
+
+static void *_PlatformThreadProc(void *Param)
+{
+    platform_thread *Thread = (platform_thread*)Param;
+    Thread->Function(Thread->Param);
+    return NULL;
+}
+
+// NOTE - Thread must stay valid until it's joined
+bool PlatformCreateThread(platform_thread *Thread, platform_thread_function *Function, void *Param)
+{
+    Thread->Function = Function;
+    Thread->Param = Param;
+    return 0 == pthread_create(&Thread->Handle, NULL, _PlatformThreadProc, Thread);
+}
+
+void PlatformJoinThread(platform_thread *Thread)
+{
+    pthread_join(Thread->Handle, NULL);
+}
+
+struct platform_semaphore
+{
+    sem_t Handle;
+};
+
+bool PlatformCreateSemaphore(platform_semaphore *Semaphore, uint32 InitialCount)
+{
+    return 0 == sem_init(&Semaphore->Handle, 0, InitialCount);
+}
+
+void PlatformDestroySemaphore(platform_semaphore *Semaphore)
+{
+    sem_destroy(&Semaphore->Handle);
+}
+
+void PlatformSignalSemaphore(platform_semaphore *Semaphore, uint32 Count)
+{
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        sem_post(&Semaphore->Handle);
+    }
+}
+
+void PlatformWaitSemaphore(platform_semaphore *Semaphore)
+{
+    // NOTE - Retry when interrupted by a signal
+    while(sem_wait(&Semaphore->Handle) == -1 && errno == EINTR) {}
+}
+
+struct platform_file_watcher
+{
+    int INotifyFD;
+    int WakePipe[2];        // Written to when stopping, to get out of poll()
+    int Watches[WATCH_MAX_DIRECTORIES];
+    uint32 DirectoryCount;
+
+    platform_thread Thread;
+    file_change_queue Queue;
+    bool IsValid;
+};
+
+static void _FileWatcherThread(void *Param)
+{
+    platform_file_watcher *Watcher = (platform_file_watcher*)Param;
+
+    char Buffer[Kilobytes(4)] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd FDs[2] = {};
+    FDs[0].fd = Watcher->INotifyFD;
+    FDs[0].events = POLLIN;
+    FDs[1].fd = Watcher->WakePipe[0];
+    FDs[1].events = POLLIN;
+
+    while(1)
+    {
+        if(poll(FDs, 2, -1) == -1)
+        {
+            if(errno == EINTR) continue;
+            break;
+        }
+
+        if(FDs[1].revents)
+        {
+            break;
+        }
+
+        ssize_t Length = read(Watcher->INotifyFD, Buffer, sizeof(Buffer));
+        if(Length <= 0)
+        {
+            if(Length == -1 && (errno == EINTR || errno == EAGAIN)) continue;
+            break;
+        }
+
+        for(char *Ptr = Buffer; Ptr < Buffer + Length; )
+        {
+            struct inotify_event *Event = (struct inotify_event*)Ptr;
+            if(Event->mask & IN_Q_OVERFLOW)
+            {
+                AtomicExchange32(&Watcher->Queue.Overflow, 1);
+            }
+            else if(Event->len)
+            {
+                for(uint32 i = 0; i < Watcher->DirectoryCount; ++i)
+                {
+                    if(Watcher->Watches[i] == Event->wd)
+                    {
+                        PushFileChange(&Watcher->Queue, i, Event->name);
+                        break;
+                    }
+                }
+            }
+            Ptr += sizeof(struct inotify_event) + Event->len;
+        }
+    }
+}
+
+// NOTE - Only files closed after writing, or moved in (editors saving through a
+// temp file) are reported : by then they are complete.
+bool PlatformStartFileWatcher(platform_file_watcher *Watcher, char const **Directories, uint32 DirectoryCount)
+{
+    Assert(DirectoryCount <= WATCH_MAX_DIRECTORIES);
+    memset(Watcher, 0, sizeof(platform_file_watcher));
+
+    Watcher->INotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(Watcher->INotifyFD == -1)
+    {
+        printf("File Watcher : inotify unavailable.\n");
+        return false;
+    }
+
+    for(uint32 i = 0; i < DirectoryCount; ++i)
+    {
+        Watcher->Watches[i] = inotify_add_watch(Watcher->INotifyFD, Directories[i], IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(Watcher->Watches[i] == -1)
+        {
+            printf("File Watcher : can't watch %s.\n", Directories[i]);
+        }
+    }
+    Watcher->DirectoryCount = DirectoryCount;
+
+    if(pipe(Watcher->WakePipe) == -1)
+    {
+        close(Watcher->INotifyFD);
+        return false;
+    }
+
+    if(!PlatformCreateThread(&Watcher->Thread, _FileWatcherThread, Watcher))
+    {
+        close(Watcher->WakePipe[0]);
+        close(Watcher->WakePipe[1]);
+        close(Watcher->INotifyFD);
+        return false;
+    }
+
+    Watcher->IsValid = true;
+    return true;
+}
+
+void PlatformStopFileWatcher(platform_file_watcher *Watcher)
+{
+    if(!Watcher->IsValid)
+    {
+        return;
+    }
+
+    char Wake = 1;
+    while(write(Watcher->WakePipe[1], &Wake, 1) == -1 && errno == EINTR) {}
+    PlatformJoinThread(&Watcher->Thread);
+
+    close(Watcher->WakePipe[0]);
+    close(Watcher->WakePipe[1]);
+    close(Watcher->INotifyFD);
+    Watcher->IsValid = false;
+}
+
+uint32 PlatformGetProcessorCount()
+{
+    long Count = sysconf(_SC_NPROCESSORS_ONLN);
+    return Count > 0 ? (uint32)Count : 1;
+}
+
 void PlatformSleep(uint32 MillisecondsToSleep)
 {
     struct timespec TS;
@@ -131,6 +518,30 @@ void PlatformSleep(uint32 MillisecondsToSleep)
     nanosleep(&TS, NULL);
 }
 
+// NOTE - Monotonic, in seconds
+real64 PlatformGetWallClock()
+{
+    struct timespec TS;
+    clock_gettime(CLOCK_MONOTONIC, &TS);
+    return (real64)TS.tv_sec + (real64)TS.tv_nsec * 1e-9;
+}
+
+// NOTE - Sleeps until an absolute PlatformGetWallClock time. Absolute, so that
+// time lost to wake-up latency or signals doesn't accumulate.
+void PlatformSleepUntil(real64 WallClock)
+{
+    struct timespec TS;
+    TS.tv_sec = (time_t)WallClock;
+    TS.tv_nsec = (long)((WallClock - (real64)TS.tv_sec) * 1e9);
+    while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &TS, NULL) == EINTR) {}
+}
+
+// NOTE - Succeeds if the directory already exists
+bool PlatformMakeDirectory(char const *Path)
+{
+    return 0 == mkdir(Path, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) || errno == EEXIST;
+}
+
 int main(int argc, char **argv)
 {
     return RadarMain(argc, argv);
@@ -1,7 +1,8 @@
 #include <windows.h>
+#include <mmsystem.h>
 
 static path DllName = "sun.dll";
-static path DllDynamicCopyName = "sun_temp.dll";
+static char const DllDynamicCopyFormat[] = "sun_temp_%u.dll";  // A new name per reload
 
 struct game_code
 {
@@ -44,10 +45,14 @@ FILETIME FindLastWriteTime(path Path)
 game_code LoadGameCode(path DllSrcPath, path DllDstPath)
 {
     game_code Result = {};
+    Result.GameUpdate = GameUpdateStub;
 
-    CopyFileA(DllSrcPath, DllDstPath, FALSE);
+    if(!CopyFileA(DllSrcPath, DllDstPath, FALSE))
+    {
+        printf("Can't copy %s to %s.\n", DllSrcPath, DllDstPath);
+        return Result;
+    }
 
-    Result.GameUpdate = GameUpdateStub;
     Result.GameDLL = LoadLibraryA(DllDstPath);
 
     if(Result.GameDLL)
@@ -88,11 +93,363 @@ bool CheckNewDllVersion(game_code *Game, path DllPath)
     return false;
 }
 
+// NOTE - Page-aligned, zeroed memory
+void *PlatformAllocateMemory(uint64 Size)
+{
+    return VirtualAlloc(NULL, Size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void PlatformFreeMemory(void *Memory, uint64 Size)
+{
+    if(Memory)
+    {
+        VirtualFree(Memory, 0, MEM_RELEASE);
+    }
+}
+
+// NOTE - Header padded to SNAPSHOT_DATA_OFFSET, then the Data. Written to a temp
+// file first and moved over Filename so a failed save never breaks the old one.
+// NOTE - ReadFile/WriteFile take a DWORD size, pools can be 4GB or more
+#define SNAPSHOT_IO_CHUNK (1u << 30)
+
+static bool WriteFileAll(HANDLE File, void const *Data, uint64 Size)
+{
+    for(uint64 Offset = 0; Offset < Size;)
+    {
+        DWORD ChunkSize = (DWORD)Min(Size - Offset, (uint64)SNAPSHOT_IO_CHUNK);
+        DWORD Written;
+        if(!WriteFile(File, (uint8 const*)Data + Offset, ChunkSize, &Written, NULL) || Written != ChunkSize)
+        {
+            return false;
+        }
+        Offset += Written;
+    }
+    return true;
+}
+
+static bool ReadFileAll(HANDLE File, void *Dst, uint64 Size)
+{
+    for(uint64 Offset = 0; Offset < Size;)
+    {
+        DWORD ChunkSize = (DWORD)Min(Size - Offset, (uint64)SNAPSHOT_IO_CHUNK);
+        DWORD Read;
+        if(!ReadFile(File, (uint8*)Dst + Offset, ChunkSize, &Read, NULL) || Read != ChunkSize)
+        {
+            return false;
+        }
+        Offset += Read;
+    }
+    return true;
+}
+
+bool PlatformWriteSnapshot(char *Filename, void *Header, uint32 HeaderSize, void *Data, uint64 DataSize)
+{
+    Assert(HeaderSize <= SNAPSHOT_DATA_OFFSET);
+
+    path TmpFilename;
+    snprintf(TmpFilename, MAX_PATH, "%s.tmp", Filename);
+
+    HANDLE File = CreateFileA(TmpFilename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(File == INVALID_HANDLE_VALUE)
+    {
+        printf("Snapshot : can't open %s for writing.\n", TmpFilename);
+        return false;
+    }
+
+    uint8 HeaderPage[SNAPSHOT_DATA_OFFSET] = {};
+    memcpy(HeaderPage, Header, HeaderSize);
+
+    bool Valid = WriteFileAll(File, HeaderPage, SNAPSHOT_DATA_OFFSET) && WriteFileAll(File, Data, DataSize);
+    CloseHandle(File);
+
+    if(!Valid || !MoveFileExA(TmpFilename, Filename, MOVEFILE_REPLACE_EXISTING))
+    {
+        printf("Snapshot : error writing %s.\n", Filename);
+        DeleteFileA(TmpFilename);
+        return false;
+    }
+
+    return true;
+}
+
+// NOTE - Checks that the snapshot header matches ExpectedHeader byte for byte,
+// then reads the Data part straight into Dst in a single ReadFile.
+bool PlatformReadSnapshot(char *Filename, void *ExpectedHeader, uint32 HeaderSize, void *Dst, uint64 DataSize)
+{
+    Assert(HeaderSize <= SNAPSHOT_DATA_OFFSET);
+
+    HANDLE File = CreateFileA(Filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(File == INVALID_HANDLE_VALUE)
+    {
+        printf("Snapshot : can't open %s.\n", Filename);
+        return false;
+    }
+
+    uint8 Header[SNAPSHOT_DATA_OFFSET];
+    LARGE_INTEGER FileSize;
+    DWORD Read;
+    bool Valid = ReadFile(File, Header, HeaderSize, &Read, NULL) && Read == HeaderSize &&
+                 0 == memcmp(Header, ExpectedHeader, HeaderSize) &&
+                 GetFileSizeEx(File, &FileSize) &&
+                 (uint64)FileSize.QuadPart == SNAPSHOT_DATA_OFFSET + DataSize;
+
+    if(Valid)
+    {
+        SetFilePointer(File, SNAPSHOT_DATA_OFFSET, NULL, FILE_BEGIN);
+        Valid = ReadFileAll(File, Dst, DataSize);
+    }
+    else
+    {
+        printf("Snapshot : %s is not compatible with this build.\n", Filename);
+    }
+
+    CloseHandle(File);
+    return Valid;
+}
+
+typedef void platform_thread_function(void *Param);
+
+struct platform_thread
+{
+    HANDLE Handle;
+    platform_thread_function *Function;
+    void *Param;
+};
+
+static DWORD WINAPI _PlatformThreadProc(LPVOID Param)
+{
+    platform_thread *Thread = (platform_thread*)Param;
+    Thread->Function(Thread->Param);
+    return 0;
+}
+
+// NOTE - Thread must stay valid until it's joined
+bool PlatformCreateThread(platform_thread *Thread, platform_thread_function *Function, void *Param)
+{
+    Thread->Function = Function;
+    Thread->Param = Param;
+    Thread->Handle = CreateThread(NULL, 0, _PlatformThreadProc, Thread, 0, NULL);
+    return Thread->Handle != NULL;
+}
+
+void PlatformJoinThread(platform_thread *Thread)
+{
+    WaitForSingleObject(Thread->Handle, INFINITE);
+    CloseHandle(Thread->Handle);
+}
+
+struct platform_semaphore
+{
+    HANDLE Handle;
+};
+
+bool PlatformCreateSemaphore(platform_semaphore *Semaphore, uint32 InitialCount)
+{
+    Semaphore->Handle = CreateSemaphoreA(NULL, InitialCount, LONG_MAX, NULL);
+    return Semaphore->Handle != NULL;
+}
+
+void PlatformDestroySemaphore(platform_semaphore *Semaphore)
+{
+    CloseHandle(Semaphore->Handle);
+}
+
+void PlatformSignalSemaphore(platform_semaphore *Semaphore, uint32 Count)
+{
+    ReleaseSemaphore(Semaphore->Handle, Count, NULL);
+}
+
+void PlatformWaitSemaphore(platform_semaphore *Semaphore)
+{
+    WaitForSingleObject(Semaphore->Handle, INFINITE);
+}
+
+struct platform_file_watcher
+{
+    HANDLE Directories[WATCH_MAX_DIRECTORIES];
+    OVERLAPPED Overlapped[WATCH_MAX_DIRECTORIES];
+    HANDLE Events[WATCH_MAX_DIRECTORIES + 1];   // One per directory, then the stop event
+    DWORD Buffers[WATCH_MAX_DIRECTORIES][1024]; // DWORD-aligned, as the notifications need
+    uint32 DirectoryCount;
+
+    platform_thread Thread;
+    file_change_queue Queue;
+    bool IsValid;
+};
+
+static bool _FileWatcherIssueRead(platform_file_watcher *Watcher, uint32 Index)
+{
+    return ReadDirectoryChangesW(Watcher->Directories[Index], Watcher->Buffers[Index], sizeof(Watcher->Buffers[Index]),
+                                 FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME,
+                                 NULL, &Watcher->Overlapped[Index], NULL) != 0;
+}
+
+static void _FileWatcherThread(void *Param)
+{
+    platform_file_watcher *Watcher = (platform_file_watcher*)Param;
+    DWORD StopIndex = Watcher->DirectoryCount;
+
+    while(1)
+    {
+        DWORD Wait = WaitForMultipleObjects(Watcher->DirectoryCount + 1, Watcher->Events, FALSE, INFINITE);
+        if(Wait >= WAIT_OBJECT_0 + StopIndex)
+        {
+            break;
+        }
+
+        uint32 Index = Wait - WAIT_OBJECT_0;
+        DWORD Length = 0;
+        if(!GetOverlappedResult(Watcher->Directories[Index], &Watcher->Overlapped[Index], &Length, FALSE) || !Length)
+        {
+            // NOTE - Buffer overflow, the changes are lost
+            AtomicExchange32(&Watcher->Queue.Overflow, 1);
+        }
+        else
+        {
+            uint8 *Ptr = (uint8*)Watcher->Buffers[Index];
+            while(1)
+            {
+                FILE_NOTIFY_INFORMATION *Info = (FILE_NOTIFY_INFORMATION*)Ptr;
+                if(Info->Action == FILE_ACTION_MODIFIED || Info->Action == FILE_ACTION_ADDED ||
+                   Info->Action == FILE_ACTION_RENAMED_NEW_NAME)
+                {
+                    char Name[WATCH_NAME_LENGTH];
+                    int NameLength = WideCharToMultiByte(CP_UTF8, 0, Info->FileName, Info->FileNameLength / sizeof(WCHAR),
+                                                         Name, WATCH_NAME_LENGTH - 1, NULL, NULL);
+                    if(NameLength > 0)
+                    {
+                        Name[NameLength] = 0;
+                        PushFileChange(&Watcher->Queue, Index, Name);
+                    }
+                }
+
+                if(!Info->NextEntryOffset) break;
+                Ptr += Info->NextEntryOffset;
+            }
+        }
+
+        if(!_FileWatcherIssueRead(Watcher, Index))
+        {
+            break;
+        }
+    }
+}
+
+// NOTE - Windows reports every write, a saved file can come in several times
+bool PlatformStartFileWatcher(platform_file_watcher *Watcher, char const **Directories, uint32 DirectoryCount)
+{
+    Assert(DirectoryCount <= WATCH_MAX_DIRECTORIES);
+    memset(Watcher, 0, sizeof(platform_file_watcher));
+
+    bool Valid = true;
+    for(uint32 i = 0; i < DirectoryCount && Valid; ++i)
+    {
+        Watcher->Directories[i] = CreateFileA(Directories[i], FILE_LIST_DIRECTORY,
+                                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                              OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+        Watcher->Events[i] = CreateEventA(NULL, FALSE, FALSE, NULL);
+        Watcher->Overlapped[i].hEvent = Watcher->Events[i];
+        Watcher->DirectoryCount = i + 1;
+
+        Valid = Watcher->Directories[i] != INVALID_HANDLE_VALUE && Watcher->Events[i] &&
+                _FileWatcherIssueRead(Watcher, i);
+        if(!Valid)
+        {
+            printf("File Watcher : can't watch %s.\n", Directories[i]);
+        }
+    }
+
+    Watcher->Events[Watcher->DirectoryCount] = CreateEventA(NULL, TRUE, FALSE, NULL);
+    Valid = Valid && Watcher->Events[Watcher->DirectoryCount] &&
+            PlatformCreateThread(&Watcher->Thread, _FileWatcherThread, Watcher);
+
+    if(!Valid)
+    {
+        for(uint32 i = 0; i <= Watcher->DirectoryCount; ++i)
+        {
+            if(i < Watcher->DirectoryCount && Watcher->Directories[i] != INVALID_HANDLE_VALUE)
+            {
+                CancelIoEx(Watcher->Directories[i], NULL);
+                CloseHandle(Watcher->Directories[i]);
+            }
+            if(Watcher->Events[i]) CloseHandle(Watcher->Events[i]);
+        }
+        return false;
+    }
+
+    Watcher->IsValid = true;
+    return true;
+}
+
+void PlatformStopFileWatcher(platform_file_watcher *Watcher)
+{
+    if(!Watcher->IsValid)
+    {
+        return;
+    }
+
+    SetEvent(Watcher->Events[Watcher->DirectoryCount]);
+    PlatformJoinThread(&Watcher->Thread);
+
+    // NOTE - The reads were issued from both threads, CancelIoEx cancels all of them
+    for(uint32 i = 0; i < Watcher->DirectoryCount; ++i)
+    {
+        CancelIoEx(Watcher->Directories[i], NULL);
+        CloseHandle(Watcher->Directories[i]);
+        CloseHandle(Watcher->Events[i]);
+    }
+    CloseHandle(Watcher->Events[Watcher->DirectoryCount]);
+    Watcher->IsValid = false;
+}
+
+uint32 PlatformGetProcessorCount()
+{
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+    return Info.dwNumberOfProcessors;
+}
+
 void PlatformSleep(DWORD MillisecondsToSleep)
 {
     Sleep(MillisecondsToSleep);
 }
 
+// NOTE - Monotonic, in seconds
+real64 PlatformGetWallClock()
+{
+    static LARGE_INTEGER Frequency = {};
+    if(!Frequency.QuadPart)
+    {
+        QueryPerformanceFrequency(&Frequency);
+    }
+
+    LARGE_INTEGER Counter;
+    QueryPerformanceCounter(&Counter);
+    return (real64)Counter.QuadPart / (real64)Frequency.QuadPart;
+}
+
+// NOTE - No absolute sleep on Windows : sleep the whole milliseconds left.
+// The scheduler period is set to 1ms the first time, default is ~15.6ms.
+void PlatformSleepUntil(real64 WallClock)
+{
+    static bool SchedulerGranular = false;
+    if(!SchedulerGranular)
+    {
+        SchedulerGranular = (timeBeginPeriod(1) == TIMERR_NOERROR);
+    }
+
+    real64 Remaining = WallClock - PlatformGetWallClock();
+    if(Remaining >= 0.001)
+    {
+        Sleep((DWORD)(Remaining * 1000.0));
+    }
+}
+
+// NOTE - Succeeds if the directory already exists
+bool PlatformMakeDirectory(char const *Path)
+{
+    return CreateDirectoryA(Path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
 
 // NOTE - We just call the platform-agnostic main function here
 int main()
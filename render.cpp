@@ -26,6 +26,159 @@ void CheckGLError(const char *Mark = "")
     }
 }
 
+static gl_state_cache GLState;
+
+// NOTE - Forget everything : to call once the context is up, and whenever
+// something may have changed the state behind the cache's back
+void InvalidateGLState()
+{
+    uint32 Calls = GLState.Calls, Filtered = GLState.Filtered;
+    uint32 LastCalls = GLState.LastCalls, LastFiltered = GLState.LastFiltered;
+    memset(&GLState, 0xFF, sizeof(GLState));
+    GLState.Calls = Calls;
+    GLState.Filtered = Filtered;
+    GLState.LastCalls = LastCalls;
+    GLState.LastFiltered = LastFiltered;
+}
+
+void GLStateNewFrame()
+{
+    GLState.LastCalls = GLState.Calls;
+    GLState.LastFiltered = GLState.Filtered;
+    GLState.Calls = 0;
+    GLState.Filtered = 0;
+}
+
+// NOTE - Returns true if the call has to go to GL
+inline bool _GLStateChange(uint32 *Cached, uint32 Value)
+{
+    ++GLState.Calls;
+    if(*Cached == Value)
+    {
+        ++GLState.Filtered;
+        return false;
+    }
+    *Cached = Value;
+    return true;
+}
+
+void GLUseProgram(uint32 Program)
+{
+    if(_GLStateChange(&GLState.Program, Program)) glUseProgram(Program);
+}
+
+void GLBindVertexArray(uint32 VAO)
+{
+    if(_GLStateChange(&GLState.VAO, VAO)) glBindVertexArray(VAO);
+}
+
+void GLBindFramebuffer(uint32 FBO)
+{
+    if(_GLStateChange(&GLState.Framebuffer, FBO)) glBindFramebuffer(GL_FRAMEBUFFER, FBO);
+}
+
+void GLActiveTexture(uint32 Unit)
+{
+    if(_GLStateChange(&GLState.ActiveUnit, Unit)) glActiveTexture(GL_TEXTURE0 + Unit);
+}
+
+// NOTE - Only 2D and cubemap bindings are tracked, other targets always go through
+void GLBindTexture(uint32 Unit, uint32 Target, uint32 Texture)
+{
+    uint32 *Cached = NULL;
+    if(Unit < GL_STATE_TEXTURE_UNITS)
+    {
+        if(Target == GL_TEXTURE_2D) Cached = &GLState.Texture2D[Unit];
+        if(Target == GL_TEXTURE_CUBE_MAP) Cached = &GLState.TextureCube[Unit];
+    }
+
+    if(!Cached || _GLStateChange(Cached, Texture))
+    {
+        GLActiveTexture(Unit);
+        glBindTexture(Target, Texture);
+    }
+}
+
+static uint32 *_GLStateCap(uint32 Cap)
+{
+    switch(Cap)
+    {
+        case GL_BLEND: return &GLState.Caps[GL_STATE_CAP_BLEND];
+        case GL_DEPTH_TEST: return &GLState.Caps[GL_STATE_CAP_DEPTH_TEST];
+        case GL_CULL_FACE: return &GLState.Caps[GL_STATE_CAP_CULL_FACE];
+        default: return NULL;
+    }
+}
+
+void GLEnable(uint32 Cap)
+{
+    uint32 *Cached = _GLStateCap(Cap);
+    if(!Cached || _GLStateChange(Cached, 1)) glEnable(Cap);
+}
+
+void GLDisable(uint32 Cap)
+{
+    uint32 *Cached = _GLStateCap(Cap);
+    if(!Cached || _GLStateChange(Cached, 0)) glDisable(Cap);
+}
+
+void GLDepthFunc(uint32 Func)
+{
+    if(_GLStateChange(&GLState.DepthFunc, Func)) glDepthFunc(Func);
+}
+
+void GLBlendFunc(uint32 Src, uint32 Dst)
+{
+    ++GLState.Calls;
+    if(GLState.BlendSrc == Src && GLState.BlendDst == Dst)
+    {
+        ++GLState.Filtered;
+        return;
+    }
+    GLState.BlendSrc = Src;
+    GLState.BlendDst = Dst;
+    glBlendFunc(Src, Dst);
+}
+
+// NOTE - Deleting a bound texture, VAO or framebuffer rebinds 0. A deleted program
+// stays in use until the next glUseProgram, and its name can come back.
+void GLDeleteProgram(uint32 Program)
+{
+    if(GLState.Program == Program) GLState.Program = GL_STATE_UNKNOWN;
+    glDeleteProgram(Program);
+}
+
+void GLDeleteTextures(uint32 Count, uint32 *Textures)
+{
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        for(uint32 Unit = 0; Unit < GL_STATE_TEXTURE_UNITS; ++Unit)
+        {
+            if(GLState.Texture2D[Unit] == Textures[i]) GLState.Texture2D[Unit] = 0;
+            if(GLState.TextureCube[Unit] == Textures[i]) GLState.TextureCube[Unit] = 0;
+        }
+    }
+    glDeleteTextures(Count, Textures);
+}
+
+void GLDeleteVertexArrays(uint32 Count, uint32 *VAOs)
+{
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        if(GLState.VAO == VAOs[i]) GLState.VAO = 0;
+    }
+    glDeleteVertexArrays(Count, VAOs);
+}
+
+void GLDeleteFramebuffers(uint32 Count, uint32 *FBOs)
+{
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        if(GLState.Framebuffer == FBOs[i]) GLState.Framebuffer = 0;
+    }
+    glDeleteFramebuffers(Count, FBOs);
+}
+
 image LoadImage(char *Filename, bool IsFloat, bool FlipY = true, int32 ForceNumChannel = 0)
 {
     image Image = {};
@@ -107,7 +260,7 @@ uint32 Make2DTexture(void *ImageBuffer, uint32 Width, uint32 Height, uint32 Chan
 {
     uint32 Texture;
     glGenTextures(1, &Texture);
-    glBindTexture(GL_TEXTURE_2D, Texture);
+    GLBindTexture(0, GL_TEXTURE_2D, Texture);
 
     GLint CurrentAlignment;
     glGetIntegerv(GL_UNPACK_ALIGNMENT, &CurrentAlignment);
@@ -132,7 +285,7 @@ uint32 Make2DTexture(void *ImageBuffer, uint32 Width, uint32 Height, uint32 Chan
 
     glPixelStorei(GL_UNPACK_ALIGNMENT, CurrentAlignment);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLBindTexture(0, GL_TEXTURE_2D, 0);
 
     return Texture;
 }
@@ -147,7 +300,7 @@ uint32 MakeCubemap(path *Paths, bool IsFloat, bool FloatHalfPrecision, uint32 Wi
     uint32 Cubemap = 0;
 
     glGenTextures(1, &Cubemap);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, Cubemap);
+    GLBindTexture(0, GL_TEXTURE_CUBE_MAP, Cubemap);
     CheckGLError("SkyboxGen");
     
     for(int i = 0; i < 6; ++i)
@@ -179,7 +332,7 @@ uint32 MakeCubemap(path *Paths, bool IsFloat, bool FloatHalfPrecision, uint32 Wi
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GLBindTexture(0, GL_TEXTURE_CUBE_MAP, 0);
     CheckGLError("SkyboxParams");
 
     return Cubemap;
@@ -203,13 +356,13 @@ struct frame_buffer
 
 void DestroyFramebuffer(frame_buffer *FB)
 {
-    glDeleteTextures(MAX_FBO_ATTACHMENTS, FB->BufferIDs);
+    GLDeleteTextures(MAX_FBO_ATTACHMENTS, FB->BufferIDs);
     glDeleteRenderbuffers(1, &FB->DepthBufferID);
-    glDeleteFramebuffers(1, &FB->FBO);
+    GLDeleteFramebuffers(1, &FB->FBO);
     FB->Size = vec2i(0);
     FB->FBO = 0;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLBindFramebuffer(0);
 }
 
 frame_buffer MakeFramebuffer(uint32 NumAttachments, vec2i Size)
@@ -218,7 +371,7 @@ frame_buffer MakeFramebuffer(uint32 NumAttachments, vec2i Size)
 
     frame_buffer FB = {};
     glGenFramebuffers(1, &FB.FBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, FB.FBO);
+    GLBindFramebuffer(FB.FBO);
     glDrawBuffers((GLsizei) NumAttachments, FBOAttachments);
 
     // NOTE - Always attach a depth buffer : is there an instance where you dont want that ?
@@ -236,7 +389,7 @@ frame_buffer MakeFramebuffer(uint32 NumAttachments, vec2i Size)
     FB.Size = Size;
     FB.NumAttachments = NumAttachments;
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLBindFramebuffer(0);
 
     return FB;
 }
@@ -245,11 +398,11 @@ void AttachBuffer(frame_buffer *FBO, uint32 Attachment, uint32 Channels, bool Is
 {
     Assert(Attachment < MAX_FBO_ATTACHMENTS);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, FBO->FBO);
+    GLBindFramebuffer(FBO->FBO);
 
     uint32 *BufferID = &FBO->BufferIDs[Attachment];
     glGenTextures(1, BufferID);
-    glBindTexture(GL_TEXTURE_2D, *BufferID);
+    GLBindTexture(0, GL_TEXTURE_2D, *BufferID);
 
     GLint BaseFormat, Format;
     FormatFromChannels(Channels, IsFloat, FloatHalfPrecision, &BaseFormat, &Format);
@@ -267,7 +420,7 @@ void AttachBuffer(frame_buffer *FBO, uint32 Attachment, uint32 Channels, bool Is
         printf("Framebuffer creation error : Attachment %u error.\n", Attachment);
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GLBindFramebuffer(0);
 }
 
 // TODO - Load Unicode characters
@@ -373,6 +526,68 @@ uint32 _CompileShader(game_memory *Memory, char *Src, int Type)
     return Shader;
 }
 
+static char const *UniformBlockNames[UNIFORM_BLOCK_COUNT] = { "FrameBlock", "ViewBlock", "MaterialBlock" };
+static uint32 UniformBuffers[UNIFORM_BLOCK_COUNT];
+
+void InitUniformBuffers()
+{
+    uint32 const Sizes[UNIFORM_BLOCK_COUNT] = {
+        sizeof(frame_uniforms), sizeof(view_uniforms), UNIFORM_MAX_MATERIALS * sizeof(material_uniforms)
+    };
+
+    glGenBuffers(UNIFORM_BLOCK_COUNT, UniformBuffers);
+    for(uint32 i = 0; i < UNIFORM_BLOCK_COUNT; ++i)
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, UniformBuffers[i]);
+        glBufferData(GL_UNIFORM_BUFFER, Sizes[i], NULL, GL_STREAM_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, i, UniformBuffers[i]);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void DestroyUniformBuffers()
+{
+    glDeleteBuffers(UNIFORM_BLOCK_COUNT, UniformBuffers);
+}
+
+// NOTE - Whole-buffer uploads : glBufferData orphans the previous storage, so
+// the driver never waits for draws still reading it
+static void _UploadUniformBuffer(uint32 Block, void const *Data, uint32 Size)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, UniformBuffers[Block]);
+    glBufferData(GL_UNIFORM_BUFFER, Size, Data, GL_STREAM_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UploadFrameUniforms(frame_uniforms const *Frame)
+{
+    _UploadUniformBuffer(UNIFORM_BLOCK_FRAME, Frame, sizeof(frame_uniforms));
+}
+
+void UploadViewUniforms(view_uniforms const *View)
+{
+    _UploadUniformBuffer(UNIFORM_BLOCK_VIEW, View, sizeof(view_uniforms));
+}
+
+// NOTE - Always the whole UNIFORM_MAX_MATERIALS array, the block has that size
+void UploadMaterialUniforms(material_uniforms const *Materials)
+{
+    _UploadUniformBuffer(UNIFORM_BLOCK_MATERIAL, Materials, UNIFORM_MAX_MATERIALS * sizeof(material_uniforms));
+}
+
+// NOTE - Before GLSL 4.20 blocks can't pick their binding in the source
+static void BindUniformBlocks(uint32 ProgramID)
+{
+    for(uint32 i = 0; i < UNIFORM_BLOCK_COUNT; ++i)
+    {
+        uint32 BlockIndex = glGetUniformBlockIndex(ProgramID, UniformBlockNames[i]);
+        if(BlockIndex != GL_INVALID_INDEX)
+        {
+            glUniformBlockBinding(ProgramID, BlockIndex, i);
+        }
+    }
+}
+
 uint32 BuildShader(game_memory *Memory, char *VSPath, char *FSPath)
 {
     char *VSrc = NULL, *FSrc = NULL;
@@ -391,7 +606,7 @@ uint32 BuildShader(game_memory *Memory, char *VSPath, char *FSPath)
         if(!VShader)
         {
             printf("Failed to build %s Vertex Shader.\n", VSPath);
-            glDeleteProgram(ProgramID);
+            GLDeleteProgram(ProgramID);
             return 0;
         }
         uint32 FShader = _CompileShader(Memory, FSrc, GL_FRAGMENT_SHADER);
@@ -399,7 +614,7 @@ uint32 BuildShader(game_memory *Memory, char *VSPath, char *FSPath)
         {
             printf("Failed to build %s Vertex Shader.\n", VSPath);
             glDeleteShader(VShader);
-            glDeleteProgram(ProgramID);
+            GLDeleteProgram(ProgramID);
             return 0;
         }
 
@@ -427,14 +642,82 @@ uint32 BuildShader(game_memory *Memory, char *VSPath, char *FSPath)
                     "%s"
                     "-----------------------------------------------------", Log);
 
-            glDeleteProgram(ProgramID);
+            GLDeleteProgram(ProgramID);
             return 0;
         }
+
+        BindUniformBlocks(ProgramID);
     }
 
     return ProgramID;
 }
 
+static string_table UniformNames;
+static char const *BuiltinUniformNames[UNIFORM_BUILTIN_COUNT] = {
+    "", "ModelMatrix", "Color"
+};
+
+void InitUniformNames(memory_arena *Arena)
+{
+    InitStringTable(&UniformNames, Arena, 64);
+    for(uint32 i = 1; i < UNIFORM_BUILTIN_COUNT; ++i)
+    {
+        uint32 ID = Intern(&UniformNames, BuiltinUniformNames[i]);
+        Assert(ID == i);
+    }
+}
+
+uint32 UniformName(char const *Name)
+{
+    return Intern(&UniformNames, Name);
+}
+
+// NOTE - Fills the uniform table of a freshly linked program, reusing its storage
+// when it was already reflected. Arrays are stored under their name without the
+// [0] : the location of element i is that one + i.
+void ReflectShaderUniforms(shader_program *Shader, memory_arena *Arena)
+{
+    if(Shader->Uniforms.Slots)
+    {
+        MapClear(&Shader->Uniforms);
+    }
+    else
+    {
+        InitMap(&Shader->Uniforms, Arena, 32);
+    }
+
+    GLint Count = 0;
+    glGetProgramiv(Shader->ID, GL_ACTIVE_UNIFORMS, &Count);
+    for(GLint i = 0; i < Count; ++i)
+    {
+        char Name[128];
+        GLint Size;
+        GLenum Type;
+        glGetActiveUniform(Shader->ID, (GLuint)i, sizeof(Name), NULL, &Size, &Type, Name);
+
+        // NOTE - -1 for the members of uniform blocks, they have no location
+        int32 Location = glGetUniformLocation(Shader->ID, Name);
+        if(Location < 0)
+        {
+            continue;
+        }
+
+        char *Bracket = strchr(Name, '[');
+        if(Bracket)
+        {
+            *Bracket = 0;
+        }
+        MapInsert(&Shader->Uniforms, UniformName(Name), Location);
+    }
+}
+
+// NOTE - -1 if the program has no such active uniform, glUniform* ignores it
+inline int32 GetUniform(shader_program *Shader, uint32 Name)
+{
+    int32 *Location = Shader->Uniforms.Slots ? MapFind(&Shader->Uniforms, Name) : NULL;
+    return Location ? *Location : -1;
+}
+
 void SendVec2(uint32 Loc, vec2f value)
 {
     glUniform2fv(Loc, 1, (GLfloat const *) value);
@@ -470,7 +753,7 @@ uint32 MakeVertexArrayObject()
 {
     uint32 VAO;
     glGenVertexArrays(1, &VAO);
-    glBindVertexArray(VAO);
+    GLBindVertexArray(VAO);
 
     return VAO;
 }
@@ -524,13 +807,193 @@ uint32 AddIBO(uint32 Usage, uint32 Size, void *Data)
     return Buffer;
 }
 
+// NOTE - Writes the indices as 16-bit to the bound element buffer, at FirstIndex.
+// They must fit : see MakeIndexBuffer.
+void UploadIndices16(uint32 FirstIndex, uint32 const *Indices, uint32 IndexCount)
+{
+    uint32 const ChunkSize = 1024;
+    uint16 Chunk[ChunkSize];
+    for(uint32 First = 0; First < IndexCount; First += ChunkSize)
+    {
+        uint32 Count = Min(IndexCount - First, ChunkSize);
+        for(uint32 i = 0; i < Count; ++i)
+        {
+            Assert(Indices[First + i] <= 0xFFFF);
+            Chunk[i] = (uint16)Indices[First + i];
+        }
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (FirstIndex + First) * sizeof(uint16), Count * sizeof(uint16), Chunk);
+    }
+}
+
+// NOTE - Like AddIBO, with 16-bit indices whenever the vertex count allows
+uint32 MakeIndexBuffer(uint32 const *Indices, uint32 IndexCount, uint32 VertexCount, uint32 *IndexType)
+{
+    if(VertexCount > 0x10000)
+    {
+        *IndexType = GL_UNSIGNED_INT;
+        return AddIBO(GL_STATIC_DRAW, IndexCount * sizeof(uint32), (void*)Indices);
+    }
+
+    *IndexType = GL_UNSIGNED_SHORT;
+    uint32 Buffer = AddIBO(GL_STATIC_DRAW, IndexCount * sizeof(uint16), NULL);
+    UploadIndices16(0, Indices, IndexCount);
+    return Buffer;
+}
+
 void DestroyMesh(mesh *Mesh)
 {
-    glDeleteBuffers(2, Mesh->VBO);
-    glDeleteVertexArrays(1, &Mesh->VAO);
+    if(!Mesh->Shared)
+    {
+        glDeleteBuffers(2, Mesh->VBO);
+        GLDeleteVertexArrays(1, &Mesh->VAO);
+    }
     Mesh->IndexCount = 0;
 }
 
+mesh_buffer MakeMeshBuffer(bool Packed = false)
+{
+    mesh_buffer Buffer = {};
+    Buffer.Format = Packed ? VERTEX_FORMAT_PACKED : VERTEX_FORMAT_STATIC;
+    Buffer.VAO = MakeVertexArrayObject();
+    Buffer.IBO = AddIBO(GL_STATIC_DRAW, MESH_BUFFER_INDICES * sizeof(uint16), NULL);
+
+    if(Packed)
+    {
+        Buffer.VBO = AddEmptyVBO(MESH_BUFFER_VERTICES * sizeof(packed_vertex), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(packed_vertex), (GLvoid*)offsetof(packed_vertex, Position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(packed_vertex), (GLvoid*)offsetof(packed_vertex, Texcoord));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, sizeof(packed_vertex), (GLvoid*)offsetof(packed_vertex, Normal));
+    }
+    else
+    {
+        Buffer.VBO = AddEmptyVBO(MESH_BUFFER_VERTICES * sizeof(static_vertex), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(static_vertex), (GLvoid*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(static_vertex), (GLvoid*)sizeof(vec3f));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(static_vertex), (GLvoid*)(sizeof(vec3f) + sizeof(vec2f)));
+    }
+    GLBindVertexArray(0);
+
+    return Buffer;
+}
+
+void DestroyMeshBuffer(mesh_buffer *Buffer)
+{
+    glDeleteBuffers(1, &Buffer->VBO);
+    glDeleteBuffers(1, &Buffer->IBO);
+    GLDeleteVertexArrays(1, &Buffer->VAO);
+    Buffer->VertexCount = Buffer->IndexCount = 0;
+}
+
+// NOTE - Bounds for the CPU culling (see cull.cpp). Small meshes also keep a copy of
+// their triangles as occluders when Memory is given, in the SessionArena.
+void SetMeshBounds(game_memory *Memory, mesh *Mesh, vec3f const *Positions, uint32 VertexCount,
+                   uint32 const *Indices, uint32 IndexCount)
+{
+    if(!VertexCount)
+    {
+        return;
+    }
+
+    Mesh->BoundsMin = Positions[0];
+    Mesh->BoundsMax = Positions[0];
+    for(uint32 i = 1; i < VertexCount; ++i)
+    {
+        Mesh->BoundsMin = vec3f(Min(Mesh->BoundsMin.x, Positions[i].x), Min(Mesh->BoundsMin.y, Positions[i].y),
+                                Min(Mesh->BoundsMin.z, Positions[i].z));
+        Mesh->BoundsMax = vec3f(Max(Mesh->BoundsMax.x, Positions[i].x), Max(Mesh->BoundsMax.y, Positions[i].y),
+                                Max(Mesh->BoundsMax.z, Positions[i].z));
+    }
+
+    Mesh->Center = (Mesh->BoundsMin + Mesh->BoundsMax) * 0.5f;
+    Mesh->Radius = 0.f;
+    for(uint32 i = 0; i < VertexCount; ++i)
+    {
+        Mesh->Radius = Max(Mesh->Radius, Length(Positions[i] - Mesh->Center));
+    }
+    // NOTE - Flat meshes still need some volume to be culled at all
+    Mesh->Radius = Max(Mesh->Radius, 1e-3f);
+
+    if(Memory && IndexCount <= MESH_OCCLUDER_MAX_INDICES)
+    {
+        Mesh->OccluderPositions = (vec3f*)PushArenaData(&Memory->SessionArena, VertexCount * sizeof(vec3f));
+        Mesh->OccluderIndices = (uint32*)PushArenaData(&Memory->SessionArena, IndexCount * sizeof(uint32));
+        memcpy((void*)Mesh->OccluderPositions, Positions, VertexCount * sizeof(vec3f));
+        memcpy(Mesh->OccluderIndices, Indices, IndexCount * sizeof(uint32));
+        Mesh->OccluderIndexCount = IndexCount;
+    }
+}
+
+// NOTE - Interleaves the attributes in the buffer. Texcoords and Normals can be NULL,
+// they're zeroed then. Indices are relative to the mesh, BaseVertex offsets them.
+mesh AddStaticMesh(game_memory *Memory, mesh_buffer *Buffer, uint32 VertexCount, vec3f const *Positions,
+                   vec2f const *Texcoords, vec3f const *Normals, uint32 IndexCount, uint32 const *Indices)
+{
+    mesh Mesh = {};
+    if(Buffer->VertexCount + VertexCount > MESH_BUFFER_VERTICES || Buffer->IndexCount + IndexCount > MESH_BUFFER_INDICES)
+    {
+        printf("Mesh buffer full, can't add a %u vertices mesh.\n", VertexCount);
+        return Mesh;
+    }
+
+    void *Vertices;
+    uint32 Stride;
+    if(Buffer->Format == VERTEX_FORMAT_PACKED)
+    {
+        Stride = sizeof(packed_vertex);
+        packed_vertex *Packed = (packed_vertex*)PushArenaData(&Memory->ScratchArena, VertexCount * Stride);
+        for(uint32 i = 0; i < VertexCount; ++i)
+        {
+            Packed[i].Position[0] = FloatToHalf(Positions[i].x);
+            Packed[i].Position[1] = FloatToHalf(Positions[i].y);
+            Packed[i].Position[2] = FloatToHalf(Positions[i].z);
+            Packed[i].Position[3] = 0;
+            Packed[i].Texcoord[0] = Texcoords ? FloatToHalf(Texcoords[i].x) : 0;
+            Packed[i].Texcoord[1] = Texcoords ? FloatToHalf(Texcoords[i].y) : 0;
+            OctEncodeNormal(Normals ? Normals[i] : vec3f(0.f), Packed[i].Normal);
+        }
+        Vertices = Packed;
+    }
+    else
+    {
+        Stride = sizeof(static_vertex);
+        static_vertex *Static = (static_vertex*)PushArenaData(&Memory->ScratchArena, VertexCount * Stride);
+        for(uint32 i = 0; i < VertexCount; ++i)
+        {
+            Static[i].Position = Positions[i];
+            Static[i].Texcoord = Texcoords ? Texcoords[i] : vec2f(0.f);
+            Static[i].Normal = Normals ? Normals[i] : vec3f(0.f);
+        }
+        Vertices = Static;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, Buffer->VBO);
+    glBufferSubData(GL_ARRAY_BUFFER, Buffer->VertexCount * Stride, VertexCount * Stride, Vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // NOTE - The element binding is part of the VAO
+    GLBindVertexArray(Buffer->VAO);
+    UploadIndices16(Buffer->IndexCount, Indices, IndexCount);
+    GLBindVertexArray(0);
+
+    Mesh.VAO = Buffer->VAO;
+    Mesh.IndexCount = IndexCount;
+    Mesh.IndexType = GL_UNSIGNED_SHORT;
+    Mesh.FirstIndex = Buffer->IndexCount;
+    Mesh.BaseVertex = (int32)Buffer->VertexCount;
+    Mesh.Shared = true;
+    SetMeshBounds(Memory, &Mesh, Positions, VertexCount, Indices, IndexCount);
+
+    Buffer->VertexCount += VertexCount;
+    Buffer->IndexCount += IndexCount;
+    return Mesh;
+}
+
 
 void FillDisplayTextInterleaved(char const *Text, uint32 TextLength, font *Font, vec3i Pos, int MaxPixelWidth, 
                                 real32 *VertData, uint16 *Indices)
@@ -656,7 +1119,7 @@ display_text MakeDisplayText(game_memory *Memory, font *Font, char const *Msg, i
     FillVBO(0, 3, GL_FLOAT, 0, 3 * VertexCount * sizeof(real32), Positions);
     FillVBO(1, 2, GL_FLOAT, 3 * VertexCount * sizeof(real32), 2 * VertexCount * sizeof(real32), Texcoords);
     Text.IndexCount = IndexCount;
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 
     Text.Texture = Font->AtlasTextureID;
     Text.Color = Color;
@@ -667,14 +1130,15 @@ display_text MakeDisplayText(game_memory *Memory, font *Font, char const *Msg, i
 void DestroyDisplayText(display_text *Text)
 {
     glDeleteBuffers(2, Text->VBO);
-    glDeleteVertexArrays(1, &Text->VAO);
+    GLDeleteVertexArrays(1, &Text->VAO);
     Text->IndexCount = 0;
 }
 
 ////////////////////////////////////////////////////////////////////////
 // NOTE - Primitive builders
 ////////////////////////////////////////////////////////////////////////
-mesh MakeUnitCube(bool MakeAdditionalAttribs = true)
+// NOTE - With a mesh_buffer the mesh is a range of it, with all its attributes
+mesh MakeUnitCube(bool MakeAdditionalAttribs = true, game_memory *Memory = NULL, mesh_buffer *Buffer = NULL)
 {
     mesh Cube = {};
 
@@ -786,9 +1250,15 @@ mesh MakeUnitCube(bool MakeAdditionalAttribs = true)
         Indices[i * 6 + 5] = i * 4 + 3;
     }
 
+    if(Buffer)
+    {
+        return AddStaticMesh(Memory, Buffer, 24, Position, Texcoord, Normal, 36, Indices);
+    }
+
     Cube.IndexCount = 36;
+    SetMeshBounds(Memory, &Cube, Position, 24, Indices, 36);
     Cube.VAO = MakeVertexArrayObject();
-    Cube.VBO[0] = AddIBO(GL_STATIC_DRAW, sizeof(Indices), Indices);
+    Cube.VBO[0] = MakeIndexBuffer(Indices, 36, 24, &Cube.IndexType);
     if(MakeAdditionalAttribs)
     {
         Cube.VBO[1] = AddEmptyVBO(sizeof(Position) + sizeof(Texcoord) + sizeof(Normal), GL_STATIC_DRAW);
@@ -800,13 +1270,13 @@ mesh MakeUnitCube(bool MakeAdditionalAttribs = true)
     {
         Cube.VBO[1] = AddVBO(0, 3, GL_FLOAT, GL_STATIC_DRAW, sizeof(Position), Position);
     }
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 
     return Cube;
 }
 
 // NOTE - Start is Top Left corner. End is Bottom Right corner.
-mesh Make2DQuad(vec2i Start, vec2i End)
+mesh Make2DQuad(vec2i Start, vec2i End, game_memory *Memory = NULL, mesh_buffer *Buffer = NULL)
 {
     mesh Quad = {};
 
@@ -828,18 +1298,32 @@ mesh Make2DQuad(vec2i Start, vec2i End)
 
     uint32 Indices[6] = { 0, 1, 2, 0, 2, 3 };
 
+    vec3f Position3D[4];
+    for(uint32 i = 0; i < 4; ++i)
+    {
+        Position3D[i] = vec3f(Position[i].x, Position[i].y, 0.f);
+    }
+
+    if(Buffer)
+    {
+        return AddStaticMesh(Memory, Buffer, 4, Position3D, Texcoord, NULL, 6, Indices);
+    }
+
+    SetMeshBounds(Memory, &Quad, Position3D, 4, Indices, 6);
     Quad.IndexCount = 6;
     Quad.VAO = MakeVertexArrayObject();
-    Quad.VBO[0] = AddIBO(GL_STATIC_DRAW, sizeof(Indices), Indices);
+    Quad.VBO[0] = MakeIndexBuffer(Indices, 6, 4, &Quad.IndexType);
     Quad.VBO[1] = AddEmptyVBO(sizeof(Position) + sizeof(Texcoord), GL_STATIC_DRAW);
     FillVBO(0, 2, GL_FLOAT, 0, sizeof(Position), Position);
     FillVBO(1, 2, GL_FLOAT, sizeof(Position), sizeof(Texcoord), Texcoord);
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
     
     return Quad;
 }
 
-mesh Make3DPlane(game_memory *Memory, vec2i Dimension, uint32 Subdivisions, uint32 TextureRepeatCount, bool Dynamic = false)
+// NOTE - Dynamic planes can't go in a mesh_buffer
+mesh Make3DPlane(game_memory *Memory, vec2i Dimension, uint32 Subdivisions, uint32 TextureRepeatCount, bool Dynamic = false,
+                 mesh_buffer *Buffer = NULL)
 {
     mesh Plane = {};
 
@@ -887,21 +1371,37 @@ mesh Make3DPlane(game_memory *Memory, vec2i Dimension, uint32 Subdivisions, uint
         }
     }
 
+    // NOTE - Dynamic planes keep their vertices in grid order for the updates
+    uint32 *Remap = Dynamic ? NULL : (uint32*)PushArenaData(&Memory->ScratchArena, 4 * BaseSize * sizeof(uint32));
+    OptimizeMeshIndices("Plane", Indices, 6 * BaseSize, 4 * BaseSize, Remap, &Memory->ScratchArena);
+    if(Remap)
+    {
+        RemapVertexStream(Positions, sizeof(vec3f), 4 * BaseSize, Remap, &Memory->ScratchArena);
+        RemapVertexStream(Normals, sizeof(vec3f), 4 * BaseSize, Remap, &Memory->ScratchArena);
+        RemapVertexStream(Texcoords, sizeof(vec2f), 4 * BaseSize, Remap, &Memory->ScratchArena);
+    }
+
+    if(Buffer && !Dynamic)
+    {
+        return AddStaticMesh(Memory, Buffer, 4 * BaseSize, Positions, Texcoords, Normals, 6 * BaseSize, Indices);
+    }
+
     Plane.IndexCount = 6 * BaseSize;
+    SetMeshBounds(Memory, &Plane, Positions, 4 * BaseSize, Indices, 6 * BaseSize);
     Plane.VAO = MakeVertexArrayObject();
-    Plane.VBO[0] = AddIBO(GL_STATIC_DRAW, IndicesSize, Indices);
+    Plane.VBO[0] = MakeIndexBuffer(Indices, 6 * BaseSize, 4 * BaseSize, &Plane.IndexType);
     // Positions and Normals in the 1st VBO
     Plane.VBO[1] = AddEmptyVBO(PositionsSize + NormalsSize, Dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
     FillVBO(0, 3, GL_FLOAT, 0, PositionsSize, Positions);
     FillVBO(2, 3, GL_FLOAT, PositionsSize, NormalsSize, Normals);
     // Texcoords in the 2nd VBO
     Plane.VBO[2] = AddVBO(1, 2, GL_FLOAT, GL_STATIC_DRAW, TexcoordsSize, Texcoords);
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 
     return Plane;
 }
 
-mesh MakeUnitSphere(bool MakeAdditionalAttribs = true)
+mesh MakeUnitSphere(bool MakeAdditionalAttribs = true, game_memory *Memory = NULL, mesh_buffer *Buffer = NULL)
 {
     mesh Sphere = {};
     
@@ -989,9 +1489,24 @@ mesh MakeUnitSphere(bool MakeAdditionalAttribs = true)
         }
     }
 
+    if(Memory)
+    {
+        uint32 *Remap = (uint32*)PushArenaData(&Memory->ScratchArena, nVerts * sizeof(uint32));
+        OptimizeMeshIndices("Sphere", Indices, nIndices, nVerts, Remap, &Memory->ScratchArena);
+        RemapVertexStream(Position, sizeof(vec3f), nVerts, Remap, &Memory->ScratchArena);
+        RemapVertexStream(Normal, sizeof(vec3f), nVerts, Remap, &Memory->ScratchArena);
+        RemapVertexStream(Texcoord, sizeof(vec2f), nVerts, Remap, &Memory->ScratchArena);
+    }
+
+    if(Buffer)
+    {
+        return AddStaticMesh(Memory, Buffer, nVerts, Position, Texcoord, Normal, nIndices, Indices);
+    }
+
     Sphere.IndexCount = nIndices;
+    SetMeshBounds(Memory, &Sphere, Position, nVerts, Indices, nIndices);
     Sphere.VAO = MakeVertexArrayObject();
-    Sphere.VBO[0] = AddIBO(GL_STATIC_DRAW, sizeof(Indices), Indices);
+    Sphere.VBO[0] = MakeIndexBuffer(Indices, nIndices, nVerts, &Sphere.IndexType);
     if(MakeAdditionalAttribs)
     {
         Sphere.VBO[1] = AddEmptyVBO(sizeof(Position) + sizeof(Texcoord) + sizeof(Normal), GL_STATIC_DRAW);
@@ -1003,7 +1518,7 @@ mesh MakeUnitSphere(bool MakeAdditionalAttribs = true)
     {
         Sphere.VBO[1] = AddVBO(0, 3, GL_FLOAT, GL_STATIC_DRAW, sizeof(Position), Position);
     }
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 
     return Sphere;
 }
@@ -1022,14 +1537,14 @@ void ComputeIrradianceCubemap(game_memory *Memory, path ExecFullPath, char const
     MakeRelativePath(VSPath, ExecFullPath, "data/shaders/skybox_vert.glsl");
     MakeRelativePath(FSPath, ExecFullPath, "data/shaders/latlong2cubemap_frag.glsl");
     ProgramLatlong2Cubemap = BuildShader(Memory, VSPath, FSPath);
-    glUseProgram(ProgramLatlong2Cubemap);
+    GLUseProgram(ProgramLatlong2Cubemap);
     SendInt(glGetUniformLocation(ProgramLatlong2Cubemap, "Envmap"), 0);
     CheckGLError("Latlong Shader");
 
     MakeRelativePath(VSPath, ExecFullPath, "data/shaders/skybox_vert.glsl");
     MakeRelativePath(FSPath, ExecFullPath, "data/shaders/cubemapconvolution_frag.glsl");
     ProgramCubemapConvolution = BuildShader(Memory, VSPath, FSPath);
-    glUseProgram(ProgramCubemapConvolution);
+    GLUseProgram(ProgramCubemapConvolution);
     SendInt(glGetUniformLocation(ProgramCubemapConvolution, "Cubemap"), 0);
     CheckGLError("Convolution Shader");
 
@@ -1050,11 +1565,11 @@ void ComputeIrradianceCubemap(game_memory *Memory, path ExecFullPath, char const
     *HDRIrradianceEnvmap = MakeCubemap(NULL, true, false, IrradianceCubemapWidth, IrradianceCubemapWidth);
     CheckGLError("IrradianceCubemap");
 
-    glDisable(GL_CULL_FACE);
-    glDepthFunc(GL_LEQUAL);
+    GLDisable(GL_CULL_FACE);
+    GLDepthFunc(GL_LEQUAL);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindVertexArray(SkyboxCube.VAO);
+    GLActiveTexture(0);
+    GLBindVertexArray(SkyboxCube.VAO);
     // The 6 view matrices for the 6 cubemap directions
     mat4f static const ViewDirs [] = {
         mat4f::LookAt(vec3f(0), vec3f( 1, 0, 0), vec3f(0, -1, 0)),
@@ -1066,63 +1581,52 @@ void ComputeIrradianceCubemap(game_memory *Memory, path ExecFullPath, char const
     };
     mat4f static const EnvmapProjectionMatrix = mat4f::Perspective(90.f, 1.f, 0.1f, 10.f);
 
-    // NOTE - Latlong to Cubemap
-    glUseProgram(ProgramLatlong2Cubemap);
-    // TODO - ProjMatrix updated only when resize happen
-    {
-        uint32 Loc = glGetUniformLocation(ProgramLatlong2Cubemap, "ProjMatrix");
-        SendMat4(Loc, EnvmapProjectionMatrix);
-        CheckGLError("ProjMatrix Latlong2Cubemap");
-    }
+    // NOTE - skybox_vert.glsl reads SkyViewMatrix from the ViewBlock
+    view_uniforms EnvmapView = {};
+    EnvmapView.ProjMatrix = EnvmapProjectionMatrix;
 
-    uint32 ViewLoc = glGetUniformLocation(ProgramLatlong2Cubemap, "ViewMatrix");
+    // NOTE - Latlong to Cubemap
+    GLUseProgram(ProgramLatlong2Cubemap);
 
     glViewport(0, 0, CubemapWidth, CubemapWidth);
-    glBindTexture(GL_TEXTURE_2D, HDRLatlongEnvmap);
-    glBindFramebuffer(GL_FRAMEBUFFER, FBOEnvmap.FBO);
+    GLBindTexture(0, GL_TEXTURE_2D, HDRLatlongEnvmap);
+    GLBindFramebuffer(FBOEnvmap.FBO);
     for(int i = 0; i < 6; ++i)
     {
-        SendMat4(ViewLoc, ViewDirs[i]);
+        EnvmapView.SkyViewMatrix = ViewDirs[i];
+        UploadViewUniforms(&EnvmapView);
         CheckGLError("ViewMatrix Latlong2Cubemap");
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
                 *HDRCubemapEnvmap, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glDrawElements(GL_TRIANGLES, SkyboxCube.IndexCount, GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, SkyboxCube.IndexCount, SkyboxCube.IndexType, 0);
     }
 
     // NOTE - Cubemap convolution
-    glUseProgram(ProgramCubemapConvolution);
-    // TODO - ProjMatrix updated only when resize happen
-    {
-        uint32 Loc = glGetUniformLocation(ProgramCubemapConvolution, "ProjMatrix");
-        mat4f EnvmapProjectionMatrix = mat4f::Perspective(90.f, 1.f, 0.1f, 10.f);
-        SendMat4(Loc, EnvmapProjectionMatrix);
-        CheckGLError("ProjMatrix CubemapConvolution");
-    }
-
-    ViewLoc = glGetUniformLocation(ProgramCubemapConvolution, "ViewMatrix");
+    GLUseProgram(ProgramCubemapConvolution);
 
     glViewport(0, 0, IrradianceCubemapWidth, IrradianceCubemapWidth);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, 32, 32);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, *HDRCubemapEnvmap); 
+    GLActiveTexture(0);
+    GLBindTexture(0, GL_TEXTURE_CUBE_MAP, *HDRCubemapEnvmap); 
     for(int i = 0; i < 6; ++i)
     {
-        SendMat4(ViewLoc, ViewDirs[i]);
+        EnvmapView.SkyViewMatrix = ViewDirs[i];
+        UploadViewUniforms(&EnvmapView);
         CheckGLError("ViewMatrix Cubemap Convolution");
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
                 *HDRIrradianceEnvmap, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glDrawElements(GL_TRIANGLES, SkyboxCube.IndexCount, GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, SkyboxCube.IndexCount, SkyboxCube.IndexType, 0);
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glDepthFunc(GL_LESS);
-    glEnable(GL_CULL_FACE);
+    GLBindFramebuffer(0);
+    GLDepthFunc(GL_LESS);
+    GLEnable(GL_CULL_FACE);
 
-    glDeleteTextures(1, &HDRLatlongEnvmap);
-    glDeleteProgram(ProgramLatlong2Cubemap);
-    glDeleteProgram(ProgramCubemapConvolution);
+    GLDeleteTextures(1, &HDRLatlongEnvmap);
+    GLDeleteProgram(ProgramLatlong2Cubemap);
+    GLDeleteProgram(ProgramCubemapConvolution);
     DestroyFramebuffer(&FBOEnvmap);
     DestroyMesh(&SkyboxCube);
 }
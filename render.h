@@ -55,6 +55,154 @@ struct mesh
     uint32 VAO;
     uint32 VBO[3]; // 0: indices, 1-? : data
     uint32 IndexCount;
+    uint32 IndexType;   // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32 FirstIndex;  // In the index buffer, for the meshes of a mesh_buffer
+    int32  BaseVertex;
+    bool   Shared;      // Range of a mesh_buffer, which owns the GL objects
+
+    // NOTE - Model space bounds, set by the builders. A 0 Radius means none : never culled.
+    vec3f  BoundsMin;
+    vec3f  BoundsMax;
+    vec3f  Center;      // Of the bounding sphere
+    real32 Radius;
+
+    // NOTE - Triangles drawn in the occlusion buffer, only for small meshes
+    vec3f  *OccluderPositions;
+    uint32 *OccluderIndices;
+    uint32 OccluderIndexCount;
+};
+
+// NOTE - Static geometry sub-allocated from one vertex and one index buffer, all
+// with the same vertex format, so that the meshes share a VAO and can be drawn
+// together by one glMultiDrawElementsIndirect. Ranges are never freed.
+// Indices are 16-bit and relative to each mesh, BaseVertex offsets them.
+#define MESH_BUFFER_VERTICES 65536
+#define MESH_BUFFER_INDICES (4 * MESH_BUFFER_VERTICES)
+#define MESH_OCCLUDER_MAX_INDICES 64   // Bigger meshes are never occluders
+
+// NOTE - Also told to the shaders through the FrameBlock, they decode the packed normals
+enum vertex_format
+{
+    VERTEX_FORMAT_STATIC,   // static_vertex
+    VERTEX_FORMAT_PACKED,   // packed_vertex
+};
+
+struct static_vertex
+{
+    vec3f Position;     // location 0
+    vec2f Texcoord;     // location 1
+    vec3f Normal;       // location 2
+};
+
+// NOTE - Half of a static_vertex. Half floats hold the plane's coordinates and its
+// repeated texcoords exactly enough, the normal is octahedral encoded.
+struct packed_vertex
+{
+    uint16 Position[4]; // location 0, half x 3, 1 unused
+    uint16 Texcoord[2]; // location 1, half x 2
+    int16  Normal[2];   // location 3, snorm16 x 2, see OctEncodeNormal
+};
+
+struct mesh_buffer
+{
+    uint32 VAO;
+    uint32 VBO;
+    uint32 IBO;
+    uint32 VertexCount;
+    uint32 IndexCount;
+    uint32 Format;      // vertex_format
+};
+
+// NOTE - Interned uniform names. These are interned first (see InitUniformNames),
+// so their IDs are constants. Any other name gets an ID from UniformName.
+enum uniform_name
+{
+    UNIFORM_NONE,
+    UNIFORM_MODEL_MATRIX,
+    UNIFORM_COLOR,
+    UNIFORM_BUILTIN_COUNT
+};
+
+// NOTE - Uniform blocks shared by all the programs, at fixed binding points.
+// These are std140 mirrors of the blocks declared in data/shaders : a vec3
+// followed by a float shares its 16 bytes, keep them in sync.
+enum uniform_block
+{
+    UNIFORM_BLOCK_FRAME,    // FrameBlock : once per frame
+    UNIFORM_BLOCK_VIEW,     // ViewBlock : once per view
+    UNIFORM_BLOCK_MATERIAL, // MaterialBlock : the frame's materials, indexed by each instance
+    UNIFORM_BLOCK_COUNT
+};
+
+struct frame_uniforms
+{
+    vec4f  LightColor;
+    vec3f  SunDirection;
+    real32 Time;
+    uint32 VertexFormat;    // Of the mesh_buffer meshes
+    uint32 _Pad[3];
+};
+
+struct view_uniforms
+{
+    mat4f  ProjMatrix;
+    mat4f  ViewMatrix;
+    mat4f  SkyViewMatrix;
+    mat4f  OrthoMatrix;
+    vec3f  CameraPos;
+    real32 _Pad;
+};
+
+// NOTE - Size of the Materials array of MaterialBlock, an std140 array of
+// structs : each one is rounded to 32 bytes
+#define UNIFORM_MAX_MATERIALS 256
+
+struct material_uniforms
+{
+    vec3f  AlbedoMult;
+    real32 MetallicMult;
+    real32 RoughnessMult;
+    real32 _Pad[3];
+};
+
+// NOTE - Shadow copy of the GL state the renderer touches, see GLUseProgram and
+// co in render.cpp. Calls that wouldn't change anything are skipped and counted.
+#define GL_STATE_TEXTURE_UNITS 16
+#define GL_STATE_UNKNOWN 0xFFFFFFFF     // Next call goes through, whatever its value
+
+enum gl_state_cap
+{
+    GL_STATE_CAP_BLEND,
+    GL_STATE_CAP_DEPTH_TEST,
+    GL_STATE_CAP_CULL_FACE,
+    GL_STATE_CAP_COUNT
+};
+
+struct gl_state_cache
+{
+    uint32 Program;
+    uint32 VAO;
+    uint32 Framebuffer;
+    uint32 ActiveUnit;                  // Index, not GL_TEXTURE0 + Index
+    uint32 Texture2D[GL_STATE_TEXTURE_UNITS];
+    uint32 TextureCube[GL_STATE_TEXTURE_UNITS];
+    uint32 Caps[GL_STATE_CAP_COUNT];    // 0 or 1
+    uint32 DepthFunc;
+    uint32 BlendSrc;
+    uint32 BlendDst;
+
+    uint32 Calls;                       // Made through the cache this frame
+    uint32 Filtered;                    // Of which redundant, never sent to GL
+    uint32 LastCalls;                   // Previous frame's, for display
+    uint32 LastFiltered;
+};
+
+// NOTE - A linked program and the locations of its active uniforms, reflected
+// once at link time so that nothing goes through glGetUniformLocation per frame
+struct shader_program
+{
+    uint32 ID;
+    hash_map<uint32, int32> Uniforms;   // Interned name -> location
 };
 
 #endif
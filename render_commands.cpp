@@ -0,0 +1,610 @@
+#ifndef RENDER_COMMANDS_CPP
+#define RENDER_COMMANDS_CPP
+
+// NOTE - Platform side of the render command buffer (render_commands.h).
+// The buffer lives in the SessionArena, it is reset before GameUpdate and
+// executed after it : sort the keys, batch the draws that can share an instanced
+// draw, then only touch the GL state when the program, the textures, the mesh or
+// the pass changes. Camera, light and materials go to the shared uniform blocks.
+#define RENDER_COMMAND_DATA_SIZE Megabytes(2)
+#define RENDER_COMMAND_MAX_ENTRIES 16384
+
+// NOTE - Draws are batched into instanced draws : each instance reads its model
+// matrix and material index from the instance buffer, set up as vertex attributes
+// of every mesh VAO (see AttachInstanceAttributes and in_model_matrix in the shaders)
+#define RENDER_MAX_INSTANCES RENDER_COMMAND_MAX_ENTRIES
+#define RENDER_INSTANCE_ATTRIB 8    // ModelMatrix columns : 8 to 11, Material : 12
+
+#if RENDER_MAX_MATERIALS > UNIFORM_MAX_MATERIALS
+#error "MaterialBlock can't hold RENDER_MAX_MATERIALS materials"
+#endif
+
+struct render_instance
+{
+    mat4f  ModelMatrix;
+    uint32 Material;
+    uint32 _Pad[3];
+};
+
+// NOTE - GL's DrawElementsIndirectCommand, one per batch
+struct render_indirect_command
+{
+    uint32 Count;
+    uint32 InstanceCount;
+    uint32 FirstIndex;
+    int32  BaseVertex;
+    uint32 BaseInstance;
+};
+
+struct render_instance_buffer
+{
+    uint32 VBO;
+    uint32 MeshVAOs[RENDER_MESH_COUNT];     // VAO each mesh had when its instance attributes were set
+    render_instance *Uploaded;              // What the VBO holds, unchanged frames skip the upload
+    uint32 UploadedCount;
+};
+
+// NOTE - What the ids of render_commands.h map to, filled by the platform
+struct render_resources
+{
+    shader_program *Programs[RENDER_SHADER_COUNT];
+    mesh Meshes[RENDER_MESH_COUNT];
+    uint32 Textures[RENDER_TEXTURE_COUNT];
+    uint32 TextureTargets[RENDER_TEXTURE_COUNT];
+    mat4f ProjMatrix;
+    mat4f OrthoMatrix;
+    bool OcclusionCulling;              // Off : frustum culling only
+    uint32 VertexFormat;                // Of the meshes in a mesh_buffer
+    render_instance_buffer Instances;
+    uint32 IndirectBuffer;              // render_indirect_command, rebuilt each frame
+};
+
+struct render_stats
+{
+    uint32 CommandCount;
+    uint32 DrawCount;           // glMultiDrawElementsIndirect calls
+    uint32 BatchCount;          // Indirect commands
+    uint32 InstanceCount;
+    uint32 ProgramChanges;
+    uint32 MaterialChanges;
+    uint32 MeshChanges;
+    uint32 InstanceUploads;
+    uint32 DroppedCount;
+    uint32 ObjectCount;         // Draw commands, before culling
+    uint32 FrustumCulled;
+    uint32 OcclusionCulled;
+};
+
+// NOTE - Draws of one pass and shader sharing a mesh and textures, drawn at once
+struct render_batch
+{
+    uint32 Pass;
+    uint32 Shader;
+    uint32 Mesh;
+    render_cmd_set_material *Material;  // The first draw's, for the textures
+    uint32 FirstInstance;
+    uint32 InstanceCount;
+};
+
+void InitRenderCommands(game_memory *Memory, render_commands *Commands)
+{
+    Commands->Data = (uint8*)PushArenaData(&Memory->SessionArena, RENDER_COMMAND_DATA_SIZE);
+    Commands->DataCapacity = RENDER_COMMAND_DATA_SIZE;
+    Commands->Entries = (render_sort_entry*)PushArenaData(&Memory->SessionArena, RENDER_COMMAND_MAX_ENTRIES * sizeof(render_sort_entry));
+    Commands->EntryCapacity = RENDER_COMMAND_MAX_ENTRIES;
+    Commands->DataSize = 0;
+    Commands->EntryCount = 0;
+    Commands->DroppedCount = 0;
+}
+
+// NOTE - Needs the GL context
+void InitRenderBuffers(game_memory *Memory, render_resources *Resources)
+{
+    render_instance_buffer *Instances = &Resources->Instances;
+    Instances->Uploaded = (render_instance*)PushArenaData(&Memory->SessionArena, RENDER_MAX_INSTANCES * sizeof(render_instance));
+    Instances->UploadedCount = 0;
+
+    glGenBuffers(1, &Instances->VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, Instances->VBO);
+    glBufferData(GL_ARRAY_BUFFER, RENDER_MAX_INSTANCES * sizeof(render_instance), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &Resources->IndirectBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, Resources->IndirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, RENDER_MAX_INSTANCES * sizeof(render_indirect_command), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void DestroyRenderBuffers(render_resources *Resources)
+{
+    glDeleteBuffers(1, &Resources->Instances.VBO);
+    glDeleteBuffers(1, &Resources->IndirectBuffer);
+    Resources->Instances.VBO = 0;
+    Resources->IndirectBuffer = 0;
+}
+
+void ResetRenderCommands(render_commands *Commands)
+{
+    Commands->DataSize = 0;
+    Commands->EntryCount = 0;
+    Commands->DroppedCount = 0;
+}
+
+// NOTE - LSD radix sort, 8 bits per pass, stable. Passes where all the keys share
+// the same digit are skipped : with few passes, shaders and materials, most are.
+// Returns the sorted array, either Entries or Temp.
+render_sort_entry *RadixSortRenderEntries(render_sort_entry *Entries, render_sort_entry *Temp, uint32 Count)
+{
+    render_sort_entry *Src = Entries;
+    render_sort_entry *Dst = Temp;
+
+    for(uint32 Shift = 0; Shift < 64; Shift += 8)
+    {
+        uint32 Offsets[256] = {};
+        for(uint32 i = 0; i < Count; ++i)
+        {
+            Offsets[(Src[i].Key >> Shift) & 0xFF]++;
+        }
+
+        if(Count == 0 || Offsets[(Src[0].Key >> Shift) & 0xFF] == Count)
+        {
+            continue;
+        }
+
+        uint32 Total = 0;
+        for(uint32 Digit = 0; Digit < 256; ++Digit)
+        {
+            uint32 DigitCount = Offsets[Digit];
+            Offsets[Digit] = Total;
+            Total += DigitCount;
+        }
+
+        for(uint32 i = 0; i < Count; ++i)
+        {
+            Dst[Offsets[(Src[i].Key >> Shift) & 0xFF]++] = Src[i];
+        }
+
+        render_sort_entry *Swap = Src;
+        Src = Dst;
+        Dst = Swap;
+    }
+
+    return Src;
+}
+
+#if RADAR_PROFILE
+static char const *RenderPassNames[RENDER_PASS_COUNT] = { "Setup", "Opaque", "Water", "Sky" };
+#endif
+
+static void BeginRenderPass(uint32 Pass)
+{
+    switch(Pass)
+    {
+        case RENDER_PASS_WATER:
+        {
+            GLDisable(GL_CULL_FACE);
+            GLDepthFunc(GL_LESS);
+        } break;
+        case RENDER_PASS_SKY:
+        {
+            GLDisable(GL_CULL_FACE);
+            GLDepthFunc(GL_LEQUAL);
+        } break;
+        default:
+        {
+            GLEnable(GL_CULL_FACE);
+            GLDepthFunc(GL_LESS);
+        } break;
+    }
+}
+
+// NOTE - Called once the setup commands are read : everything the programs share
+// for this frame goes to the uniform blocks in one upload each.
+static void UploadRenderUniforms(game_memory *Memory, render_commands *Commands, render_resources *Resources,
+                                 render_cmd_set_camera *Camera, render_cmd_set_light *Light,
+                                 render_cmd_set_material **Materials)
+{
+    frame_uniforms Frame = {};
+    Frame.LightColor = Light->Color;
+    Frame.SunDirection = Light->Direction;
+    Frame.Time = Commands->Time;
+    Frame.VertexFormat = Resources->VertexFormat;
+    UploadFrameUniforms(&Frame);
+
+    view_uniforms View = {};
+    View.ProjMatrix = Resources->ProjMatrix;
+    View.ViewMatrix = Camera->ViewMatrix;
+    View.SkyViewMatrix = Camera->ViewMatrix;
+    View.SkyViewMatrix.SetTranslation(vec3f(0.f));
+    View.OrthoMatrix = Resources->OrthoMatrix;
+    View.CameraPos = Camera->Position;
+    UploadViewUniforms(&View);
+
+    // NOTE - Unused slots are uploaded too, zeroed
+    material_uniforms *Staging = (material_uniforms*)PushArenaData(&Memory->ScratchArena, UNIFORM_MAX_MATERIALS * sizeof(material_uniforms));
+    memset((void*)Staging, 0, UNIFORM_MAX_MATERIALS * sizeof(material_uniforms));
+    for(uint32 i = 0; i < UNIFORM_MAX_MATERIALS; ++i)
+    {
+        if(i < RENDER_MAX_MATERIALS && Materials[i])
+        {
+            Staging[i].AlbedoMult = Materials[i]->AlbedoMult;
+            Staging[i].MetallicMult = Materials[i]->MetallicMult;
+            Staging[i].RoughnessMult = Materials[i]->RoughnessMult;
+        }
+    }
+    UploadMaterialUniforms(Staging);
+}
+
+// NOTE - Once per mesh VAO, the VAO keeps them. Leaves the VAO bound.
+static void AttachInstanceAttributes(render_instance_buffer *Instances, uint32 VAO)
+{
+    GLBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, Instances->VBO);
+    for(uint32 Column = 0; Column < 4; ++Column)
+    {
+        uint32 Attrib = RENDER_INSTANCE_ATTRIB + Column;
+        glEnableVertexAttribArray(Attrib);
+        glVertexAttribPointer(Attrib, 4, GL_FLOAT, GL_FALSE, sizeof(render_instance), (GLvoid*)(Column * sizeof(vec4f)));
+        glVertexAttribDivisor(Attrib, 1);
+    }
+
+    uint32 MaterialAttrib = RENDER_INSTANCE_ATTRIB + 4;
+    glEnableVertexAttribArray(MaterialAttrib);
+    glVertexAttribIPointer(MaterialAttrib, 1, GL_UNSIGNED_INT, sizeof(render_instance), (GLvoid*)sizeof(mat4f));
+    glVertexAttribDivisor(MaterialAttrib, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// NOTE - Orphans the buffer before writing it, the previous frame's draws may still read it
+static bool UploadRenderInstances(render_instance_buffer *Instances, render_instance *Data, uint32 Count)
+{
+    if(Count == Instances->UploadedCount && !memcmp(Data, Instances->Uploaded, Count * sizeof(render_instance)))
+    {
+        return false;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, Instances->VBO);
+    glBufferData(GL_ARRAY_BUFFER, RENDER_MAX_INSTANCES * sizeof(render_instance), NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, Count * sizeof(render_instance), Data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    memcpy((void*)Instances->Uploaded, Data, Count * sizeof(render_instance));
+    Instances->UploadedCount = Count;
+    return true;
+}
+
+inline bool SameTextures(render_cmd_set_material *A, render_cmd_set_material *B)
+{
+    return A == B || !memcmp(A->Textures, B->Textures, sizeof(A->Textures));
+}
+
+// NOTE - Bounding spheres against the frustum first, then when enabled, the boxes
+// of what's left against the occlusion buffer, where the visible opaque occluders
+// were drawn. The sky and meshes without bounds (the water) are always visible.
+static void CullRenderDraws(game_memory *Memory, render_resources *Resources, mat4f const &ViewProj,
+                            render_cmd_draw_mesh **Draws, uint32 *DrawPasses, uint32 DrawCount,
+                            bool *Visible, render_stats *Stats)
+{
+    TIMED_FUNCTION();
+    Stats->ObjectCount = DrawCount;
+
+    uint32 PaddedCount = (DrawCount + 3) & ~3u;
+    vec4f *Spheres = (vec4f*)PushArenaData(&Memory->ScratchArena, Max(PaddedCount, 4u) * sizeof(vec4f));
+    for(uint32 i = 0; i < PaddedCount; ++i)
+    {
+        Spheres[i] = vec4f(0.f, 0.f, 0.f, CULL_INFINITE_RADIUS);
+        if(i >= DrawCount)
+        {
+            continue;
+        }
+
+        mesh *Mesh = &Resources->Meshes[Draws[i]->Mesh];
+        if(DrawPasses[i] != RENDER_PASS_SKY && Mesh->Radius > 0.f)
+        {
+            mat4f const &Model = Draws[i]->ModelMatrix;
+            vec4f Center = Model * vec4f(Mesh->Center.x, Mesh->Center.y, Mesh->Center.z, 1.f);
+            real32 Scale = 0.f;
+            for(int c = 0; c < 3; ++c)
+            {
+                Scale = Max(Scale, Length(vec3f(Model.M[c].x, Model.M[c].y, Model.M[c].z)));
+            }
+            Spheres[i] = vec4f(Center.x, Center.y, Center.z, Mesh->Radius * Scale);
+        }
+    }
+
+    frustum Frustum = MakeFrustum(ViewProj);
+    Stats->FrustumCulled = FrustumCullSpheres(&Frustum, Spheres, DrawCount, Visible);
+
+    if(!Resources->OcclusionCulling)
+    {
+        return;
+    }
+
+    occlusion_buffer *Occlusion = (occlusion_buffer*)PushArenaStruct(&Memory->ScratchArena, occlusion_buffer);
+    ClearOcclusionBuffer(Occlusion);
+    for(uint32 i = 0; i < DrawCount; ++i)
+    {
+        mesh *Mesh = &Resources->Meshes[Draws[i]->Mesh];
+        if(Visible[i] && DrawPasses[i] == RENDER_PASS_OPAQUE && Mesh->OccluderIndexCount)
+        {
+            RasterizeOccluder(Occlusion, ViewProj * Draws[i]->ModelMatrix, Mesh->OccluderPositions,
+                              Mesh->OccluderIndices, Mesh->OccluderIndexCount);
+        }
+    }
+
+    for(uint32 i = 0; i < DrawCount; ++i)
+    {
+        mesh *Mesh = &Resources->Meshes[Draws[i]->Mesh];
+        if(Visible[i] && DrawPasses[i] != RENDER_PASS_SKY && Mesh->Radius > 0.f &&
+           IsBoxOccluded(Occlusion, ViewProj * Draws[i]->ModelMatrix, Mesh->BoundsMin, Mesh->BoundsMax))
+        {
+            Visible[i] = false;
+            ++Stats->OcclusionCulled;
+        }
+    }
+}
+
+// NOTE - Needs the GL context. Leaves texture unit 0 active and the default pass state.
+// The sorted draws are grouped by pass and shader, then in each group by mesh and
+// textures : the materials only differ by the index each instance carries. A group
+// draws its batches in the order of their first draw, so front to back still mostly holds.
+// Each batch is an indirect command. Consecutive batches that share the pass, the
+// program, the textures and the VAO (the meshes of a mesh_buffer) are one multi-draw.
+render_stats ExecuteRenderCommands(game_memory *Memory, render_commands *Commands, render_resources *Resources)
+{
+    TIMED_FUNCTION();
+    render_stats Stats = {};
+
+    uint32 Count = Min((uint32)Commands->EntryCount, Commands->EntryCapacity);
+    Stats.CommandCount = Count;
+    Stats.DroppedCount = (uint32)Commands->DroppedCount;
+
+    uint32 Capacity = Max(Count, 1u);
+    render_sort_entry *Temp = (render_sort_entry*)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(render_sort_entry));
+    render_sort_entry *Sorted = RadixSortRenderEntries(Commands->Entries, Temp, Count);
+
+    // NOTE - vec3f doesn't zero itself, = {} leaves it alone. Used when a frame
+    // has no SET_CAMERA or SET_LIGHT : identity view, no light.
+    render_cmd_set_camera Camera = {};
+    Camera.Position = vec3f(0.f);
+    render_cmd_set_light Light = {};
+    Light.Direction = vec3f(0.f);
+    render_cmd_set_material *Materials[RENDER_MAX_MATERIALS] = {};
+
+    render_cmd_draw_mesh **Draws = (render_cmd_draw_mesh**)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(render_cmd_draw_mesh*));
+    uint32 *DrawPasses = (uint32*)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(uint32));
+    uint32 DrawCount = 0;
+
+    for(uint32 i = 0; i < Count; ++i)
+    {
+        render_sort_entry *Entry = &Sorted[i];
+        if(Entry->Offset == 0xFFFFFFFF)
+        {
+            continue;
+        }
+
+        render_command_header *Header = (render_command_header*)(Commands->Data + Entry->Offset);
+        void *Cmd = Header + 1;
+
+        switch(Header->Type)
+        {
+            case RENDER_CMD_SET_CAMERA:
+            {
+                Camera = *(render_cmd_set_camera*)Cmd;
+            } break;
+            case RENDER_CMD_SET_LIGHT:
+            {
+                Light = *(render_cmd_set_light*)Cmd;
+            } break;
+            case RENDER_CMD_SET_MATERIAL:
+            {
+                render_cmd_set_material *Material = (render_cmd_set_material*)Cmd;
+                if(Material->Material < RENDER_MAX_MATERIALS && Material->Shader < RENDER_SHADER_COUNT)
+                {
+                    Materials[Material->Material] = Material;
+                }
+            } break;
+            case RENDER_CMD_DRAW_MESH:
+            {
+                render_cmd_draw_mesh *Draw = (render_cmd_draw_mesh*)Cmd;
+                render_cmd_set_material *Material = (Draw->Material < RENDER_MAX_MATERIALS) ? Materials[Draw->Material] : NULL;
+                if(!Material || Draw->Mesh >= RENDER_MESH_COUNT)
+                {
+                    Assert(!"Draw with an undefined material or mesh");
+                    break;
+                }
+                if(!Resources->Meshes[Draw->Mesh].IndexCount)
+                {
+                    // NOTE - Not created yet, e.g. the water before InitializeFromGame
+                    break;
+                }
+
+                DrawPasses[DrawCount] = (uint32)(Entry->Key >> 60);
+                Draws[DrawCount++] = Draw;
+            } break;
+            default:
+            {
+                Assert(!"Unknown render command");
+            } break;
+        }
+    }
+
+    UploadRenderUniforms(Memory, Commands, Resources, &Camera, &Light, Materials);
+
+    bool *Visible = (bool*)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(bool));
+    CullRenderDraws(Memory, Resources, Resources->ProjMatrix * Camera.ViewMatrix, Draws, DrawPasses, DrawCount, Visible, &Stats);
+
+    render_batch *Batches = (render_batch*)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(render_batch));
+    uint32 *DrawBatches = (uint32*)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(uint32));
+    uint32 BatchCount = 0, GroupStart = 0;
+
+    for(uint32 i = 0; i < DrawCount; ++i)
+    {
+        if(!Visible[i])
+        {
+            continue;
+        }
+
+        render_cmd_draw_mesh *Draw = Draws[i];
+        render_cmd_set_material *Material = Materials[Draw->Material];
+        uint32 Pass = DrawPasses[i];
+        if(BatchCount == 0 || Batches[BatchCount-1].Pass != Pass || Batches[BatchCount-1].Shader != Material->Shader)
+        {
+            GroupStart = BatchCount;
+        }
+
+        uint32 BatchIdx = GroupStart;
+        for(; BatchIdx < BatchCount; ++BatchIdx)
+        {
+            if(Batches[BatchIdx].Mesh == Draw->Mesh && SameTextures(Batches[BatchIdx].Material, Material))
+            {
+                break;
+            }
+        }
+        if(BatchIdx == BatchCount)
+        {
+            render_batch *Batch = &Batches[BatchCount++];
+            Batch->Pass = Pass;
+            Batch->Shader = Material->Shader;
+            Batch->Mesh = Draw->Mesh;
+            Batch->Material = Material;
+            Batch->FirstInstance = 0;
+            Batch->InstanceCount = 0;
+        }
+
+        Batches[BatchIdx].InstanceCount++;
+        DrawBatches[i] = BatchIdx;
+    }
+
+    // NOTE - Each batch gets a contiguous range of instances, in draw order
+    uint32 InstanceCount = 0;
+    for(uint32 i = 0; i < BatchCount; ++i)
+    {
+        Batches[i].FirstInstance = InstanceCount;
+        InstanceCount += Batches[i].InstanceCount;
+        Batches[i].InstanceCount = 0;
+    }
+
+    render_instance *Instances = (render_instance*)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(render_instance));
+    for(uint32 i = 0; i < DrawCount; ++i)
+    {
+        if(!Visible[i])
+        {
+            continue;
+        }
+
+        render_batch *Batch = &Batches[DrawBatches[i]];
+        render_instance *Instance = &Instances[Batch->FirstInstance + Batch->InstanceCount++];
+        *Instance = render_instance();
+        Instance->ModelMatrix = Draws[i]->ModelMatrix;
+        Instance->Material = Draws[i]->Material;
+    }
+
+    render_instance_buffer *InstanceBuffer = &Resources->Instances;
+    Stats.InstanceUploads = UploadRenderInstances(InstanceBuffer, Instances, InstanceCount) ? 1 : 0;
+    Stats.InstanceCount = InstanceCount;
+
+    render_indirect_command *Indirect = (render_indirect_command*)PushArenaData(&Memory->ScratchArena, Capacity * sizeof(render_indirect_command));
+    for(uint32 i = 0; i < BatchCount; ++i)
+    {
+        mesh *Mesh = &Resources->Meshes[Batches[i].Mesh];
+        Indirect[i].Count = Mesh->IndexCount;
+        Indirect[i].InstanceCount = Batches[i].InstanceCount;
+        Indirect[i].FirstIndex = Mesh->FirstIndex;
+        Indirect[i].BaseVertex = Mesh->BaseVertex;
+        Indirect[i].BaseInstance = Batches[i].FirstInstance;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, Resources->IndirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, RENDER_MAX_INSTANCES * sizeof(render_indirect_command), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, BatchCount * sizeof(render_indirect_command), Indirect);
+    Stats.BatchCount = BatchCount;
+
+    uint32 CurrentPass = RENDER_PASS_SETUP;
+    uint32 CurrentShader = RENDER_SHADER_COUNT;
+    uint32 CurrentProgram = 0;
+    render_cmd_set_material *CurrentMaterial = NULL;
+    uint32 CurrentVAO = 0;
+
+    for(uint32 First = 0; First < BatchCount;)
+    {
+        render_batch *Batch = &Batches[First];
+        mesh *Mesh = &Resources->Meshes[Batch->Mesh];
+
+        uint32 End = First + 1;
+        while(End < BatchCount && Batches[End].Pass == Batch->Pass && Batches[End].Shader == Batch->Shader &&
+              Resources->Meshes[Batches[End].Mesh].VAO == Mesh->VAO && SameTextures(Batches[End].Material, Batch->Material))
+        {
+            ++End;
+        }
+
+        if(Batch->Pass != CurrentPass)
+        {
+#if RADAR_PROFILE
+            if(CurrentPass != RENDER_PASS_SETUP) GpuProfileEndZone();
+            GpuProfileBeginZone(RenderPassNames[Min(Batch->Pass, RENDER_PASS_COUNT - 1u)]);
+#endif
+            BeginRenderPass(Batch->Pass);
+            CurrentPass = Batch->Pass;
+        }
+
+        shader_program *Program = Resources->Programs[Batch->Shader];
+        if(Batch->Shader != CurrentShader || Program->ID != CurrentProgram)
+        {
+            GLUseProgram(Program->ID);
+            CurrentShader = Batch->Shader;
+            CurrentProgram = Program->ID;
+            ++Stats.ProgramChanges;
+        }
+
+        if(!CurrentMaterial || !SameTextures(Batch->Material, CurrentMaterial))
+        {
+            for(uint32 Unit = 0; Unit < RENDER_MAX_TEXTURE_UNITS; ++Unit)
+            {
+                uint32 Texture = Batch->Material->Textures[Unit];
+                if(Texture != RENDER_TEXTURE_NONE && Texture < RENDER_TEXTURE_COUNT)
+                {
+                    // NOTE - Filtered by the GL state cache when already there
+                    GLBindTexture(Unit, Resources->TextureTargets[Texture], Resources->Textures[Texture]);
+                }
+            }
+            CurrentMaterial = Batch->Material;
+            ++Stats.MaterialChanges;
+        }
+
+        for(uint32 i = First; i < End; ++i)
+        {
+            uint32 MeshID = Batches[i].Mesh;
+            if(InstanceBuffer->MeshVAOs[MeshID] != Mesh->VAO)
+            {
+                AttachInstanceAttributes(InstanceBuffer, Mesh->VAO);
+                InstanceBuffer->MeshVAOs[MeshID] = Mesh->VAO;
+            }
+        }
+        if(Mesh->VAO != CurrentVAO)
+        {
+            GLBindVertexArray(Mesh->VAO);
+            CurrentVAO = Mesh->VAO;
+            ++Stats.MeshChanges;
+        }
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, Mesh->IndexType, (GLvoid*)(First * sizeof(render_indirect_command)),
+                                    End - First, 0);
+        ++Stats.DrawCount;
+        First = End;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+#if RADAR_PROFILE
+    if(CurrentPass != RENDER_PASS_SETUP) GpuProfileEndZone();
+#endif
+    BeginRenderPass(RENDER_PASS_OPAQUE);
+    GLActiveTexture(0);
+    GLBindVertexArray(0);
+    CheckGLError("Render Commands");
+
+    return Stats;
+}
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef RENDER_COMMANDS_H
+#define RENDER_COMMANDS_H
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - Render command buffer, shared by the Platform and the Game DLL.
+// The game describes its frame as a list of commands pushed in a buffer that
+// the platform resets each frame. Each command comes with a 64-bit sort key :
+// the platform radix-sorts the keys, then executes the commands in that order
+// (see render_commands.cpp), so that draws sharing a shader or a material are
+// contiguous and state changes only happen when the key says they must.
+// Pushing is lock-free : any thread can fill the buffer during GameUpdate.
+//
+// Sort key layout, from the most significant bit :
+//   [63..60] Pass       RENDER_PASS_SETUP first : camera, light, materials
+//   [59..54] Shader     render_shader_id
+//   [53..38] Material   Game-defined index, see RENDER_CMD_SET_MATERIAL
+//   [37..14] Depth      Quantized view distance, see RenderDepthKey
+//   [13..0]  Unused     Equal keys keep their push order (stable sort)
+//////////////////////////////////////////////////////////////////////////
+#define RENDER_MAX_MATERIALS 256
+#define RENDER_MAX_TEXTURE_UNITS 5
+#define RENDER_DEPTH_RANGE 1000.f   // Anything further sorts as the furthest
+#define RENDER_PLANE_WIDTH 256      // Size of RENDER_MESH_PLANE, its origin is a corner
+
+// NOTE - Platform-owned GPU resources the commands refer to
+enum render_shader_id
+{
+    RENDER_SHADER_MESH,     // PBR, textures : albedo, metallic, roughness, envmap, irradiance
+    RENDER_SHADER_WATER,    // Textures : envmap, irradiance
+    RENDER_SHADER_SKYBOX,   // Textures : envmap. Gets the view without its translation.
+    RENDER_SHADER_COUNT
+};
+
+enum render_mesh_id
+{
+    RENDER_MESH_CUBE,
+    RENDER_MESH_SPHERE,
+    RENDER_MESH_PLANE,
+    RENDER_MESH_SKYBOX,     // Inside-out cube
+    RENDER_MESH_WATER,      // Ocean patch, updated by the platform each frame
+    RENDER_MESH_COUNT
+};
+
+enum render_texture_id
+{
+    RENDER_TEXTURE_NONE,    // Leaves the unit as it is
+    RENDER_TEXTURE_CRATE,
+    RENDER_TEXTURE_DEFAULT,
+    RENDER_TEXTURE_ENVMAP,
+    RENDER_TEXTURE_IRRADIANCE,
+    RENDER_TEXTURE_COUNT
+};
+
+// NOTE - Also the order the passes are drawn in
+enum render_pass
+{
+    RENDER_PASS_SETUP,
+    RENDER_PASS_OPAQUE,     // Front to back
+    RENDER_PASS_WATER,      // No culling
+    RENDER_PASS_SKY,        // Last, only where nothing was drawn
+    RENDER_PASS_COUNT
+};
+
+enum render_command_type
+{
+    RENDER_CMD_SET_CAMERA,
+    RENDER_CMD_SET_LIGHT,
+    RENDER_CMD_SET_MATERIAL,
+    RENDER_CMD_DRAW_MESH
+};
+
+struct render_cmd_set_camera
+{
+    mat4f ViewMatrix;
+    vec3f Position;
+};
+
+struct render_cmd_set_light
+{
+    vec3f Direction;    // Towards the light
+    vec4f Color;
+};
+
+// NOTE - Materials only live for the frame they're set in
+struct render_cmd_set_material
+{
+    uint32 Material;
+    uint32 Shader;
+    uint32 Textures[RENDER_MAX_TEXTURE_UNITS];
+    vec3f  AlbedoMult;
+    real32 MetallicMult;
+    real32 RoughnessMult;
+};
+
+struct render_cmd_draw_mesh
+{
+    uint32 Mesh;
+    uint32 Material;
+    mat4f  ModelMatrix;
+};
+
+struct render_command_header
+{
+    uint32 Type;
+    uint32 _Pad;
+};
+
+struct render_sort_entry
+{
+    uint64 Key;
+    uint32 Offset;      // Of the render_command_header, in the command data
+    uint32 _Pad;
+};
+
+struct render_commands
+{
+    uint8 *Data;
+    uint32 DataCapacity;
+    int32 volatile DataSize;
+
+    render_sort_entry *Entries;
+    uint32 EntryCapacity;
+    int32 volatile EntryCount;
+
+    int32 volatile DroppedCount;    // Pushed while full
+    real32 Time;                    // Seconds, for animated shaders
+    mat4f ProjMatrix;               // Set by the platform, for the game's own culling
+};
+
+inline uint64 RenderSortKey(uint32 Pass, uint32 Shader, uint32 Material, uint32 Depth)
+{
+    return ((uint64)(Pass & 0xF) << 60) |
+           ((uint64)(Shader & 0x3F) << 54) |
+           ((uint64)(Material & 0xFFFF) << 38) |
+           ((uint64)(Depth & 0xFFFFFF) << 14);
+}
+
+// NOTE - 24 bits of view distance. Set BackToFront for blended passes.
+inline uint32 RenderDepthKey(real32 Distance, bool BackToFront = false)
+{
+    real32 t = Clamp(Distance / RENDER_DEPTH_RANGE, 0.f, 1.f);
+    uint32 Depth = (uint32)(t * (real32)0xFFFFFF);
+    return BackToFront ? (0xFFFFFF - Depth) : Depth;
+}
+
+// NOTE - Returns NULL when the buffer is full, the command is then just dropped.
+inline void *_PushRenderCommand(render_commands *Commands, uint64 Key, uint32 Type, uint32 Size)
+{
+    uint32 TotalSize = (sizeof(render_command_header) + Size + 7) & ~7;
+
+    int32 Entry = AtomicAdd32(&Commands->EntryCount, 1) - 1;
+    int32 Offset = AtomicAdd32(&Commands->DataSize, (int32)TotalSize) - (int32)TotalSize;
+    if((uint32)Entry >= Commands->EntryCapacity || (uint32)Offset + TotalSize > Commands->DataCapacity)
+    {
+        // NOTE - The entry slot might be taken : it's marked as a no-op for the platform
+        if((uint32)Entry < Commands->EntryCapacity)
+        {
+            Commands->Entries[Entry].Key = ~0ULL;
+            Commands->Entries[Entry].Offset = 0xFFFFFFFF;
+        }
+        AtomicAdd32(&Commands->DroppedCount, 1);
+        return NULL;
+    }
+
+    render_command_header *Header = (render_command_header*)(Commands->Data + Offset);
+    Header->Type = Type;
+    Commands->Entries[Entry].Key = Key;
+    Commands->Entries[Entry].Offset = (uint32)Offset;
+    return Header + 1;
+}
+
+#define PushRenderCommand(Commands, Key, Type, Struct) (Struct*)_PushRenderCommand((Commands), (Key), (Type), sizeof(Struct))
+
+inline void PushRenderCamera(render_commands *Commands, mat4f const &ViewMatrix, vec3f Position)
+{
+    render_cmd_set_camera *Cmd = PushRenderCommand(Commands, RenderSortKey(RENDER_PASS_SETUP, 0, 0, 0),
+                                                   RENDER_CMD_SET_CAMERA, render_cmd_set_camera);
+    if(Cmd)
+    {
+        Cmd->ViewMatrix = ViewMatrix;
+        Cmd->Position = Position;
+    }
+}
+
+inline void PushRenderLight(render_commands *Commands, vec3f Direction, vec4f Color)
+{
+    render_cmd_set_light *Cmd = PushRenderCommand(Commands, RenderSortKey(RENDER_PASS_SETUP, 0, 0, 0),
+                                                  RENDER_CMD_SET_LIGHT, render_cmd_set_light);
+    if(Cmd)
+    {
+        Cmd->Direction = Direction;
+        Cmd->Color = Color;
+    }
+}
+
+// NOTE - Returns the command to fill the textures and parameters in, if any
+inline render_cmd_set_material *PushRenderMaterial(render_commands *Commands, uint32 Material, uint32 Shader)
+{
+    Assert(Material < RENDER_MAX_MATERIALS);
+    render_cmd_set_material *Cmd = PushRenderCommand(Commands, RenderSortKey(RENDER_PASS_SETUP, 0, 0, 0),
+                                                     RENDER_CMD_SET_MATERIAL, render_cmd_set_material);
+    if(Cmd)
+    {
+        render_cmd_set_material Zero = {};
+        *Cmd = Zero;
+        Cmd->Material = Material;
+        Cmd->Shader = Shader;
+        Cmd->AlbedoMult = vec3f(1.f);
+        Cmd->MetallicMult = 1.f;
+        Cmd->RoughnessMult = 1.f;
+    }
+    return Cmd;
+}
+
+// NOTE - Shader must be the one of the material, it's only there to sort by
+inline void PushRenderMesh(render_commands *Commands, uint32 Pass, uint32 Shader, uint32 Material,
+                           uint32 Mesh, mat4f const &ModelMatrix, uint32 Depth)
+{
+    render_cmd_draw_mesh *Cmd = PushRenderCommand(Commands, RenderSortKey(Pass, Shader, Material, Depth),
+                                                  RENDER_CMD_DRAW_MESH, render_cmd_draw_mesh);
+    if(Cmd)
+    {
+        Cmd->Mesh = Mesh;
+        Cmd->Material = Material;
+        Cmd->ModelMatrix = ModelMatrix;
+    }
+}
+
+#endif
@@ -0,0 +1,221 @@
+#ifndef SNAPSHOT_CPP
+#define SNAPSHOT_CPP
+
+// NOTE - Savegame snapshots of the PermanentMemPool.
+// The pool is written as a raw image and loaded back at the same address, so
+// there is no per-entity serialization : save/load cost only depends on the
+// pool size. This relies on the pool layout :
+//   [game_system] : only pointers to Session memory. Never restored from disk,
+//                   the live ones are patched back after a load.
+//   [game_state ] : must stay pointer-free (values, indices, handles only).
+#define SNAPSHOT_MAGIC 0x504E5352 // 'RSNP'
+#define SNAPSHOT_VERSION 1
+
+struct snapshot_header
+{
+    uint32 Magic;
+    uint32 Version;
+    uint64 PoolSize;
+    uint64 SystemSize;
+    uint64 StateSize;
+};
+
+snapshot_header MakeSnapshotHeader(game_memory *Memory)
+{
+    // NOTE - A snapshot is only loadable by a build with the exact same layout
+    snapshot_header Header = {};
+    Header.Magic = SNAPSHOT_MAGIC;
+    Header.Version = SNAPSHOT_VERSION;
+    Header.PoolSize = Memory->PermanentMemPoolSize;
+    Header.SystemSize = sizeof(game_system);
+    Header.StateSize = sizeof(game_state);
+    return Header;
+}
+
+bool SaveGameSnapshot(game_memory *Memory, char *Filename)
+{
+    snapshot_header Header = MakeSnapshotHeader(Memory);
+    return PlatformWriteSnapshot(Filename, &Header, sizeof(Header), Memory->PermanentMemPool, Memory->PermanentMemPoolSize);
+}
+
+bool LoadGameSnapshot(game_memory *Memory, char *Filename)
+{
+    game_system LiveSystem = *(game_system*)Memory->PermanentMemPool;
+
+    snapshot_header Header = MakeSnapshotHeader(Memory);
+    bool Loaded = PlatformReadSnapshot(Filename, &Header, sizeof(Header), Memory->PermanentMemPool, Memory->PermanentMemPoolSize);
+
+    // NOTE - Patch back the Session pointers, whatever the outcome of the load
+    *(game_system*)Memory->PermanentMemPool = LiveSystem;
+
+    return Loaded;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// NOTE - Looped input recording/playback
+// Recording takes a snapshot of the PermanentMemPool, then appends each frame's
+// game_input to a stream. Playback restores the snapshot and feeds the recorded
+// inputs back, dTime included, so GameUpdate and everything downstream replay
+// the exact same frames as fast as the platform can go. Reaching the end of the
+// stream restores the snapshot again and loops.
+///////////////////////////////////////////////////////////////////////////
+enum replay_mode
+{
+    REPLAY_IDLE,
+    REPLAY_RECORDING,
+    REPLAY_PLAYING
+};
+
+struct input_replay
+{
+    replay_mode Mode;
+    path SnapshotPath;
+    path InputPath;
+    FILE *InputFile;
+
+    uint32 FrameCount;      // Frames recorded, or played in the current loop
+    uint32 LoopCount;       // Completed playback loops
+    real64 LoopStartTime;
+    real64 LoopWorkTime;    // Sum of the recorded dTime of the current loop
+};
+
+void InitInputReplay(input_replay *Replay, char *ExecFullPath, char const *Name)
+{
+    *Replay = {};
+    int SnapshotLength = snprintf(Replay->SnapshotPath, MAX_PATH, "%s%s.rsnp", ExecFullPath, Name);
+    int InputLength = snprintf(Replay->InputPath, MAX_PATH, "%s%s.rinput", ExecFullPath, Name);
+    if(SnapshotLength >= MAX_PATH || InputLength >= MAX_PATH)
+    {
+        printf("Replay : path too long for %s, recording and playback will fail.\n", Name);
+    }
+}
+
+bool BeginInputRecording(input_replay *Replay, game_memory *Memory)
+{
+    Assert(Replay->Mode == REPLAY_IDLE);
+    if(!SaveGameSnapshot(Memory, Replay->SnapshotPath))
+    {
+        return false;
+    }
+
+    Replay->InputFile = fopen(Replay->InputPath, "wb");
+    if(!Replay->InputFile)
+    {
+        printf("Replay : can't open %s for writing.\n", Replay->InputPath);
+        return false;
+    }
+
+    // NOTE - Stream is only readable by a build with the same game_input layout
+    uint32 InputSize = sizeof(game_input);
+    fwrite(&InputSize, sizeof(InputSize), 1, Replay->InputFile);
+
+    Replay->Mode = REPLAY_RECORDING;
+    Replay->FrameCount = 0;
+    printf("Replay : recording to %s.\n", Replay->InputPath);
+    return true;
+}
+
+void RecordInput(input_replay *Replay, game_input *Input)
+{
+    Assert(Replay->Mode == REPLAY_RECORDING);
+    fwrite(Input, sizeof(game_input), 1, Replay->InputFile);
+    Replay->FrameCount++;
+}
+
+void EndInputRecording(input_replay *Replay)
+{
+    Assert(Replay->Mode == REPLAY_RECORDING);
+    fclose(Replay->InputFile);
+    Replay->InputFile = NULL;
+    Replay->Mode = REPLAY_IDLE;
+    printf("Replay : recorded %u frames.\n", Replay->FrameCount);
+}
+
+// NOTE - Restores the snapshot and rewinds the input stream to its first frame
+bool _RestartPlayback(input_replay *Replay, game_memory *Memory, real64 CurrentTime)
+{
+    uint32 InputSize = 0;
+    rewind(Replay->InputFile);
+    if(fread(&InputSize, sizeof(InputSize), 1, Replay->InputFile) != 1 || InputSize != sizeof(game_input))
+    {
+        printf("Replay : %s is not compatible with this build.\n", Replay->InputPath);
+        return false;
+    }
+
+    if(!LoadGameSnapshot(Memory, Replay->SnapshotPath))
+    {
+        return false;
+    }
+
+    Replay->FrameCount = 0;
+    Replay->LoopStartTime = CurrentTime;
+    Replay->LoopWorkTime = 0.0;
+    return true;
+}
+
+bool BeginInputPlayback(input_replay *Replay, game_memory *Memory, real64 CurrentTime)
+{
+    Assert(Replay->Mode == REPLAY_IDLE);
+    Replay->InputFile = fopen(Replay->InputPath, "rb");
+    if(!Replay->InputFile)
+    {
+        printf("Replay : can't open %s.\n", Replay->InputPath);
+        return false;
+    }
+
+    if(!_RestartPlayback(Replay, Memory, CurrentTime))
+    {
+        fclose(Replay->InputFile);
+        Replay->InputFile = NULL;
+        return false;
+    }
+
+    Replay->Mode = REPLAY_PLAYING;
+    Replay->LoopCount = 0;
+    printf("Replay : playing back %s.\n", Replay->InputPath);
+    return true;
+}
+
+void EndInputPlayback(input_replay *Replay)
+{
+    Assert(Replay->Mode == REPLAY_PLAYING);
+    fclose(Replay->InputFile);
+    Replay->InputFile = NULL;
+    Replay->Mode = REPLAY_IDLE;
+}
+
+// NOTE - Overwrites Input with the next recorded frame. Returns true when a loop
+// was just completed (the snapshot has been restored for the next one).
+bool PlaybackInput(input_replay *Replay, game_memory *Memory, game_input *Input, real64 CurrentTime)
+{
+    Assert(Replay->Mode == REPLAY_PLAYING);
+
+    bool LoopDone = false;
+    if(fread(Input, sizeof(game_input), 1, Replay->InputFile) != 1)
+    {
+        real64 LoopTime = CurrentTime - Replay->LoopStartTime;
+        if(Replay->FrameCount > 0)
+        {
+            printf("Replay : loop %u, %u frames in %.3fs (%.3fms/frame, recorded %.3fs).\n",
+                    Replay->LoopCount, Replay->FrameCount, LoopTime,
+                    1000.0 * LoopTime / Replay->FrameCount, Replay->LoopWorkTime);
+        }
+
+        Replay->LoopCount++;
+        LoopDone = true;
+        if(!_RestartPlayback(Replay, Memory, CurrentTime) ||
+           fread(Input, sizeof(game_input), 1, Replay->InputFile) != 1)
+        {
+            printf("Replay : empty or broken input stream, stopping.\n");
+            EndInputPlayback(Replay);
+            memset((void*)Input, 0, sizeof(game_input));
+            return LoopDone;
+        }
+    }
+
+    Replay->FrameCount++;
+    Replay->LoopWorkTime += Input->dTime;
+    return LoopDone;
+}
+
+#endif
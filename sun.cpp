@@ -1,5 +1,6 @@
 #include "sun.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
@@ -9,21 +10,54 @@
 const real32 EarthRadius = 6.3710088e6;
 const real32 SunDistance = 1.496e11;
 
+// NOTE - Material slots of the render commands, set each frame
+enum sun_material
+{
+    MATERIAL_CRATE,
+    MATERIAL_WATER,
+    MATERIAL_SKYBOX,
+    MATERIAL_SPHERES,   // One per sphere of the PBR grid
+};
+
+#define SPHERE_GRID_SIZE 5
+#define CUBE_COUNT 5
+#define WATER_TILE_REPEAT 5
+#define WATER_WAVE_HEIGHT 10.f  // Generous bound of the waves in the unscaled tile, for its box
+#define PICK_DISTANCE 1000.f
+#define PICK_TEXT_DURATION 3.0  // Seconds the last pick stays on screen
+
+// NOTE - What the leaves of the scene tree refer to : the kind of object in the
+// high bits, its index in the low ones
+enum scene_object_kind
+{
+    SCENE_CUBE,
+    SCENE_PLANE,
+    SCENE_SPHERE,
+    SCENE_WATER,
+};
+
+char const *SceneObjectNames[] = { "Cube", "Plane", "Sphere", "Water tile" };
+
+#define SCENE_OBJECT(Kind, Index) (((uint32)(Kind) << 16) | (uint32)(Index))
+#define SCENE_OBJECT_KIND(Object) ((Object) >> 16)
+#define SCENE_OBJECT_INDEX(Object) ((Object) & 0xFFFF)
+
 // NOTE - Storage for game data local to the Sun DLL
 // This is pushed on the Session stack of the engine
 struct sun_storage
 {
     real64 Counter;
-    bool IsNight;
-	// DayPhase: 0 = noon, pi = midnight
-	real32 DayPhase;
-	// Varies with season
-	real32 EarthTilt;
-	// Latitude: -pi/2 = South pole, +pi/2 = North pole
-	real32 Latitude;
-
-    ui_text_line FPSText;
-    ui_text_line WaterText;
+
+    // NOTE - ui_text_line in System->UITextLines. The pick line only exists while shown.
+    pool_handle FPSText;
+    pool_handle WaterText;
+    pool_handle PickText;
+    real64 PickTextTimer;
+
+    // NOTE - Every drawable object, the ones that move are refit each frame
+    bvh SceneTree;
+    int32 CubeProxies[CUBE_COUNT];
+    int32 WaterProxies[WATER_TILE_REPEAT * WATER_TILE_REPEAT];
 };
 
 void LogString(console_log *Log, char const *String)
@@ -90,6 +124,91 @@ void InitCamera(game_camera *Camera, game_memory *Memory)
 
 
 
+// NOTE - Tiles of the ocean patch around the origin, they grow with the sea state.
+// Also returns the unrotated position of the tile and half its width.
+mat4f WaterTileMatrix(game_state *State, water_system *WaterSystem, int i, int j, vec3f *Position, real32 *HalfWidth)
+{
+    water_beaufort_state *WaterStateA = &WaterSystem->States[State->WaterState];
+    water_beaufort_state *WaterStateB = &WaterSystem->States[State->WaterState + 1];
+    real32 dWidth = Mix((real32)WaterStateA->Width, (real32)WaterStateB->Width, State->WaterStateInterp);
+    real32 Interp = (State->WaterState+1) + State->WaterStateInterp;
+
+    mat4f RotationMatrix;
+    RotationMatrix.FromAxisAngle(vec3f(0, State->WaterDirection, 0));
+
+    int Middle = (WATER_TILE_REPEAT-1)/2;
+    real32 PositionScale = dWidth * (Interp);
+    *Position = vec3f(PositionScale * (Middle-i), 0.f, PositionScale * (Middle-j));
+    *HalfWidth = 0.5f * PositionScale;
+
+    mat4f ModelMatrix;
+    ModelMatrix.FromTRS(*Position, vec3f(0), vec3f(Interp, Interp, Interp));
+    return RotationMatrix * ModelMatrix;
+}
+
+// NOTE - Static objects go in once, the others get a box in UpdateSceneTree
+void InitSceneTree(sun_storage *Local, game_memory *Memory)
+{
+    bvh *Tree = &Local->SceneTree;
+    InitBVH(Tree, &Memory->SessionArena, 64);
+
+    real32 hW = RENDER_PLANE_WIDTH/2.f;
+    BVHInsert(Tree, vec3f(-hW, -7.f, -hW), vec3f(hW, -7.f, hW), SCENE_OBJECT(SCENE_PLANE, 0));
+
+    for(int j = 0; j < SPHERE_GRID_SIZE; ++j)
+    {
+        for(int i = 0; i < SPHERE_GRID_SIZE; ++i)
+        {
+            vec3f Position(0, 3*(j+1), 3*(i+1));
+            BVHInsert(Tree, Position - vec3f(1.f), Position + vec3f(1.f), SCENE_OBJECT(SCENE_SPHERE, j * SPHERE_GRID_SIZE + i));
+        }
+    }
+
+    for(uint32 i = 0; i < CUBE_COUNT; ++i)
+    {
+        Local->CubeProxies[i] = BVHInsert(Tree, vec3f(0.f), vec3f(0.f), SCENE_OBJECT(SCENE_CUBE, i));
+    }
+    for(uint32 i = 0; i < WATER_TILE_REPEAT * WATER_TILE_REPEAT; ++i)
+    {
+        Local->WaterProxies[i] = BVHInsert(Tree, vec3f(0.f), vec3f(0.f), SCENE_OBJECT(SCENE_WATER, i));
+    }
+}
+
+// NOTE - Cheap when nothing left its fat box. The cubes are refit too since a
+// snapshot load can move them.
+void UpdateSceneTree(sun_storage *Local, game_state *State, game_system *System)
+{
+    bvh *Tree = &Local->SceneTree;
+
+    // NOTE - Unit cubes, whatever their rotation
+    real32 const CubeRadius = 1.7321f;
+    for(uint32 i = 0; i < CUBE_COUNT; ++i)
+    {
+        vec3f P = State->CubePositions[i];
+        BVHMove(Tree, Local->CubeProxies[i], P - vec3f(CubeRadius), P + vec3f(CubeRadius));
+    }
+
+    water_system *WaterSystem = System->WaterSystem;
+    if(WaterSystem)
+    {
+        for(int j = 0; j < WATER_TILE_REPEAT; ++j)
+        {
+            for(int i = 0; i < WATER_TILE_REPEAT; ++i)
+            {
+                vec3f Position;
+                real32 HalfWidth;
+                mat4f ModelMatrix = WaterTileMatrix(State, WaterSystem, i, j, &Position, &HalfWidth);
+
+                // NOTE - Rotated around Y : the diagonal bounds the tile in any direction.
+                // The rotation leaves the Y axis alone, M[1].y is the tile's scale.
+                vec3f Center(ModelMatrix.M[3].x, ModelMatrix.M[3].y, ModelMatrix.M[3].z);
+                vec3f Extent(HalfWidth * 1.4143f, WATER_WAVE_HEIGHT * ModelMatrix.M[1].y, HalfWidth * 1.4143f);
+                BVHMove(Tree, Local->WaterProxies[j * WATER_TILE_REPEAT + i], Center - Extent, Center + Extent);
+            }
+        }
+    }
+}
+
 void GameInitialization(game_memory *Memory)
 {
     game_system *System = (game_system*)Memory->PermanentMemPool;
@@ -99,6 +218,11 @@ void GameInitialization(game_memory *Memory)
     sun_storage *Local = (sun_storage*)System->DLLStorage;
     Local->Counter = 0.0;
 
+    Local->FPSText = PoolAlloc(System->UITextLines);
+    Local->WaterText = PoolAlloc(System->UITextLines);
+    Local->PickText = InvalidPoolHandle();
+    Local->PickTextTimer = 0.0;
+
     FillAudioBuffer(System->SoundData);
     System->SoundData->ReloadSoundBuffer = true;
 
@@ -106,11 +230,12 @@ void GameInitialization(game_memory *Memory)
     State->PlayerPosition = vec3f(300, 300, 0);
 
     InitCamera(&State->Camera, Memory);
+    State->Camera.PreviousPosition = State->Camera.Position;
 	
 	// Bretagne, France
-	Local->Latitude = deg2rad(48.2020f);
+	State->Latitude = deg2rad(48.2020f);
 	// Summer solstice
-	Local->EarthTilt = deg2rad(23.43f);
+	State->EarthTilt = deg2rad(23.43f);
 
     // TODO - Pack Sun color and direction from envmaps
 #if 1
@@ -145,33 +270,32 @@ void GameInitialization(game_memory *Memory)
     State->WaterState = 1;
     State->WaterDirection = 0.f;
 
+    real32 Dim = 20.0f;
+    vec3f LowDim = -Dim/2;
+    for(uint32 i = 0; i < CUBE_COUNT; ++i)
+    {
+        State->CubePositions[i] = LowDim + vec3f(Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX, Dim*rand()/(real32)RAND_MAX);
+        State->CubeRotations[i] = vec3f(2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX, 2.f*M_PI*rand()/(real32)RAND_MAX);
+    }
+
+    InitSceneTree(Local, Memory);
+
     Memory->IsInitialized = false;
     Memory->IsGameInitialized = true;
 }
 
-void MovePlayer(game_state *State, game_input *Input)
+// NOTE - Per-frame camera controls : key/button edges and mouse offsets only
+// exist in the frame they happen in, whatever the number of fixed steps.
+void UpdateCameraControls(game_state *State, game_input *Input)
 {
     game_camera &Camera = State->Camera;
     vec2i MousePos = vec2i(Input->MousePosX, Input->MousePosY);
 
-    vec3f CameraMove(0, 0, 0);
-    if(KEY_DOWN(Input->KeyW)) CameraMove += Camera.Forward;
-    if(KEY_DOWN(Input->KeyS)) CameraMove -= Camera.Forward;
-    if(KEY_DOWN(Input->KeyA)) CameraMove -= Camera.Right;
-    if(KEY_DOWN(Input->KeyD)) CameraMove += Camera.Right;
-    if(KEY_DOWN(Input->KeyR)) CameraMove += Camera.Up;
-    if(KEY_DOWN(Input->KeyF)) CameraMove -= Camera.Up;
-
     if(KEY_HIT(Input->KeyLShift))      Camera.SpeedMode += 1;
     else if(KEY_UP(Input->KeyLShift))  Camera.SpeedMode -= 1;
     if(KEY_HIT(Input->KeyLCtrl))       Camera.SpeedMode -= 1;
     else if(KEY_UP(Input->KeyLCtrl))   Camera.SpeedMode += 1;
 
-    Normalize(CameraMove);
-    real32 SpeedMult = Camera.SpeedMode ? (Camera.SpeedMode > 0 ? Camera.SpeedMult : 1.0f / Camera.SpeedMult) : 1.0f;
-    CameraMove *= (real32)(Input->dTime * Camera.LinearSpeed * SpeedMult);
-    Camera.Position += CameraMove;
-
     if(MOUSE_HIT(Input->MouseRight))
     {
         Camera.FreeflyMode = true;
@@ -205,8 +329,6 @@ void MovePlayer(game_state *State, game_input *Input)
         }
     }
 
-    Camera.Target = Camera.Position + Camera.Forward;
-
     vec3f Move;
     Move.x = (real32)Input->MousePosX;
     Move.y = (real32)(540-Input->MousePosY);
@@ -219,37 +341,331 @@ void MovePlayer(game_state *State, game_input *Input)
     State->PlayerPosition = Move;
 }
 
-void UpdateSky(sun_storage *Local, game_state *State, game_system *System, game_input *Input)
+// NOTE - Teleports, without interpolating from the last position
+void PlaceCamera(game_camera *Camera, vec3f Position, vec3f Target)
+{
+    Camera->Position = Position;
+    Camera->PreviousPosition = Position;
+    Camera->Forward = Normalize(Target - Position);
+    Camera->Right = Normalize(Cross(Camera->Forward, vec3f(0, 1, 0)));
+    Camera->Up = Normalize(Cross(Camera->Right, Camera->Forward));
+
+    vec2f Spherical = CartesianToSpherical(Camera->Forward);
+    Camera->Theta = Spherical.x;
+    Camera->Phi = Spherical.y;
+}
+
+// NOTE - Fixed step
+void MovePlayer(game_state *State, game_input *Input, real32 dT)
+{
+    game_camera &Camera = State->Camera;
+
+    vec3f CameraMove(0, 0, 0);
+    if(KEY_DOWN(Input->KeyW)) CameraMove += Camera.Forward;
+    if(KEY_DOWN(Input->KeyS)) CameraMove -= Camera.Forward;
+    if(KEY_DOWN(Input->KeyA)) CameraMove -= Camera.Right;
+    if(KEY_DOWN(Input->KeyD)) CameraMove += Camera.Right;
+    if(KEY_DOWN(Input->KeyR)) CameraMove += Camera.Up;
+    if(KEY_DOWN(Input->KeyF)) CameraMove -= Camera.Up;
+
+    Normalize(CameraMove);
+    real32 SpeedMult = Camera.SpeedMode ? (Camera.SpeedMode > 0 ? Camera.SpeedMult : 1.0f / Camera.SpeedMult) : 1.0f;
+    CameraMove *= dT * Camera.LinearSpeed * SpeedMult;
+
+    Camera.PreviousPosition = Camera.Position;
+    Camera.Position += CameraMove;
+}
+
+// NOTE - Fixed step
+void UpdateWaterControls(game_state *State, game_input *Input, real32 dT)
+{
+    if(KEY_DOWN(Input->KeyNumPlus))
+    {
+        State->WaterStateInterp = State->WaterStateInterp + 0.01;
+
+        if(State->WaterState < (water_system::BeaufortStateCount - 2))
+        {
+            if(State->WaterStateInterp >= 1.f)
+            {
+                State->WaterStateInterp -= 1.f;
+                ++State->WaterState;
+            }
+        }
+        else
+        {
+            State->WaterStateInterp = Min(1.f, State->WaterStateInterp);
+        }
+    }
+
+    if(KEY_DOWN(Input->KeyNumMinus))
+    {
+        State->WaterStateInterp = State->WaterStateInterp - 0.01;
+
+        if(State->WaterState > 0)
+        {
+            if(State->WaterStateInterp < 0.f)
+            {
+                State->WaterStateInterp += 1.f;
+                --State->WaterState;
+            }
+        }
+        else
+        {
+            State->WaterStateInterp = Max(0.f, State->WaterStateInterp);
+        }
+    }
+
+    if(KEY_DOWN(Input->KeyNumMultiply))
+    {
+        State->WaterDirection += dT * 0.05;
+    }
+
+    if(KEY_DOWN(Input->KeyNumDivide))
+    {
+        State->WaterDirection -= dT * 0.05;
+    }
+}
+
+// NOTE - Fixed step
+void UpdateSky(game_state *State, game_system *System, real32 dT)
 {
-	Local->DayPhase = fmod(Local->DayPhase + 0.2f * M_PI * Input->dTime, 2.f * M_PI);
+	State->DayPhase = fmod(State->DayPhase + 0.2f * M_PI * dT, 2.f * M_PI);
 
 
-	real32 CosET = cosf(Local->EarthTilt);
+	real32 CosET = cosf(State->EarthTilt);
 	
-	vec3f SunPos(SunDistance * CosET * cosf(Local->DayPhase) - EarthRadius * cosf(Local->Latitude),
-				 SunDistance * sinf(Local->EarthTilt) - EarthRadius * sinf(Local->Latitude),
-				 SunDistance * CosET * sinf(Local->DayPhase));
+	vec3f SunPos(SunDistance * CosET * cosf(State->DayPhase) - EarthRadius * cosf(State->Latitude),
+				 SunDistance * sinf(State->EarthTilt) - EarthRadius * sinf(State->Latitude),
+				 SunDistance * CosET * sinf(State->DayPhase));
 	mat4f Rot;
-	Rot = Rot.RotateZ(M_PI_OVER_TWO - Local->Latitude);
+	Rot = Rot.RotateZ(M_PI_OVER_TWO - State->Latitude);
 	SunPos = Rot * SunPos;
 	
 	console_log_string Msg;
 	//snprintf(Msg, CONSOLE_STRINGLEN, "%e %e %e", Rot[1][1], SunPos.y, SunPos.z); 
 	//LogString(System->ConsoleLog, Msg);
 
-	if(Local->IsNight && SunPos.y > 0.f) {
-		Local->IsNight = false;
+	if(State->IsNight && SunPos.y > 0.f) {
+		State->IsNight = false;
 		snprintf(Msg, CONSOLE_STRINGLEN, "Day");
 		LogString(System->ConsoleLog, Msg);
 	}
-	if(!Local->IsNight && SunPos.y < 0.f) {
-		Local->IsNight = true;
+	if(!State->IsNight && SunPos.y < 0.f) {
+		State->IsNight = true;
 		snprintf(Msg, CONSOLE_STRINGLEN, "Night");
 		LogString(System->ConsoleLog, Msg);
 	}
 	State->LightDirection = Normalize(SunPos);
 }
 
+void PushMaterials(render_commands *Commands)
+{
+    render_cmd_set_material *Material = PushRenderMaterial(Commands, MATERIAL_CRATE, RENDER_SHADER_MESH);
+    if(Material)
+    {
+        Material->Textures[0] = RENDER_TEXTURE_CRATE;
+        Material->Textures[1] = RENDER_TEXTURE_DEFAULT;
+        Material->Textures[2] = RENDER_TEXTURE_DEFAULT;
+        Material->Textures[3] = RENDER_TEXTURE_ENVMAP;
+        Material->Textures[4] = RENDER_TEXTURE_IRRADIANCE;
+    }
+
+    for(int j = 0; j < SPHERE_GRID_SIZE; ++j)
+    {
+        for(int i = 0; i < SPHERE_GRID_SIZE; ++i)
+        {
+            Material = PushRenderMaterial(Commands, MATERIAL_SPHERES + j * SPHERE_GRID_SIZE + i, RENDER_SHADER_MESH);
+            if(Material)
+            {
+                Material->Textures[0] = RENDER_TEXTURE_DEFAULT;
+                Material->Textures[1] = RENDER_TEXTURE_DEFAULT;
+                Material->Textures[2] = RENDER_TEXTURE_DEFAULT;
+                Material->Textures[3] = RENDER_TEXTURE_ENVMAP;
+                Material->Textures[4] = RENDER_TEXTURE_IRRADIANCE;
+                Material->MetallicMult = (j+1)/(real32)SPHERE_GRID_SIZE;
+                Material->RoughnessMult = (i+1)/(real32)SPHERE_GRID_SIZE;
+            }
+        }
+    }
+
+    Material = PushRenderMaterial(Commands, MATERIAL_WATER, RENDER_SHADER_WATER);
+    if(Material)
+    {
+        Material->Textures[0] = RENDER_TEXTURE_ENVMAP;
+        Material->Textures[1] = RENDER_TEXTURE_IRRADIANCE;
+    }
+
+    Material = PushRenderMaterial(Commands, MATERIAL_SKYBOX, RENDER_SHADER_SKYBOX);
+    if(Material)
+    {
+        Material->Textures[0] = RENDER_TEXTURE_ENVMAP;
+    }
+}
+
+// NOTE - The scene, as render commands for the platform to sort and draw. Only
+// the objects the scene tree finds in the view are pushed.
+void PushSceneRenderCommands(sun_storage *Local, game_state *State, game_system *System, game_input *Input,
+                             memory_arena *Scratch)
+{
+    render_commands *Commands = System->RenderCommands;
+    Commands->Time = (real32)State->EngineTime;
+
+    // NOTE - Render the camera in between the last two simulated steps
+    game_camera &Camera = State->Camera;
+    vec3f CameraPosition = Mix(Camera.PreviousPosition, Camera.Position, Input->Alpha);
+    mat4f ViewMatrix = mat4f::LookAt(CameraPosition, CameraPosition + Camera.Forward, Camera.Up);
+
+    PushRenderCamera(Commands, ViewMatrix, CameraPosition);
+    PushRenderLight(Commands, State->LightDirection, State->LightColor);
+    PushMaterials(Commands);
+
+    bvh *Tree = &Local->SceneTree;
+    frustum Frustum = MakeFrustum(Commands->ProjMatrix * ViewMatrix);
+    uint32 *Visible = (uint32*)PushArenaData(Scratch, Max(Tree->LeafCount, 1u) * sizeof(uint32));
+    uint32 VisibleCount = BVHQueryFrustum(Tree, &Frustum, Visible, Tree->LeafCount);
+
+    water_system *WaterSystem = System->WaterSystem;
+    mat4f ModelMatrix;
+    for(uint32 v = 0; v < VisibleCount; ++v)
+    {
+        uint32 Index = SCENE_OBJECT_INDEX(Visible[v]);
+        switch(SCENE_OBJECT_KIND(Visible[v]))
+        {
+            case SCENE_CUBE:
+            {
+                ModelMatrix.FromTRS(State->CubePositions[Index], State->CubeRotations[Index], vec3f(1.f));
+                PushRenderMesh(Commands, RENDER_PASS_OPAQUE, RENDER_SHADER_MESH, MATERIAL_CRATE, RENDER_MESH_CUBE, ModelMatrix,
+                               RenderDepthKey(Length(State->CubePositions[Index] - CameraPosition)));
+            } break;
+            case SCENE_PLANE:
+            {
+                real32 hW = RENDER_PLANE_WIDTH/2.f;
+                ModelMatrix.FromTRS(vec3f(-hW, -7.f, -hW), vec3f(0), vec3f(1));
+                PushRenderMesh(Commands, RENDER_PASS_OPAQUE, RENDER_SHADER_MESH, MATERIAL_CRATE, RENDER_MESH_PLANE, ModelMatrix,
+                               RenderDepthKey(Length(vec3f(0.f, -7.f, 0.f) - CameraPosition)));
+            } break;
+            case SCENE_SPHERE:
+            {
+                uint32 i = Index % SPHERE_GRID_SIZE, j = Index / SPHERE_GRID_SIZE;
+                vec3f Position(0, 3*(j+1), 3*(i+1));
+                ModelMatrix.FromTRS(Position, vec3f(0.f), vec3f(1.f));
+                PushRenderMesh(Commands, RENDER_PASS_OPAQUE, RENDER_SHADER_MESH, MATERIAL_SPHERES + Index,
+                               RENDER_MESH_SPHERE, ModelMatrix, RenderDepthKey(Length(Position - CameraPosition)));
+            } break;
+            case SCENE_WATER:
+            {
+                if(WaterSystem)
+                {
+                    vec3f Position;
+                    real32 HalfWidth;
+                    ModelMatrix = WaterTileMatrix(State, WaterSystem, Index % WATER_TILE_REPEAT, Index / WATER_TILE_REPEAT,
+                                                  &Position, &HalfWidth);
+                    PushRenderMesh(Commands, RENDER_PASS_WATER, RENDER_SHADER_WATER, MATERIAL_WATER, RENDER_MESH_WATER, ModelMatrix,
+                                   RenderDepthKey(Length(Position - CameraPosition)));
+                }
+            } break;
+        }
+    }
+
+    PushRenderMesh(Commands, RENDER_PASS_SKY, RENDER_SHADER_SKYBOX, MATERIAL_SKYBOX, RENDER_MESH_SKYBOX, mat4f(), 0);
+}
+
+// NOTE - Slab test against the box, in the ray's space
+static real32 RayBoxDistance(vec3f Origin, vec3f Direction, vec3f BoxMin, vec3f BoxMax, real32 MaxDistance)
+{
+    real32 Enter = 0.f, Exit = MaxDistance;
+    for(int a = 0; a < 3; ++a)
+    {
+        real32 D = Direction[a];
+        real32 InvD = 1.f / ((D >= 0.f) ? Max(D, 1e-12f) : Min(D, -1e-12f));
+        real32 T0 = (BoxMin[a] - Origin[a]) * InvD;
+        real32 T1 = (BoxMax[a] - Origin[a]) * InvD;
+        Enter = Max(Enter, Min(T0, T1));
+        Exit = Min(Exit, Max(T0, T1));
+    }
+    return (Enter <= Exit) ? Enter : -1.f;
+}
+
+// NOTE - bvh_ray_test of the scene objects. The water isn't pickable : its box
+// holds the highest waves, it would hide everything seen across it.
+static real32 PickTestSceneObject(void *Data, uint32 Object, vec3f Origin, vec3f Direction, real32 MaxDistance)
+{
+    game_state *State = (game_state*)Data;
+    uint32 Index = SCENE_OBJECT_INDEX(Object);
+    switch(SCENE_OBJECT_KIND(Object))
+    {
+        case SCENE_CUBE:
+        {
+            // NOTE - In the cube's space, its rotation is its model matrix' 3x3
+            mat4f ModelMatrix;
+            ModelMatrix.FromTRS(State->CubePositions[Index], State->CubeRotations[Index], vec3f(1.f));
+            mat4f InvRotation = ModelMatrix.Transpose();
+            vec3f LocalOrigin = InvRotation * (Origin - State->CubePositions[Index]);
+            vec3f LocalDirection = InvRotation * Direction;
+            return RayBoxDistance(LocalOrigin, LocalDirection, vec3f(-1.f), vec3f(1.f), MaxDistance);
+        }
+        case SCENE_PLANE:
+        {
+            real32 hW = RENDER_PLANE_WIDTH/2.f;
+            return RayBoxDistance(Origin, Direction, vec3f(-hW, -7.f, -hW), vec3f(hW, -7.f, hW), MaxDistance);
+        }
+        case SCENE_SPHERE:
+        {
+            uint32 i = Index % SPHERE_GRID_SIZE, j = Index / SPHERE_GRID_SIZE;
+            vec3f ToCenter = vec3f(0, 3*(j+1), 3*(i+1)) - Origin;
+            real32 Along = Dot(ToCenter, Direction);
+            real32 Discriminant = Along * Along - Dot(ToCenter, ToCenter) + 1.f;
+            if(Discriminant < 0.f)
+            {
+                return -1.f;
+            }
+            real32 T = Max(Along - sqrtf(Discriminant), 0.f);
+            return (Along + sqrtf(Discriminant) >= 0.f && T <= MaxDistance) ? T : -1.f;
+        }
+        default:
+        {
+            return -1.f;
+        }
+    }
+}
+
+// NOTE - Logs the nearest object under the center of the screen, and shows it
+// for PICK_TEXT_DURATION
+void PickSceneObject(sun_storage *Local, game_state *State, game_system *System)
+{
+    game_camera &Camera = State->Camera;
+    real32 Distance;
+    int32 Proxy = BVHRayCast(&Local->SceneTree, Camera.Position, Camera.Forward, PICK_DISTANCE, &Distance,
+                             PickTestSceneObject, State);
+
+    char String[CONSOLE_STRINGLEN];
+    if(Proxy == BVH_NULL)
+    {
+        snprintf(String, CONSOLE_STRINGLEN, "Picked nothing");
+    }
+    else
+    {
+        uint32 Object = BVHUserData(&Local->SceneTree, Proxy);
+        snprintf(String, CONSOLE_STRINGLEN, "Picked %s %u at %.1fm", SceneObjectNames[SCENE_OBJECT_KIND(Object)],
+                 SCENE_OBJECT_INDEX(Object), Distance);
+    }
+    LogString(System->ConsoleLog, String);
+
+    ui_text_line *Line = PoolGetStruct(System->UITextLines, Local->PickText, ui_text_line);
+    if(!Line)
+    {
+        Local->PickText = PoolAlloc(System->UITextLines);
+        Line = PoolGetStruct(System->UITextLines, Local->PickText, ui_text_line);
+    }
+    if(Line)
+    {
+        snprintf(Line->String, UI_STRINGLEN, "%s", String);
+        Line->Position = vec3f(10, 528, 0);
+        Line->Color = vec4f(0.9, 0.7, 0.1, 1);
+    }
+    Local->PickTextTimer = PICK_TEXT_DURATION;
+}
+
 DLLEXPORT GAMEUPDATE(GameUpdate)
 {
     if(!Memory->IsGameInitialized)
@@ -273,69 +689,83 @@ DLLEXPORT GAMEUPDATE(GameUpdate)
     
     Local->Counter += Input->dTime; 
 
-    MovePlayer(State, Input);
-
-    if(KEY_DOWN(Input->KeyNumPlus))
+    if(Memory->ConfigChanged)
     {
-        State->WaterStateInterp = State->WaterStateInterp + 0.01;
-
-        if(State->WaterState < (water_system::BeaufortStateCount - 2))
-        {
-            if(State->WaterStateInterp >= 1.f)
-            {
-                State->WaterStateInterp -= 1.f;
-                ++State->WaterState;
-            }
-        }
-        else
-        {
-            State->WaterStateInterp = Min(1.f, State->WaterStateInterp);
-        }
+        game_camera &Camera = State->Camera;
+        Camera.LinearSpeed = Memory->Config.CameraSpeedBase;
+        Camera.AngularSpeed = Memory->Config.CameraSpeedAngular;
+        Camera.SpeedMult = Memory->Config.CameraSpeedMult;
+        Memory->ConfigChanged = false;
     }
 
-    if(KEY_DOWN(Input->KeyNumMinus))
-    {
-        State->WaterStateInterp = State->WaterStateInterp - 0.01;
+    UpdateCameraControls(State, Input);
 
-        if(State->WaterState > 0)
-        {
-            if(State->WaterStateInterp < 0.f)
-            {
-                State->WaterStateInterp += 1.f;
-                --State->WaterState;
-            }
-        }
-        else
-        {
-            State->WaterStateInterp = Max(0.f, State->WaterStateInterp);
-        }
+    // NOTE - Simulation runs at a fixed rate : the platform accumulates frame
+    // time and tells us how many steps are due this frame (possibly none).
+    real32 dT = (real32)Input->dTimeFixed;
+    for(uint32 Step = 0; Step < Input->FixedStepCount; ++Step)
+    {
+        MovePlayer(State, Input, dT);
+        UpdateWaterControls(State, Input, dT);
+        UpdateSky(State, System, dT);
     }
 
-    if(KEY_DOWN(Input->KeyNumMultiply))
+    if(Input->WaterOverride)
     {
-        State->WaterDirection += Input->dTime * 0.05;
+        State->WaterState = Clamp(Input->WaterState, 0, water_system::BeaufortStateCount - 2);
+        State->WaterStateInterp = Clamp(Input->WaterStateInterp, 0.f, 1.f);
     }
-
-    if(KEY_DOWN(Input->KeyNumDivide))
+    if(Input->DayPhaseOverride)
     {
-        State->WaterDirection -= Input->dTime * 0.05;
+        State->DayPhase = Input->DayPhase;
+        UpdateSky(State, System, 0.f);
     }
 
-    UpdateSky(Local, State, System, Input);
+    game_camera &Camera = State->Camera;
+    if(Input->CameraOverride)
+    {
+        PlaceCamera(&Camera, Input->CameraPosition, Input->CameraTarget);
+    }
+    Camera.Target = Camera.Position + Camera.Forward;
 
-    if(Local->Counter > 0.75)
+    ui_text_line *FPSText = PoolGetStruct(System->UITextLines, Local->FPSText, ui_text_line);
+    ui_text_line *WaterText = PoolGetStruct(System->UITextLines, Local->WaterText, ui_text_line);
+    if(Local->Counter > 0.75 && FPSText && WaterText)
     {
-        snprintf(Local->FPSText.String, UI_STRINGLEN, "%2.4g, Mouse: %d,%d", 1.0 / Input->dTime, Input->MousePosX, Input->MousePosY);
-        Local->FPSText.Position = vec3f(10, 500, 0);
-        Local->FPSText.Color = vec4f(0.9, 0.7, 0.1, 1);
+        snprintf(FPSText->String, UI_STRINGLEN, "%2.4g, Mouse: %d,%d", 1.0 / Input->dTime, Input->MousePosX, Input->MousePosY);
+        FPSText->Position = vec3f(10, 500, 0);
+        FPSText->Color = vec4f(0.9, 0.7, 0.1, 1);
 
-        snprintf(Local->WaterText.String, UI_STRINGLEN, "Water State : %d  Water Interpolant : %g", State->WaterState, State->WaterStateInterp);
-        Local->WaterText.Position = vec3f(10, 514, 0);
-        Local->WaterText.Color = vec4f(0.9, 0.7, 0.1, 1);
+        snprintf(WaterText->String, UI_STRINGLEN, "Water State : %d  Water Interpolant : %g", State->WaterState, State->WaterStateInterp);
+        WaterText->Position = vec3f(10, 514, 0);
+        WaterText->Color = vec4f(0.9, 0.7, 0.1, 1);
 
         Local->Counter = 0.0;
     }
 
-    UIStack->TextLines[UIStack->TextLineCount++] = Local->FPSText;
-    UIStack->TextLines[UIStack->TextLineCount++] = Local->WaterText;
+    uiPushTextLine(UIStack, Local->FPSText);
+    uiPushTextLine(UIStack, Local->WaterText);
+
+    // NOTE - The pick line goes back to the pool once it timed out
+    if(PoolIsValid(System->UITextLines, Local->PickText))
+    {
+        Local->PickTextTimer -= Input->dTime;
+        if(Local->PickTextTimer > 0.0)
+        {
+            uiPushTextLine(UIStack, Local->PickText);
+        }
+        else
+        {
+            PoolFree(System->UITextLines, Local->PickText);
+            Local->PickText = InvalidPoolHandle();
+        }
+    }
+
+    UpdateSceneTree(Local, State, System);
+    if(MOUSE_HIT(Input->MouseLeft) && !Camera.FreeflyMode)
+    {
+        PickSceneObject(Local, State, System);
+    }
+
+    PushSceneRenderCommands(Local, State, System, Input, &Memory->ScratchArena);
 }
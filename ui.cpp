@@ -24,8 +24,7 @@ ui_vertex UIVertex(vec3f const &Position, vec2f const &Texcoord)
 }
 
 game_context *uiContext;
-uint32 static uiProgram;
-uint32 static uiProjMatrixUniformLoc;
+shader_program static uiProgram;
 uint32 static uiColorUniformLoc;
 uint32 static uiVAO;
 uint32 static uiVBO[2];
@@ -47,7 +46,7 @@ void uiInit(game_context *Context)
     glGenVertexArrays(1, &uiVAO);
     glGenBuffers(2, uiVBO);
 
-    glBindVertexArray(uiVAO);
+    GLBindVertexArray(uiVAO);
     glBindBuffer(GL_ARRAY_BUFFER, uiVBO[1]);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ui_vertex), 0);
@@ -55,22 +54,15 @@ void uiInit(game_context *Context)
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ui_vertex), (GLvoid*)sizeof(vec3f));
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 }
 
-void uiReloadShaders(game_memory *Memory, game_context *Context, path ExecFullPath)
+// NOTE - Built from ui_vert.glsl/ui_frag.glsl with the other programs, see ShaderTable
+void uiSetupShader(shader_program *Program)
 {
-    path VSPath, FSPath;
-    MakeRelativePath(VSPath, ExecFullPath, "data/shaders/ui_vert.glsl");
-    MakeRelativePath(FSPath, ExecFullPath, "data/shaders/ui_frag.glsl");
-    uiProgram = BuildShader(Memory, VSPath, FSPath);
-    glUseProgram(uiProgram);
-    SendInt(glGetUniformLocation(uiProgram, "Texture0"), 0);
+    SendInt(GetUniform(Program, UniformName("Texture0")), 0);
 
-    uiProjMatrixUniformLoc = glGetUniformLocation(uiProgram, "ProjMatrix");
-    uiColorUniformLoc = glGetUniformLocation(uiProgram, "Color");
-
-    RegisterShader2D(Context, uiProgram);
+    uiColorUniformLoc = GetUniform(Program, UNIFORM_COLOR);
 }
 
 void uiBeginFrame(game_memory *Memory, game_input *Input)
@@ -144,9 +136,11 @@ void *RenderCmdOffset(uint8 *CmdList, size_t *OffsetAccum, size_t Size)
 
 void uiDraw()
 {
-    glUseProgram(uiProgram);
+    TIMED_FUNCTION();
+
+    GLUseProgram(uiProgram.ID);
 
-    glBindVertexArray(uiVAO);
+    GLBindVertexArray(uiVAO);
     uint8 *Cmd = (uint8*)uiRenderCmd;
     for(uint32 i = 0; i < uiRenderCmdCount; ++i)
     {
@@ -161,14 +155,14 @@ void uiDraw()
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, uiVBO[0]);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, RenderInfo->IndexCount * sizeof(uint16), (GLvoid*)IdxData, GL_STREAM_DRAW);
 
-        glBindTexture(GL_TEXTURE_2D, RenderInfo->TextureID);
+        GLBindTexture(0, GL_TEXTURE_2D, RenderInfo->TextureID);
 
         SendVec4(uiColorUniformLoc, RenderInfo->Color);
         glDrawElements(GL_TRIANGLES, RenderInfo->IndexCount, GL_UNSIGNED_SHORT, 0);
 
         Cmd += Offset;
     }
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 }
 
 #endif
@@ -6,6 +6,7 @@
 #define CONSOLE_STRINGLEN 256
 #define UI_STRINGLEN 256
 #define UI_MAXSTACKOBJECT 256
+#define UI_MAXTEXTLINES 64
 
 typedef char console_log_string[CONSOLE_STRINGLEN];
 struct console_log
@@ -29,10 +30,21 @@ struct ui_text_line
     vec4f   Color;
 };
 
+// NOTE - Text lines live in game_system::UITextLines for as long as their owner
+// keeps them, the frame stack only refers to the ones to show this frame.
+// Handles of freed lines are stale and skipped.
 struct ui_frame_stack
 {
-    ui_text_line TextLines[UI_MAXSTACKOBJECT];
+    pool_handle TextLines[UI_MAXSTACKOBJECT];
     uint32 TextLineCount;
 };
 
+inline void uiPushTextLine(ui_frame_stack *UIStack, pool_handle Line)
+{
+    if(UIStack->TextLineCount < UI_MAXSTACKOBJECT)
+    {
+        UIStack->TextLines[UIStack->TextLineCount++] = Line;
+    }
+}
+
 #endif
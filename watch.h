@@ -0,0 +1,73 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+//////////////////////////////////////////////////////////////////////////
+// NOTE - File watching. Platform side only.
+// A platform thread blocks on the OS notifications (inotify on Linux,
+// ReadDirectoryChangesW on Windows) for a few directories, and pushes the
+// names of the written files in this queue. The main thread drains it at
+// the start of each frame. One producer, one consumer : no lock needed.
+//////////////////////////////////////////////////////////////////////////
+#define WATCH_MAX_DIRECTORIES 4
+#define WATCH_QUEUE_SIZE 64
+#define WATCH_NAME_LENGTH 64
+
+struct file_change
+{
+    uint32 Directory;   // Index in the list given when starting the watcher
+    char Name[WATCH_NAME_LENGTH];
+};
+
+struct file_change_queue
+{
+    int32 volatile Write;   // Watcher thread's end
+    uint8 _Pad0[60];
+    int32 volatile Read;    // Main thread's end
+    uint8 _Pad1[60];
+
+    // NOTE - Set when changes were lost, the consumer must assume anything changed
+    int32 volatile Overflow;
+    file_change Entries[WATCH_QUEUE_SIZE];
+};
+
+// NOTE - Watcher thread only. Names too long for the queue are dropped, none of ours are.
+inline void PushFileChange(file_change_queue *Queue, uint32 Directory, char const *Name)
+{
+    int32 Write = Queue->Write;
+    int32 Read = AtomicLoad32(&Queue->Read);
+    if((uint32)Write - (uint32)Read >= WATCH_QUEUE_SIZE)
+    {
+        AtomicExchange32(&Queue->Overflow, 1);
+        return;
+    }
+
+    if(strlen(Name) >= WATCH_NAME_LENGTH)
+    {
+        return;
+    }
+
+    file_change *Change = &Queue->Entries[Write & (WATCH_QUEUE_SIZE - 1)];
+    Change->Directory = Directory;
+    strcpy(Change->Name, Name);
+
+    // NOTE - Publishes the entry
+    AtomicExchange32(&Queue->Write, (int32)((uint32)Write + 1));
+}
+
+// NOTE - Main thread only
+inline bool PopFileChange(file_change_queue *Queue, file_change *Change)
+{
+    int32 Read = Queue->Read;
+    if(Read == AtomicLoad32(&Queue->Write))
+    {
+        return false;
+    }
+
+    *Change = Queue->Entries[Read & (WATCH_QUEUE_SIZE - 1)];
+
+    // NOTE - Releases the slot to the watcher
+    AtomicExchange32(&Queue->Read, (int32)((uint32)Read + 1));
+    return true;
+}
+
+#endif
@@ -117,10 +117,12 @@ complex FFTW(uint32 X, uint32 N)
     return complex(cosf(V), sinf(V));
 }
 
-void FFTEvaluate(water_system *WS, complex *Input, complex *Output, int Stride, int Offset, int N)
+// NOTE - FFTC is 2 * N work values, ping-ponged between the passes
+void FFTEvaluate(water_system *WS, complex *FFTC, complex *Input, complex *Output, int Stride, int Offset, int N)
 {
+    int Switch = 0;
     for(int i = 0; i < N; ++i)
-        WS->FFTC[WS->Switch][i] = Input[WS->Reversed[i] * Stride + Offset];
+        FFTC[i] = Input[WS->Reversed[i] * Stride + Offset];
 
     int Loops = N >> 1;
     int Size = 2;
@@ -128,11 +130,11 @@ void FFTEvaluate(water_system *WS, complex *Input, complex *Output, int Stride,
     int W_ = 0;
     for(int j = 1; j <= WS->Log2N; ++j)
     {
-        WS->Switch ^= 1;
+        Switch ^= 1;
         for(int i = 0; i < Loops; ++i)
         {
-            complex *FFTCDst = WS->FFTC[WS->Switch];
-            complex *FFTCSrc = WS->FFTC[WS->Switch^1];
+            complex *FFTCDst = FFTC + Switch * N;
+            complex *FFTCSrc = FFTC + (Switch^1) * N;
             for(int k = 0; k < SizeOver2; ++k)
             {
                 FFTCDst[Size * i + k] = FFTCSrc[Size * i + k] +
@@ -151,50 +153,75 @@ void FFTEvaluate(water_system *WS, complex *Input, complex *Output, int Stride,
     }
 
     for(int i = 0; i < N; ++i)
-        Output[i * Stride + Offset] = WS->FFTC[WS->Switch][i];
+        Output[i * Stride + Offset] = FFTC[Switch * N + i];
+}
+
+struct water_fft_job
+{
+    water_system *WaterSystem;
+    complex *Buffers[5];
+    int Stride;         // Between the values of a line
+    int LineStep;       // Between the first values of 2 lines
+};
+
+// NOTE - Lines are independent, run in parallel, each thread with its own work values
+void WaterFFTLines(void *Data, uint32 Start, uint32 End, memory_arena *Scratch)
+{
+    TIMED_BLOCK("Water FFT Lines");
+    water_fft_job *Job = (water_fft_job*)Data;
+    int N = water_system::WaterN;
+    complex *FFTC = (complex*)PushArenaData(Scratch, 2 * N * sizeof(complex));
+
+    for(uint32 Line = Start; Line < End; ++Line)
+    {
+        for(int b = 0; b < 5; ++b)
+        {
+            FFTEvaluate(Job->WaterSystem, FFTC, Job->Buffers[b], Job->Buffers[b], Job->Stride, Line * Job->LineStep, N);
+        }
+    }
 }
 
 void UpdateWaterMesh(water_system *WaterSystem)
 {
-    glBindVertexArray(WaterSystem->VAO);
+    TIMED_BLOCK("Water Upload");
+    GLBindVertexArray(WaterSystem->VAO);
     size_t VertSize = WaterSystem->VertexCount * sizeof(real32);
     UpdateVBO(WaterSystem->VBO[1], 0, VertSize, WaterSystem->VertexData);
     UpdateVBO(WaterSystem->VBO[1], VertSize, VertSize, WaterSystem->VertexData + WaterSystem->VertexCount);
 
-    glBindVertexArray(0);
+    GLBindVertexArray(0);
 }
 
-void UpdateWater(game_state *State, game_system *System, game_input *Input, uint32 WaterState, real32 WaterInterp)
+struct water_prepare_job
 {
-    water_beaufort_state *WStateA = &System->WaterSystem->States[WaterState];
-    water_beaufort_state *WStateB = &System->WaterSystem->States[WaterState + 1];
-
-    State->WaterCounter += Input->dTime;
-
-    vec3f *WaterPositions = (vec3f*)System->WaterSystem->Positions;
-    vec3f *WaterNormals = (vec3f*)System->WaterSystem->Normals;
-
-    vec3f *WaterOrigPositionsA = (vec3f*)WStateA->OrigPositions;
-    vec3f *WaterOrigPositionsB = (vec3f*)WStateB->OrigPositions;
-
-    real32 dT = (real32)State->WaterCounter;
+    water_beaufort_state *WStateA;
+    water_beaufort_state *WStateB;
+    real32 WaterInterp;
+    real32 dT;
+    real32 dWidth;
+
+    complex *hT;
+    complex *hTSX;
+    complex *hTSZ;
+    complex *hTDX;
+    complex *hTDZ;
+};
 
+// NOTE - Rows are independent, run in parallel
+void WaterPrepareRows(void *Data, uint32 Start, uint32 End, memory_arena *Scratch)
+{
+    TIMED_BLOCK("Water Prepare Rows");
+    water_prepare_job *Job = (water_prepare_job*)Data;
     int N = water_system::WaterN;
-    int NPlus1 = N+1;
-
-    float Lambda = -1.0f;
-
-    water_system *WaterSystem = System->WaterSystem;
-    complex *hT = (complex*)WaterSystem->hTilde;
-    complex *hTSX = (complex*)WaterSystem->hTildeSlopeX;
-    complex *hTSZ = (complex*)WaterSystem->hTildeSlopeZ;
-    complex *hTDX = (complex*)WaterSystem->hTildeDX;
-    complex *hTDZ = (complex*)WaterSystem->hTildeDZ;
+    real32 dWidth = Job->dWidth;
 
-    real32 dWidth = Mix((real32)WStateA->Width, (real32)WStateB->Width, WaterInterp);
+    complex *hT = Job->hT;
+    complex *hTSX = Job->hTSX;
+    complex *hTSZ = Job->hTSZ;
+    complex *hTDX = Job->hTDX;
+    complex *hTDZ = Job->hTDZ;
 
-    // Prepare
-    for(int m_prime = 0; m_prime < N; ++m_prime)
+    for(int m_prime = (int)Start; m_prime < (int)End; ++m_prime)
     {
         real32 Kz = M_PI * (2.f * m_prime - N) / dWidth;
         for(int n_prime = 0; n_prime < N; ++n_prime)
@@ -203,7 +230,7 @@ void UpdateWater(game_state *State, game_system *System, game_input *Input, uint
             real32 Len = sqrtf(Square(Kx) + Square(Kz));
             int Idx = m_prime * N + n_prime;
 
-            hT[Idx] = ComputeHTilde(WStateA, WStateB, WaterInterp, dT, n_prime, m_prime);
+            hT[Idx] = ComputeHTilde(Job->WStateA, Job->WStateB, Job->WaterInterp, Job->dT, n_prime, m_prime);
             hTSX[Idx] = hT[Idx] * complex(0, Kx);
             hTSZ[Idx] = hT[Idx] * complex(0, Kz);
             if(Len < 1e-6f)
@@ -216,83 +243,129 @@ void UpdateWater(game_state *State, game_system *System, game_input *Input, uint
             }
         }
     }
+}
 
-    // Evaluate
-    for(int m_prime = 0; m_prime < N; ++m_prime)
+void UpdateWater(job_system_api *JobSystem, memory_arena *Scratch, game_state *State, game_system *System, game_input *Input, uint32 WaterState, real32 WaterInterp)
+{
+    TIMED_FUNCTION();
+
+    // NOTE - WaterCounter advances with the fixed steps. The surface is evaluated
+    // between the last 2 steps at Alpha, like the camera is interpolated, so that it
+    // moves smoothly above the simulation rate. Only skipped when that time
+    // didn't move, and always done once at the start to fill the mesh.
+    State->WaterCounter += Input->FixedStepCount * Input->dTimeFixed;
+    real64 RenderTime = Max(State->WaterCounter - (1.0 - Input->Alpha) * Input->dTimeFixed, 0.0);
+    if(!Input->FixedStepCount && RenderTime == System->WaterSystem->EvaluatedTime)
     {
-        FFTEvaluate(WaterSystem, hT, hT, 1, m_prime * N, N);
-        FFTEvaluate(WaterSystem, hTSX, hTSX, 1, m_prime * N, N);
-        FFTEvaluate(WaterSystem, hTSZ, hTSZ, 1, m_prime * N, N);
-        FFTEvaluate(WaterSystem, hTDX, hTDX, 1, m_prime * N, N);
-        FFTEvaluate(WaterSystem, hTDZ, hTDZ, 1, m_prime * N, N);
+        return;
     }
+    System->WaterSystem->EvaluatedTime = RenderTime;
 
-    for(int n_prime = 0; n_prime < N; ++n_prime)
-    {
-        FFTEvaluate(WaterSystem, hT, hT, N, n_prime, N);
-        FFTEvaluate(WaterSystem, hTSX, hTSX, N, n_prime, N);
-        FFTEvaluate(WaterSystem, hTSZ, hTSZ, N, n_prime, N);
-        FFTEvaluate(WaterSystem, hTDX, hTDX, N, n_prime, N);
-        FFTEvaluate(WaterSystem, hTDZ, hTDZ, N, n_prime, N);
-    }
+    water_beaufort_state *WStateA = &System->WaterSystem->States[WaterState];
+    water_beaufort_state *WStateB = &System->WaterSystem->States[WaterState + 1];
 
-    // Fill results
-    float Signs[] = { 1.f, -1.f };
-    for(int m_prime = 0; m_prime < N; ++m_prime)
-    {
-        for(int n_prime = 0; n_prime < N; ++n_prime)
-        {
-            int Idx = m_prime * N + n_prime;        // for htilde
-            int Idx1 = m_prime * NPlus1 + n_prime;  // for vertices
+    vec3f *WaterPositions = (vec3f*)System->WaterSystem->Positions;
+    vec3f *WaterNormals = (vec3f*)System->WaterSystem->Normals;
+
+    vec3f *WaterOrigPositionsA = (vec3f*)WStateA->OrigPositions;
+    vec3f *WaterOrigPositionsB = (vec3f*)WStateB->OrigPositions;
 
-            int Sign = Signs[(n_prime + m_prime) & 1];
+    real32 dT = (real32)RenderTime;
 
-            hT[Idx] = hT[Idx] * Sign;
-            WaterPositions[Idx1].y = hT[Idx].r;
+    int N = water_system::WaterN;
+    int NPlus1 = N+1;
 
-            hTDX[Idx] = hTDX[Idx] * Sign;
-            hTDZ[Idx] = hTDZ[Idx] * Sign;
-            {
-                vec3f OP = Mix(WaterOrigPositionsA[Idx1], WaterOrigPositionsB[Idx1], WaterInterp);
-                WaterPositions[Idx1].x = OP.x + Lambda * hTDX[Idx].r;
-                WaterPositions[Idx1].z = OP.z + Lambda * hTDZ[Idx].r;
-            }
+    float Lambda = -1.0f;
 
-            hTSX[Idx] = hTSX[Idx] * Sign;
-            hTSZ[Idx] = hTSZ[Idx] * Sign;
-            vec3f Normal = Normalize(vec3f(-hTSX[Idx].r, 1, -hTSZ[Idx].r));
+    water_system *WaterSystem = System->WaterSystem;
+    complex *hT = (complex*)WaterSystem->hTilde;
+    complex *hTSX = (complex*)WaterSystem->hTildeSlopeX;
+    complex *hTSZ = (complex*)WaterSystem->hTildeSlopeZ;
+    complex *hTDX = (complex*)WaterSystem->hTildeDX;
+    complex *hTDZ = (complex*)WaterSystem->hTildeDZ;
 
-            WaterNormals[Idx1] = Normal;
+    real32 dWidth = Mix((real32)WStateA->Width, (real32)WStateB->Width, WaterInterp);
 
-            if(n_prime == 0 && m_prime == 0)
-            {
-                vec3f OP = Mix(WaterOrigPositionsA[Idx1 + N + NPlus1 * N], WaterOrigPositionsB[Idx1 + N + NPlus1 * N], WaterInterp);
-                WaterPositions[Idx1 + N + NPlus1 * N].x = OP.x + Lambda * hTDX[Idx].r;
-                WaterPositions[Idx1 + N + NPlus1 * N].y = hT[Idx].r;
-                WaterPositions[Idx1 + N + NPlus1 * N].z = OP.z + Lambda * hTDZ[Idx].r;
+    // Prepare
+    {
+        TIMED_BLOCK("Water Prepare");
+        water_prepare_job PrepareJob = { WStateA, WStateB, WaterInterp, dT, dWidth, hT, hTSX, hTSZ, hTDX, hTDZ };
+        ParallelFor(JobSystem, N, 4, WaterPrepareRows, &PrepareJob, Scratch);
+    }
 
-                WaterNormals[Idx1 + N + NPlus1 * N] = Normal;
-            }
-            if(n_prime == 0)
-            {
-                vec3f OP = Mix(WaterOrigPositionsA[Idx1 + N], WaterOrigPositionsB[Idx1 + N], WaterInterp);
-                WaterPositions[Idx1 + N].x = OP.x + Lambda * hTDX[Idx].r;
-                WaterPositions[Idx1 + N].y = hT[Idx].r;
-                WaterPositions[Idx1 + N].z = OP.z + Lambda * hTDZ[Idx].r;
+    // Evaluate
+    {
+        TIMED_BLOCK("Water FFT");
+        water_fft_job FFTJob = { WaterSystem, { hT, hTSX, hTSZ, hTDX, hTDZ }, 1, N };
+        ParallelFor(JobSystem, N, 4, WaterFFTLines, &FFTJob, Scratch);
+
+        // NOTE - Columns once all the rows are done
+        FFTJob.Stride = N;
+        FFTJob.LineStep = 1;
+        ParallelFor(JobSystem, N, 4, WaterFFTLines, &FFTJob, Scratch);
+    }
 
-                WaterNormals[Idx1 + N] = Normal;
-            }
-            if(m_prime == 0)
+    // Fill results
+    {
+        TIMED_BLOCK("Water Fill");
+        float Signs[] = { 1.f, -1.f };
+        for(int m_prime = 0; m_prime < N; ++m_prime)
+        {
+            for(int n_prime = 0; n_prime < N; ++n_prime)
             {
-                vec3f OP = Mix(WaterOrigPositionsA[Idx1 + NPlus1 * N], WaterOrigPositionsB[Idx1 + NPlus1 * N], WaterInterp);
-                WaterPositions[Idx1 + NPlus1 * N].x = OP.x + Lambda * hTDX[Idx].r;
-                WaterPositions[Idx1 + NPlus1 * N].y = hT[Idx].r;
-                WaterPositions[Idx1 + NPlus1 * N].z = OP.z + Lambda * hTDZ[Idx].r;
-
-                WaterNormals[Idx1 + NPlus1 * N] = Normal;
+                int Idx = m_prime * N + n_prime;        // for htilde
+                int Idx1 = m_prime * NPlus1 + n_prime;  // for vertices
+
+                int Sign = Signs[(n_prime + m_prime) & 1];
+
+                hT[Idx] = hT[Idx] * Sign;
+                WaterPositions[Idx1].y = hT[Idx].r;
+
+                hTDX[Idx] = hTDX[Idx] * Sign;
+                hTDZ[Idx] = hTDZ[Idx] * Sign;
+                {
+                    vec3f OP = Mix(WaterOrigPositionsA[Idx1], WaterOrigPositionsB[Idx1], WaterInterp);
+                    WaterPositions[Idx1].x = OP.x + Lambda * hTDX[Idx].r;
+                    WaterPositions[Idx1].z = OP.z + Lambda * hTDZ[Idx].r;
+                }
+
+                hTSX[Idx] = hTSX[Idx] * Sign;
+                hTSZ[Idx] = hTSZ[Idx] * Sign;
+                vec3f Normal = Normalize(vec3f(-hTSX[Idx].r, 1, -hTSZ[Idx].r));
+
+                WaterNormals[Idx1] = Normal;
+
+                if(n_prime == 0 && m_prime == 0)
+                {
+                    vec3f OP = Mix(WaterOrigPositionsA[Idx1 + N + NPlus1 * N], WaterOrigPositionsB[Idx1 + N + NPlus1 * N], WaterInterp);
+                    WaterPositions[Idx1 + N + NPlus1 * N].x = OP.x + Lambda * hTDX[Idx].r;
+                    WaterPositions[Idx1 + N + NPlus1 * N].y = hT[Idx].r;
+                    WaterPositions[Idx1 + N + NPlus1 * N].z = OP.z + Lambda * hTDZ[Idx].r;
+
+                    WaterNormals[Idx1 + N + NPlus1 * N] = Normal;
+                }
+                if(n_prime == 0)
+                {
+                    vec3f OP = Mix(WaterOrigPositionsA[Idx1 + N], WaterOrigPositionsB[Idx1 + N], WaterInterp);
+                    WaterPositions[Idx1 + N].x = OP.x + Lambda * hTDX[Idx].r;
+                    WaterPositions[Idx1 + N].y = hT[Idx].r;
+                    WaterPositions[Idx1 + N].z = OP.z + Lambda * hTDZ[Idx].r;
+
+                    WaterNormals[Idx1 + N] = Normal;
+                }
+                if(m_prime == 0)
+                {
+                    vec3f OP = Mix(WaterOrigPositionsA[Idx1 + NPlus1 * N], WaterOrigPositionsB[Idx1 + NPlus1 * N], WaterInterp);
+                    WaterPositions[Idx1 + NPlus1 * N].x = OP.x + Lambda * hTDX[Idx].r;
+                    WaterPositions[Idx1 + NPlus1 * N].y = hT[Idx].r;
+                    WaterPositions[Idx1 + NPlus1 * N].z = OP.z + Lambda * hTDZ[Idx].r;
+
+                    WaterNormals[Idx1 + NPlus1 * N] = Normal;
+                }
             }
         }
     }
+
     UpdateWaterMesh(WaterSystem);
 }
 
@@ -367,10 +440,8 @@ void WaterInitialization(game_memory *Memory, game_state *State, game_system *Sy
     WaterSystem->hTildeDX = (complex*)PushArenaData(&Memory->SessionArena, N * N * sizeof(complex));
     WaterSystem->hTildeDZ = (complex*)PushArenaData(&Memory->SessionArena, N * N * sizeof(complex));
 
-    WaterSystem->Switch = 0;
     WaterSystem->Log2N = log(N) / log(2);
-    WaterSystem->FFTC[0] = (complex*)PushArenaData(&Memory->SessionArena, N * sizeof(complex));
-    WaterSystem->FFTC[1] = (complex*)PushArenaData(&Memory->SessionArena, N * sizeof(complex));
+    WaterSystem->EvaluatedTime = -1.0;
     WaterSystem->Reversed = (uint32*)PushArenaData(&Memory->SessionArena, N * sizeof(uint32));
     for(int i = 0; i < N; ++i)
     {
@@ -425,5 +496,8 @@ void WaterInitialization(game_memory *Memory, game_state *State, game_system *Sy
         }
     }
     WaterSystem->IndexCount = IndexCount;
+
+    // NOTE - Cache order only : the FFT writes the vertices in grid order
+    OptimizeMeshIndices("Water", Indices, IndexCount, Square(NPlus1), NULL, &Memory->ScratchArena);
 }
 
@@ -25,6 +25,7 @@ struct water_system
     uint32 *IndexData;
 
     water_beaufort_state States[BeaufortStateCount];
+    real64 EvaluatedTime;   // Water time the mesh was last computed at, see UpdateWater
 
     // NOTE - Accessor Pointers, index VertexData
     void *Positions;
@@ -37,14 +38,13 @@ struct water_system
     complex *hTildeDZ;
 
     // NOTE - FFT system
-    int Switch;
     int Log2N;
-    complex *FFTC[2];
     complex **FFTW;
     uint32 *Reversed;
 
     uint32 VAO;
     uint32 VBO[2]; // 0 : idata, 1 : vdata
+    uint32 IndexType;   // Of the index VBO, see MakeIndexBuffer
 };
 
 #endif